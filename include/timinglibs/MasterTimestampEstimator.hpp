@@ -0,0 +1,157 @@
+/**
+ * @file MasterTimestampEstimator.hpp
+ *
+ * MasterTimestampEstimator fits the relation between the host steady clock
+ * and the timing master timestamp, from the master timestamps gathered
+ * periodically by the hardware manager, and predicts the current 62.5 MHz
+ * timestamp without reading the hardware.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_MASTERTIMESTAMPESTIMATOR_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_MASTERTIMESTAMPESTIMATOR_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Linear fit, over a sliding window of samples, of the master
+ * timestamp against the host steady clock. The fitted slope tracks the
+ * drift between the two clocks.
+ *
+ * Samples are added by one thread (the controller receiving device info);
+ * estimate() is lock free and may be called from any thread. Samples are
+ * taken at the arrival of the device info, so estimates lag the hardware
+ * by the mean gather and delivery latency; the error bound covers the
+ * jitter of that latency and the uncertainty of the fit.
+ */
+class MasterTimestampEstimator
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  struct Estimate
+  {
+    bool valid = false;
+    uint64_t timestamp = 0; // NOLINT(build/unsigned)
+    uint64_t error = 0;     ///< Error bound, in timestamp ticks. NOLINT(build/unsigned)
+  };
+
+  static constexpr double s_nominal_clock_frequency = 62.5e6; ///< Master timestamp ticks per second
+  static constexpr size_t s_default_window = 32;
+  static constexpr size_t s_default_min_samples = 4;
+
+  /**
+   * @param window Number of most recent samples used in the fit
+   * @param min_samples Number of samples needed before estimates are valid
+   * @param max_extrapolation Estimates further than this from the last sample are not valid
+   */
+  explicit MasterTimestampEstimator(size_t window = s_default_window,
+                                    size_t min_samples = s_default_min_samples,
+                                    clock_t::duration max_extrapolation = std::chrono::seconds(60));
+
+  MasterTimestampEstimator(const MasterTimestampEstimator&) = delete; ///< MasterTimestampEstimator is not copy-constructible
+  MasterTimestampEstimator& operator=(const MasterTimestampEstimator&) =
+    delete; ///< MasterTimestampEstimator is not copy-assignable
+  MasterTimestampEstimator(MasterTimestampEstimator&&) = delete; ///< MasterTimestampEstimator is not move-constructible
+  MasterTimestampEstimator& operator=(MasterTimestampEstimator&&) =
+    delete; ///< MasterTimestampEstimator is not move-assignable
+
+  /**
+   * @brief Add a master timestamp, read at (about) the given host time. A
+   * sample inconsistent with the current fit (e.g. after the master
+   * timestamp was set) restarts the fit.
+   */
+  void add_sample(uint64_t timestamp, clock_t::time_point arrival); // NOLINT(build/unsigned)
+
+  /**
+   * @brief Forget all samples, e.g. when the master is no longer ready
+   */
+  void reset();
+
+  /**
+   * @brief Predict the master timestamp at the given host time
+   */
+  Estimate estimate(clock_t::time_point when = clock_t::now()) const;
+
+  /**
+   * @brief Fitted master clock frequency in Hz, 0 while there is no valid fit
+   */
+  double get_clock_frequency() const;
+
+  /**
+   * @brief Make the estimator available to other modules of this process,
+   * under the timing device name
+   */
+  static void publish(const std::string& device, std::shared_ptr<const MasterTimestampEstimator> estimator);
+  static void withdraw(const std::string& device);
+
+  /**
+   * @brief Estimator published for the device, nullptr if there is none
+   */
+  static std::shared_ptr<const MasterTimestampEstimator> find(const std::string& device);
+
+private:
+  struct Sample
+  {
+    int64_t host_ns;
+    uint64_t timestamp; // NOLINT(build/unsigned)
+  };
+
+  struct Model
+  {
+    bool valid = false;
+    int64_t anchor_ns = 0;
+    uint64_t anchor_timestamp = 0; // NOLINT(build/unsigned)
+    double slope = 0;
+    double residual = 0;
+    double slope_error = 0;
+    int64_t last_sample_ns = 0;
+  };
+
+  void fit();
+  void store_model(const Model& model);
+  Model load_model() const;
+  static int64_t to_ns(clock_t::time_point time);
+
+  static constexpr double s_max_frequency_offset = 1e-3;       ///< Restart the fit beyond this relative offset
+  static constexpr double s_max_arrival_jitter_ticks = 6.25e6; ///< and this much arrival jitter (100 ms)
+
+  const size_t m_window;
+  const size_t m_min_samples;
+  const int64_t m_max_extrapolation_ns;
+
+  // writer side
+  std::mutex m_samples_mutex;
+  std::deque<Sample> m_samples;
+
+  // fitted model, published with a sequence lock: odd while being written
+  std::atomic<uint64_t> m_model_sequence{ 0 }; // NOLINT(build/unsigned)
+  std::atomic<bool> m_model_valid{ false };
+  std::atomic<int64_t> m_anchor_ns{ 0 };          ///< Host time of the fit centre
+  std::atomic<uint64_t> m_anchor_timestamp{ 0 };  ///< Fitted timestamp at the fit centre. NOLINT(build/unsigned)
+  std::atomic<double> m_slope{ 0 };               ///< Ticks per host ns
+  std::atomic<double> m_residual{ 0 };            ///< Largest absolute fit residual, in ticks
+  std::atomic<double> m_slope_error{ 0 };         ///< Standard error of the slope
+  std::atomic<int64_t> m_last_sample_ns{ 0 };
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_MASTERTIMESTAMPESTIMATOR_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -14,6 +14,7 @@
 
 #include "timinglibs/timingcmd/Structs.hpp"
 #include "timinglibs/TimingIssues.hpp"
+#include "timinglibs/TimingControllerHwCmds.hpp"
 
 #include "timinglibs/dal/TimingControllerConf.hpp"
 #include "timinglibs/dal/TimingController.hpp"
@@ -28,6 +29,10 @@
 #include "appfwk/ModuleConfiguration.hpp"
 #include "confmodel/Connection.hpp"
 
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -85,7 +90,7 @@ public:
    * @brief TimingController Constructor
    * @param name Instance name for this TimingController instance
    */
-  explicit TimingController(const std::string& name, uint number_hw_commands);
+  explicit TimingController(const std::string& name);
 
   TimingController(const TimingController&) = delete;            ///< TimingController is not copy-constructible
   TimingController& operator=(const TimingController&) = delete; ///< TimingController is not copy-assignable
@@ -113,13 +118,35 @@ protected:
   std::string m_timing_session_name;
   using source_t = dunedaq::iomanager::ReceiverConcept<nlohmann::json>;
   std::shared_ptr<source_t> m_device_info_receiver;
+  std::shared_ptr<source_t> m_link_event_receiver; ///< null unless receive_link_events is set
+
+  // hardware managers of the devices with a route in the configuration, see TimingDeviceRoute
+  struct HwCmdRoute
+  {
+    std::string connection;
+    std::shared_ptr<sink_t> sender;
+  };
+  std::map<std::string, HwCmdRoute> m_hw_command_routes;
+  std::shared_ptr<sink_t> get_hw_command_sender(const std::string& connection) const;
 
   virtual void send_hw_cmd(timingcmd::TimingHwCmd&& hw_cmd);
   virtual void send_configure_hardware_commands(const nlohmann::json& data) = 0;
 
+  // hardware commands, see s_controller_hw_cmds
+  template<typename Child>
+  void register_hw_command(ControllerHwCmd cmd, void (Child::*f)(const nlohmann::json&));
+  void send_hw_cmd(ControllerHwCmd cmd, const nlohmann::json& payload = nlohmann::json());
+
   // opmon
-  uint m_number_hw_commands;
-  std::vector<AtomicUInt64> m_sent_hw_command_counters;
+  void generate_opmon_data() override;
+
+  // commands are sent from the command thread and from e.g. the endpoint scan thread: a cache line per counter
+  struct alignas(64) SentHwCmdCounter
+  {
+    std::atomic<uint64_t> value{ 0 }; // NOLINT(build/unsigned)
+  };
+  std::array<SentHwCmdCounter, s_number_of_controller_hw_cmds> m_sent_hw_command_counters;
+  std::bitset<s_number_of_controller_hw_cmds> m_registered_hw_commands;
 
   // Interpert device opmon info
   virtual void process_device_info(nlohmann::json /*message*/) = 0;
@@ -128,11 +155,23 @@ protected:
   std::atomic<uint> m_device_infos_received_count;
   std::atomic<bool> m_hardware_state_recovery_enabled;
 
+  // configuration fingerprint, compared with the one the hardware manager recorded for the device
+  virtual nlohmann::json get_config_fingerprint_components() const;
+  void receive_device_info(nlohmann::json info);
+
+  // link state changes sent by the link watchdog of the hardware manager, ahead of the next device info
+  virtual void process_link_event(nlohmann::json event);
+  std::string m_config_fingerprint; ///< empty unless skip_unchanged_configuration is set
+  std::atomic<bool> m_device_config_fingerprint_matches;
+  std::atomic<bool> m_device_config_fingerprint_checked; ///< a device info was processed since the fingerprint check started
+
   //common commands
   timingcmd::TimingHwCmd construct_hw_cmd( const std::string& cmd_id);
   timingcmd::TimingHwCmd construct_hw_cmd( const std::string& cmd_id, const nlohmann::json& payload);
   virtual void do_io_reset(const nlohmann::json& data);
   virtual void do_print_status(const nlohmann::json& data);
+  virtual void do_register_watchpoints(const nlohmann::json& data);
+  virtual void do_unregister_watchpoints(const nlohmann::json& data);
   const dal::TimingControllerConf* m_params;
 
 };
@@ -0,0 +1,121 @@
+/**
+ * @file TimingControllerHwCmds.hpp
+ *
+ * Table of the hardware commands sent by the timing controller modules: the
+ * DAQModule command each one is registered under, and the id of the
+ * TimingHwCmd sent to the hardware manager. The table drives command
+ * registration, the sent command counters and their opmon publication.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMINGCONTROLLERHWCMDS_HPP_
+#define TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMINGCONTROLLERHWCMDS_HPP_
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Hardware commands sent by controllers; the value indexes the descriptor table and the counters
+ */
+enum class ControllerHwCmd : size_t
+{
+  kIOReset,
+  kPrintStatus,
+  kRecordConfigFingerprint,
+  kRegisterWatchpoints,
+  kUnregisterWatchpoints,
+  kMasterSetTimestamp,
+  kMasterSetEndpointDelay,
+  kMasterSetEndpointDelays,
+  kMasterSendFLCommand,
+  kMasterStartFLCommandSequence,
+  kMasterStopFLCommandSequence,
+  kMasterMeasureEndpointRTT,
+  kMasterEndpointScan,
+  kMasterDefineEndpointScanSet,
+  kMasterUpdateEndpointScanSet,
+  kEndpointEnable,
+  kEndpointDisable,
+  kEndpointReset,
+  kNumberOfCommands
+};
+
+struct ControllerHwCmdDescriptor
+{
+  ControllerHwCmd cmd;
+  std::string_view module_command; ///< Name of the DAQModule command sending it, empty if only sent internally
+  std::string_view hw_cmd_id;      ///< Id of the TimingHwCmd handled by the hardware manager
+};
+
+inline constexpr size_t s_number_of_controller_hw_cmds = static_cast<size_t>(ControllerHwCmd::kNumberOfCommands);
+
+inline constexpr std::array<ControllerHwCmdDescriptor, s_number_of_controller_hw_cmds> s_controller_hw_cmds{ {
+  { ControllerHwCmd::kIOReset, "io_reset", "io_reset" },
+  { ControllerHwCmd::kPrintStatus, "print_status", "print_status" },
+  { ControllerHwCmd::kRecordConfigFingerprint, "", "record_config_fingerprint" },
+  { ControllerHwCmd::kRegisterWatchpoints, "register_watchpoints", "register_watchpoints" },
+  { ControllerHwCmd::kUnregisterWatchpoints, "unregister_watchpoints", "unregister_watchpoints" },
+  { ControllerHwCmd::kMasterSetTimestamp, "master_set_timestamp", "set_timestamp" },
+  { ControllerHwCmd::kMasterSetEndpointDelay, "master_set_endpoint_delay", "set_endpoint_delay" },
+  { ControllerHwCmd::kMasterSetEndpointDelays, "master_set_endpoint_delays", "set_endpoint_delays" },
+  { ControllerHwCmd::kMasterSendFLCommand, "master_send_fl_command", "send_fl_command" },
+  { ControllerHwCmd::kMasterStartFLCommandSequence, "master_start_fl_command_sequence", "start_fl_command_sequence" },
+  { ControllerHwCmd::kMasterStopFLCommandSequence, "master_stop_fl_command_sequence", "stop_fl_command_sequence" },
+  { ControllerHwCmd::kMasterMeasureEndpointRTT, "master_measure_endpoint_rtt", "master_measure_endpoint_rtt" },
+  { ControllerHwCmd::kMasterEndpointScan, "master_endpoint_scan", "master_endpoint_scan" },
+  { ControllerHwCmd::kMasterDefineEndpointScanSet, "", "define_endpoint_scan_set" },
+  { ControllerHwCmd::kMasterUpdateEndpointScanSet, "master_update_endpoint_scan_set", "update_endpoint_scan_set" },
+  { ControllerHwCmd::kEndpointEnable, "endpoint_enable", "endpoint_enable" },
+  { ControllerHwCmd::kEndpointDisable, "endpoint_disable", "endpoint_disable" },
+  { ControllerHwCmd::kEndpointReset, "endpoint_reset", "endpoint_reset" },
+} };
+
+constexpr size_t
+to_index(ControllerHwCmd cmd)
+{
+  return static_cast<size_t>(cmd);
+}
+
+constexpr const ControllerHwCmdDescriptor&
+describe(ControllerHwCmd cmd)
+{
+  return s_controller_hw_cmds[to_index(cmd)];
+}
+
+namespace detail {
+constexpr bool
+controller_hw_cmds_are_well_formed()
+{
+  for (size_t i = 0; i < s_controller_hw_cmds.size(); ++i) {
+    if (to_index(s_controller_hw_cmds[i].cmd) != i) {
+      return false;
+    }
+    for (size_t j = 0; j < i; ++j) {
+      if (!s_controller_hw_cmds[i].module_command.empty() &&
+          s_controller_hw_cmds[i].module_command == s_controller_hw_cmds[j].module_command) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+} // namespace detail
+
+static_assert(detail::controller_hw_cmds_are_well_formed(),
+              "s_controller_hw_cmds must list every ControllerHwCmd once, in enum order, with unique module commands");
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMINGCONTROLLERHWCMDS_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -40,7 +40,7 @@ public:
    * @brief TimingEndpointControllerBase Constructor
    * @param name Instance name for this TimingEndpointControllerBase instance
    */
-  explicit TimingEndpointControllerBase(const std::string& name, uint number_hw_commands);
+  explicit TimingEndpointControllerBase(const std::string& name);
 
   TimingEndpointControllerBase(const TimingEndpointControllerBase&) =
     delete; ///< TimingEndpointControllerBase is not copy-constructible
@@ -56,6 +56,7 @@ protected:
   // Commands
   void do_configure(const nlohmann::json& data) override;
   void send_configure_hardware_commands(const nlohmann::json& data) override;
+  nlohmann::json get_config_fingerprint_components() const override;
 
   timingcmd::TimingHwCmd construct_endpoint_hw_cmd(const std::string& cmd_id, uint endpoint_id);
 
@@ -17,6 +17,7 @@
 #include "uhal/utilities/files.hpp"
 #include <ers/Issue.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -42,11 +43,19 @@ public:
   TimingHardwareInterface& operator=(TimingHardwareInterface&&) = delete;      ///< TimingHardwareInterface is not move-assignable
 
 protected:
-  void configure_uhal(const dunedaq::timinglibs::dal::TimingHardwareInterfaceConf* mdal);
-  void configure_uhal(const std::string& uhal_log_level, const std::string& connections_file);
+  /**
+   * @brief Set up the uhal connection manager. The connection manager of the previous configuration is
+   * kept if the content of the connections file and of its address tables did not change.
+   * @return true if a new connection manager was created
+   */
+  bool configure_uhal(const dunedaq::timinglibs::dal::TimingHardwareInterfaceConf* mdal);
+  bool configure_uhal(const std::string& uhal_log_level, const std::string& connections_file);
 
+  // keeps the connection manager for the next configure_uhal
   void scrap_uhal ();
   std::string m_connections_file;
+  // of the connections file and of the address tables it refers to
+  uint64_t m_connections_file_hash; // NOLINT(build/unsigned)
   std::string m_uhal_log_level;
   std::unique_ptr<uhal::ConnectionManager> m_connection_manager;
 };
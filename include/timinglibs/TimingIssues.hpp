@@ -83,6 +83,42 @@ ERS_DECLARE_ISSUE(timinglibs,
                   " Failed to collect op mon info from device: " << device_name,
                   ((std::string)device_name))
 
+ERS_DECLARE_ISSUE(timinglibs,
+                  FailedToPrepareDevice,
+                  " Failed to prepare device: " << device_name << ", it will be retried at its first use",
+                  ((std::string)device_name))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  HSIBufferReadFailed,
+                  " Failed to read the HSI buffer of device: " << device_name,
+                  ((std::string)device_name))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  HSIBufferOccupancyHigh,
+                  " HSI buffer of device " << device_name << " holds " << occupancy
+                                           << " words, above the warning threshold of " << threshold,
+                  ((std::string)device_name)((uint32_t)occupancy)((uint32_t)threshold)) // NOLINT(build/unsigned)
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  InvalidFakeHSIConfiguration,
+                  " Invalid configuration of fake HSI event generator " << module_name << ": " << reason,
+                  ((std::string)module_name)((std::string)reason))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  InvalidFLCmdSchedule,
+                  " Invalid fixed length command schedule on channel " << channel << ": " << reason,
+                  ((uint32_t)channel)((std::string)reason)) // NOLINT(build/unsigned)
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  FLCmdSequenceFailed,
+                  " Fixed length command sequence on " << device_name << " stopped after a failed write",
+                  ((std::string)device_name))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  LinkWatchdogIssue,
+                  " Link watchdog of " << device_name << ": " << message,
+                  ((std::string)device_name)((std::string)message))
+
 ERS_DECLARE_ISSUE(timinglibs, HardwareCommandIssue, " Issue wih hw cmd id: " << hw_cmd_id, ((std::string)hw_cmd_id))
 
 ERS_DECLARE_ISSUE_BASE(timinglibs,
@@ -129,6 +165,66 @@ ERS_DECLARE_ISSUE(timinglibs,
                   ((uint64_t)n_threads)) // NOLINT(build/unsigned)
 
 ERS_DECLARE_ISSUE(timinglibs, EndpointScanFailure, " Endpoint scan failed!!", ERS_EMPTY)
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  UnknownEndpointScanSet,
+                  " Endpoint scan set " << scan_set << " is not defined for device: " << device_name,
+                  ((std::string)device_name)((std::string)scan_set))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  IOResetInProgress,
+                  " An io reset of device " << device_name << " is already in progress",
+                  ((std::string)device_name))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  InvalidWatchpoint,
+                  " Watchpoint " << watchpoint_id << " of device " << device_name << " is invalid: " << reason,
+                  ((std::string)device_name)((std::string)watchpoint_id)((std::string)reason))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  WatchpointReadFailed,
+                  " Reading the watchpoint registers of device " << device_name << " failed: " << failure,
+                  ((std::string)device_name)((std::string)failure))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  InvalidThreadPlacement,
+                  " Thread placement of role " << role << " is invalid: " << reason,
+                  ((std::string)role)((std::string)reason))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  ThreadPlacementIssue,
+                  " Placement of thread " << thread_name << " failed: " << failures,
+                  ((std::string)thread_name)((std::string)failures))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  MappedFileIssue,
+                  " Mapped file " << path << " issue: " << message,
+                  ((std::string)path)((std::string)message))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  HardwareJournalIssue,
+                  " Hardware journal " << path << " issue: " << message,
+                  ((std::string)path)((std::string)message))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  TraceFileIssue,
+                  " Trace file " << path << " issue: " << message,
+                  ((std::string)path)((std::string)message))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  HardwareStateFileIssue,
+                  " Hardware state file " << path << " issue: " << message,
+                  ((std::string)path)((std::string)message))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  ClockConfigIssue,
+                  " Clock configuration file " << path << " issue: " << message,
+                  ((std::string)path)((std::string)message))
+
+ERS_DECLARE_ISSUE(timinglibs,
+                  EndpointDelayStoreIssue,
+                  " Endpoint delay store " << path << " issue: " << message,
+                  ((std::string)path)((std::string)message))
 } // namespace dunedaq
 
 #endif // TIMINGLIBS_INCLUDE_TIMINGLIBS_TIMINGISSUES_HPP_
@@ -1,11 +1,21 @@
 namespace dunedaq::timinglibs {
+
+template<typename Child>
+void
+TimingController::register_hw_command(ControllerHwCmd cmd, void (Child::*f)(const nlohmann::json&))
+{
+  register_command(std::string(describe(cmd).module_command), f);
+  m_registered_hw_commands.set(to_index(cmd));
+}
+
 template<class T, class... Vs>
 void 
 TimingController::configure_hardware_or_recover_state(const nlohmann::json& data, std::string timing_entity_description, Vs... args)
 {
   bool conf_commands_sent=false;
+  bool check_fingerprint = !m_config_fingerprint.empty();
 
- 	if (!m_hardware_state_recovery_enabled)
+ 	if (!m_hardware_state_recovery_enabled && !check_fingerprint)
   {
     TLOG_DEBUG(3) << "State recovery not enabled. Sending configure commands...";
     send_configure_hardware_commands(data);
@@ -20,6 +30,22 @@ TimingController::configure_hardware_or_recover_state(const nlohmann::json& data
     
     TLOG_DEBUG(3) << timing_entity_description << " (" << m_timing_device << ") ready: " << m_device_ready << ", infos received: " << m_device_infos_received_count;
 
+    // the first device info tells whether the device holds this configuration, and is ready with it. A device
+    // with the fingerprint but not ready, e.g. after a power cycle, is configured straight away
+    if (check_fingerprint && !conf_commands_sent && m_device_config_fingerprint_checked.load() &&
+        (!m_device_config_fingerprint_matches.load() || !m_device_ready.load()))
+    {
+      TLOG_DEBUG(3) << (m_device_config_fingerprint_matches.load() ? "Device with the configuration fingerprint not ready."
+                                                                    : "Configuration fingerprint not recorded for the device.")
+                    << " Sending configure commands...";
+      m_device_ready = false;
+      m_device_infos_received_count = 0;
+      send_configure_hardware_commands(data);
+      time_of_conf = std::chrono::high_resolution_clock::now();
+      conf_commands_sent=true;
+      continue;
+    }
+
     if (m_device_ready.load() && m_device_infos_received_count.load())
     {
       if (!conf_commands_sent)
@@ -46,6 +72,14 @@ TimingController::configure_hardware_or_recover_state(const nlohmann::json& data
     TLOG_DEBUG(3) << "Waiting for " << timing_entity_description << " " << m_timing_device << " to become ready for (ms) " << ms_since_conf.count();
     std::this_thread::sleep_for(std::chrono::microseconds(250000));
   }
+
+  // let the next conf skip the configure commands
+  if (check_fingerprint && conf_commands_sent)
+  {
+    nlohmann::json payload;
+    payload["fingerprint"] = m_config_fingerprint;
+    send_hw_cmd(ControllerHwCmd::kRecordConfigFingerprint, payload);
+  }
 }
 
 }
\ No newline at end of file
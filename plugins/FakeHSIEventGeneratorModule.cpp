@@ -0,0 +1,299 @@
+/**
+ * @file FakeHSIEventGeneratorModule.cpp FakeHSIEventGeneratorModule class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "FakeHSIEventGeneratorModule.hpp"
+#include "timinglibs/MasterTimestampEstimator.hpp"
+#include "timinglibs/dal/FakeHSIEventGeneratorModule.hpp"
+#include "timinglibs/opmon/fakehsieventgenerator.pb.h"
+
+#include "confmodel/Connection.hpp"
+#include "iomanager/IOManager.hpp"
+#include "rcif/cmd/Nljs.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+FakeHSIEventGeneratorModule::FakeHSIEventGeneratorModule(const std::string& name)
+  : dunedaq::appfwk::DAQModule(name)
+  , m_params(nullptr)
+  , m_generation_thread(std::bind(&FakeHSIEventGeneratorModule::generate_hsievents, this, std::placeholders::_1))
+  , m_thread_placements({ { "hsi_event_generation", "hsi-gen" } })
+  , m_run_number(0)
+  , m_hsievent_sender(nullptr)
+  , m_hsievent_connection("")
+  , m_send_timeout(10)
+  , m_generation_mode(GenerationMode::kPoisson)
+  , m_mean_signal_change_interval(0)
+  , m_burst_size(1)
+  , m_burst_event_spacing(0)
+  , m_active_signals(0)
+  , m_rising_edge_mask(0)
+  , m_falling_edge_mask(0)
+  , m_invert_edge_mask(0)
+  , m_signal_levels(0)
+  , m_burst_position(0)
+  , m_sequence_counter(0)
+  , m_signal_changes(0)
+  , m_events_sent(0)
+  , m_events_failed_to_send(0)
+  , m_last_timestamp(0)
+{
+  register_command("conf", &FakeHSIEventGeneratorModule::do_configure);
+  register_command("start", &FakeHSIEventGeneratorModule::do_start);
+  register_command("stop", &FakeHSIEventGeneratorModule::do_stop);
+}
+
+void
+FakeHSIEventGeneratorModule::init(std::shared_ptr<appfwk::ModuleConfiguration> mcfg)
+{
+  auto mod_config = mcfg->module<dal::FakeHSIEventGeneratorModule>(get_name());
+  m_params = mod_config->get_configuration();
+  m_thread_placements.configure(m_params->get_thread_placements());
+
+  for (auto con : mod_config->get_outputs()) {
+    if (con->get_data_type() == datatype_to_string<dfmessages::HSIEvent>()) {
+      m_hsievent_connection = con->UID();
+    }
+  }
+
+  try {
+    m_hsievent_sender = iomanager::IOManager::get()->get_sender<dfmessages::HSIEvent>(m_hsievent_connection);
+  } catch (const ers::Issue& excpt) {
+    throw InvalidQueueFatalError(ERS_HERE, get_name(), "output", excpt);
+  }
+}
+
+void
+FakeHSIEventGeneratorModule::do_configure(const nlohmann::json&)
+{
+  auto event_rate = m_params->get_event_rate();
+  if (event_rate <= 0) {
+    throw InvalidFakeHSIConfiguration(ERS_HERE, get_name(), "event_rate must be positive");
+  }
+  m_active_signals = m_params->get_active_signals();
+  m_rising_edge_mask = m_params->get_rising_edge_mask();
+  m_falling_edge_mask = m_params->get_falling_edge_mask();
+  m_invert_edge_mask = m_params->get_invert_edge_mask();
+  if (!(m_active_signals & (m_rising_edge_mask | m_falling_edge_mask))) {
+    throw InvalidFakeHSIConfiguration(ERS_HERE, get_name(), "no active signal is in the rising or falling edge masks");
+  }
+  auto toggle_probability = m_params->get_toggle_probability();
+  if (toggle_probability < 0 || toggle_probability > 1) {
+    throw InvalidFakeHSIConfiguration(ERS_HERE, get_name(), "toggle_probability must be within [0, 1]");
+  }
+  m_signal_toggle = std::bernoulli_distribution(toggle_probability);
+
+  m_mean_signal_change_interval = s_clock_frequency / event_rate;
+  m_burst_size = 1;
+  m_burst_event_spacing = 0;
+
+  auto generation_mode = m_params->get_generation_mode();
+  if (generation_mode == "fixed") {
+    m_generation_mode = GenerationMode::kFixed;
+  } else if (generation_mode == "bursty") {
+    m_generation_mode = GenerationMode::kBursty;
+    m_burst_size = m_params->get_burst_size();
+    m_burst_event_spacing = m_params->get_burst_event_spacing();
+    if (!m_burst_size) {
+      throw InvalidFakeHSIConfiguration(ERS_HERE, get_name(), "burst_size must be positive");
+    }
+  } else {
+    m_generation_mode = GenerationMode::kPoisson;
+  }
+  // in bursty mode, the gaps between bursts keep the mean rate of signal changes at about event_rate
+  m_signal_change_interval =
+    std::exponential_distribution<double>(1. / (m_mean_signal_change_interval * m_burst_size));
+
+  auto random_seed = m_params->get_random_seed();
+  m_random_engine.seed(random_seed ? random_seed : std::random_device{}());
+
+  TLOG() << get_name() << ": configured " << generation_mode << " generation of signal changes at " << event_rate
+         << " Hz, active signals 0x" << std::hex << m_active_signals << ", rising edge mask 0x" << m_rising_edge_mask
+         << ", falling edge mask 0x" << m_falling_edge_mask << ", invert edge mask 0x" << m_invert_edge_mask << std::dec;
+}
+
+void
+FakeHSIEventGeneratorModule::do_start(const nlohmann::json& data)
+{
+  auto start_params = data.get<rcif::cmd::StartParams>();
+  m_run_number.store(start_params.run);
+
+  m_signal_levels = 0;
+  m_burst_position = 0;
+  m_sequence_counter = 0;
+
+  m_signal_changes = 0;
+  m_events_sent = 0;
+  m_events_failed_to_send = 0;
+  m_last_timestamp = 0;
+
+  m_generation_thread.start_working_thread();
+}
+
+void
+FakeHSIEventGeneratorModule::do_stop(const nlohmann::json&)
+{
+  if (m_generation_thread.thread_running())
+    m_generation_thread.stop_working_thread();
+
+  TLOG() << get_name() << " run " << m_run_number.load() << ": sent " << m_events_sent.load() << " HSI events from "
+         << m_signal_changes.load() << " signal changes, " << m_events_failed_to_send.load() << " failed to send";
+}
+
+uint64_t // NOLINT(build/unsigned)
+FakeHSIEventGeneratorModule::get_start_timestamp() const
+{
+  auto master_device = m_params->get_master_device();
+  if (!master_device.empty()) {
+    if (auto estimator = MasterTimestampEstimator::find(master_device)) {
+      if (auto estimate = estimator->estimate(); estimate.valid) {
+        return estimate.timestamp;
+      }
+    }
+    TLOG() << get_name() << ": no timestamp estimate for " << master_device << ", using the host time";
+  }
+  auto host_time = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch());
+  return static_cast<uint64_t>(host_time.count() * s_clock_frequency); // NOLINT(build/unsigned)
+}
+
+double
+FakeHSIEventGeneratorModule::next_signal_change_interval()
+{
+  switch (m_generation_mode) {
+    case GenerationMode::kFixed:
+      return m_mean_signal_change_interval;
+    case GenerationMode::kBursty:
+      if (++m_burst_position < m_burst_size) {
+        return m_burst_event_spacing;
+      }
+      m_burst_position = 0;
+      return m_signal_change_interval(m_random_engine);
+    case GenerationMode::kPoisson:
+    default:
+      return m_signal_change_interval(m_random_engine);
+  }
+}
+
+uint32_t // NOLINT(build/unsigned)
+FakeHSIEventGeneratorModule::next_trigger_map()
+{
+  uint32_t toggled = 0; // NOLINT(build/unsigned)
+  for (auto signals = m_active_signals; signals; signals &= signals - 1) {
+    if (m_signal_toggle(m_random_engine)) {
+      toggled |= signals & (~signals + 1);
+    }
+  }
+  // a signal change changes at least one signal
+  if (!toggled) {
+    auto n_active = std::bitset<32>(m_active_signals).count();
+    auto signals = m_active_signals;
+    for (auto i = std::uniform_int_distribution<size_t>(0, n_active - 1)(m_random_engine); i; --i) {
+      signals &= signals - 1;
+    }
+    toggled = signals & (~signals + 1);
+  }
+
+  // edges as seen by the HSI firmware, after inversion
+  uint32_t previous_levels = m_signal_levels ^ m_invert_edge_mask; // NOLINT(build/unsigned)
+  m_signal_levels ^= toggled;
+  uint32_t levels = m_signal_levels ^ m_invert_edge_mask; // NOLINT(build/unsigned)
+
+  return (m_rising_edge_mask & levels & ~previous_levels) | (m_falling_edge_mask & ~levels & previous_levels);
+}
+
+void
+FakeHSIEventGeneratorModule::generate_hsievents(std::atomic<bool>& running_flag)
+{
+  TLOG_DEBUG(0) << get_name() << ": Starting generate_hsievents() method.";
+  m_thread_placements.get("hsi_event_generation").apply(pthread_self());
+
+  auto device_id = m_params->get_hsi_device_id();
+  auto timestamp_offset = m_params->get_timestamp_offset();
+  auto batch_size = std::max<size_t>(m_params->get_batch_size(), 1);
+  auto run_number = m_run_number.load();
+
+  // the simulated clock counts from the start of generation
+  auto start_time = std::chrono::steady_clock::now();
+  uint64_t start_timestamp = get_start_timestamp() + timestamp_offset; // NOLINT(build/unsigned)
+
+  // reused between batches, so that steady state generation does not allocate
+  std::vector<dfmessages::HSIEvent> events;
+  events.reserve(batch_size);
+
+  double next_signal_change = next_signal_change_interval(); // [ticks since start]
+  while (running_flag.load()) {
+    double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count() * s_clock_frequency;
+
+    while (next_signal_change <= now && events.size() < batch_size) {
+      ++m_signal_changes;
+      if (auto trigger_map = next_trigger_map()) {
+        uint64_t timestamp = start_timestamp + static_cast<uint64_t>(next_signal_change); // NOLINT(build/unsigned)
+        events.emplace_back(device_id, trigger_map, timestamp, m_sequence_counter++, run_number);
+      }
+      next_signal_change += next_signal_change_interval();
+    }
+
+    if (!events.empty()) {
+      m_last_timestamp = events.back().timestamp;
+      for (auto& event : events) {
+        try {
+          m_hsievent_sender->send(std::move(event), m_send_timeout);
+          ++m_events_sent;
+        } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
+          ers::warning(excpt);
+          ++m_events_failed_to_send;
+        }
+      }
+      events.clear();
+      continue;
+    }
+
+    // check running_flag periodically
+    auto next_signal_change_time =
+      start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                     std::chrono::duration<double>(next_signal_change / s_clock_frequency));
+    auto slice_period = std::chrono::milliseconds(10);
+    while (running_flag.load() && next_signal_change_time > std::chrono::steady_clock::now() + slice_period) {
+      std::this_thread::sleep_for(slice_period);
+    }
+    if (running_flag.load()) {
+      std::this_thread::sleep_until(next_signal_change_time);
+    }
+  }
+
+  TLOG_DEBUG(0) << get_name() << ": Exiting generate_hsievents() method. Sent " << m_events_sent.load() << " HSI events";
+}
+
+void
+FakeHSIEventGeneratorModule::generate_opmon_data()
+{
+  opmon::FakeHSIEventGeneratorInfo info;
+  info.set_signal_changes(m_signal_changes.load());
+  info.set_events_sent(m_events_sent.load());
+  info.set_events_failed_to_send(m_events_failed_to_send.load());
+  info.set_last_timestamp(m_last_timestamp.load());
+  publish(std::move(info));
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::timinglibs::FakeHSIEventGeneratorModule)
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,134 @@
+/**
+ * @file FakeHSIEventGeneratorModule.hpp
+ *
+ * FakeHSIEventGeneratorModule is a DAQModule implementation that emits
+ * synthetic HSI events, standing in for an HSI and its readout.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_PLUGINS_FAKEHSIEVENTGENERATORMODULE_HPP_
+#define TIMINGLIBS_PLUGINS_FAKEHSIEVENTGENERATORMODULE_HPP_
+
+#include "ThreadPlacement.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+#include "timinglibs/dal/FakeHSIEventGeneratorConf.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "appfwk/ModuleConfiguration.hpp"
+#include "dfmessages/HSIEvent.hpp"
+#include "ers/Issue.hpp"
+#include "iomanager/Sender.hpp"
+#include "logging/Logging.hpp"
+#include "utilities/WorkerThread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief FakeHSIEventGeneratorModule emulates the HSI input signals at a
+ * configurable rate, in fixed rate, Poisson or bursty mode. At each
+ * emulated signal change, the active signals toggle at random and an HSI
+ * event is emitted if an edge matches the rising or falling edge masks,
+ * after inversion by the invert edge mask, as the HSI firmware configured
+ * with the same masks would. Event timestamps come from a simulated
+ * 62.5 MHz clock, anchored at start to the estimated timing master
+ * timestamp if one is available in the process, or to the host time.
+ */
+class FakeHSIEventGeneratorModule : public dunedaq::appfwk::DAQModule
+{
+public:
+  /**
+   * @brief FakeHSIEventGeneratorModule Constructor
+   * @param name Instance name for this FakeHSIEventGeneratorModule instance
+   */
+  explicit FakeHSIEventGeneratorModule(const std::string& name);
+
+  FakeHSIEventGeneratorModule(const FakeHSIEventGeneratorModule&) =
+    delete; ///< FakeHSIEventGeneratorModule is not copy-constructible
+  FakeHSIEventGeneratorModule& operator=(const FakeHSIEventGeneratorModule&) =
+    delete; ///< FakeHSIEventGeneratorModule is not copy-assignable
+  FakeHSIEventGeneratorModule(FakeHSIEventGeneratorModule&&) =
+    delete; ///< FakeHSIEventGeneratorModule is not move-constructible
+  FakeHSIEventGeneratorModule& operator=(FakeHSIEventGeneratorModule&&) =
+    delete; ///< FakeHSIEventGeneratorModule is not move-assignable
+  virtual ~FakeHSIEventGeneratorModule()
+  {
+    if (m_generation_thread.thread_running())
+      m_generation_thread.stop_working_thread();
+  }
+
+  void init(std::shared_ptr<appfwk::ModuleConfiguration> mcfg) override;
+
+  static constexpr double s_clock_frequency = 62.5e6; ///< Simulated clock ticks per second
+
+private:
+  // Commands
+  void do_configure(const nlohmann::json& data);
+  void do_start(const nlohmann::json& data);
+  void do_stop(const nlohmann::json& data);
+
+  void generate_hsievents(std::atomic<bool>& running_flag);
+  uint64_t get_start_timestamp() const; // NOLINT(build/unsigned)
+  double next_signal_change_interval();
+  uint32_t next_trigger_map(); // NOLINT(build/unsigned)
+
+  // opmon
+  void generate_opmon_data() override;
+
+  const dal::FakeHSIEventGeneratorConf* m_params;
+  dunedaq::utilities::WorkerThread m_generation_thread;
+  ThreadPlacements m_thread_placements;
+  std::atomic<uint32_t> m_run_number; // NOLINT(build/unsigned)
+
+  using sink_t = dunedaq::iomanager::SenderConcept<dfmessages::HSIEvent>;
+  std::shared_ptr<sink_t> m_hsievent_sender;
+  std::string m_hsievent_connection;
+  std::chrono::milliseconds m_send_timeout;
+
+  // emulation parameters, set at conf
+  enum class GenerationMode
+  {
+    kFixed,
+    kPoisson,
+    kBursty
+  };
+  GenerationMode m_generation_mode;
+  double m_mean_signal_change_interval; ///< [ticks]
+  uint32_t m_burst_size;                // NOLINT(build/unsigned)
+  double m_burst_event_spacing;         ///< [ticks]
+  uint32_t m_active_signals;            // NOLINT(build/unsigned)
+  uint32_t m_rising_edge_mask;          // NOLINT(build/unsigned)
+  uint32_t m_falling_edge_mask;         // NOLINT(build/unsigned)
+  uint32_t m_invert_edge_mask;          // NOLINT(build/unsigned)
+
+  // emulation state, used by the generation thread only
+  std::mt19937_64 m_random_engine;
+  std::exponential_distribution<double> m_signal_change_interval; ///< [ticks]
+  std::bernoulli_distribution m_signal_toggle;
+  uint32_t m_signal_levels;    // NOLINT(build/unsigned)
+  uint32_t m_burst_position;   // NOLINT(build/unsigned)
+  uint32_t m_sequence_counter; // NOLINT(build/unsigned)
+
+  std::atomic<uint64_t> m_signal_changes;        // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_events_sent;           // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_events_failed_to_send; // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_last_timestamp;        // NOLINT(build/unsigned)
+};
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_PLUGINS_FAKEHSIEVENTGENERATORMODULE_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,251 @@
+/**
+ * @file HSIReadout.cpp HSIReadout class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "HSIReadout.hpp"
+#include "timinglibs/dal/HSIReadout.hpp"
+#include "timinglibs/opmon/hsireadout.pb.h"
+
+#include "confmodel/Connection.hpp"
+#include "iomanager/IOManager.hpp"
+#include "rcif/cmd/Nljs.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+HSIReadout::HSIReadout(const std::string& name)
+  : dunedaq::appfwk::DAQModule(name)
+  , m_params(nullptr)
+  , m_hsi_device_name("")
+  , m_device_backend(nullptr)
+  , m_readout_thread(std::bind(&HSIReadout::read_hsievents, this, std::placeholders::_1))
+  , m_thread_placements({ { "hsi_readout", "hsi-readout" } })
+  , m_run_number(0)
+  , m_hsievent_sender(nullptr)
+  , m_hsievent_connection("")
+  , m_send_timeout(10)
+  , m_buffer_reads(0)
+  , m_failed_buffer_reads(0)
+  , m_words_read(0)
+  , m_incomplete_words(0)
+  , m_events_sent(0)
+  , m_events_failed_to_send(0)
+  , m_last_buffer_occupancy(0)
+  , m_max_buffer_occupancy(0)
+  , m_last_read_latency_us(0)
+{
+  register_command("conf", &HSIReadout::do_configure);
+  register_command("start", &HSIReadout::do_start);
+  register_command("stop", &HSIReadout::do_stop);
+  register_command("scrap", &HSIReadout::do_scrap);
+}
+
+void
+HSIReadout::init(std::shared_ptr<appfwk::ModuleConfiguration> mcfg)
+{
+  auto mod_config = mcfg->module<dal::HSIReadout>(get_name());
+  m_params = mod_config->get_configuration();
+  m_thread_placements.configure(m_params->get_thread_placements());
+
+  for (auto con : mod_config->get_outputs()) {
+    if (con->get_data_type() == datatype_to_string<dfmessages::HSIEvent>()) {
+      m_hsievent_connection = con->UID();
+    }
+  }
+
+  try {
+    m_hsievent_sender = iomanager::IOManager::get()->get_sender<dfmessages::HSIEvent>(m_hsievent_connection);
+  } catch (const ers::Issue& excpt) {
+    throw InvalidQueueFatalError(ERS_HERE, get_name(), "output", excpt);
+  }
+}
+
+void
+HSIReadout::do_configure(const nlohmann::json&)
+{
+  m_hsi_device_name = m_params->get_hsi_device_name();
+
+  configure_uhal(m_params);
+  m_device_backend = std::make_unique<UHALDeviceBackend>(*m_connection_manager);
+  m_device_backend->prepare_device(m_hsi_device_name);
+}
+
+void
+HSIReadout::do_start(const nlohmann::json& data)
+{
+  auto start_params = data.get<rcif::cmd::StartParams>();
+  m_run_number.store(start_params.run);
+
+  m_buffer_reads = 0;
+  m_failed_buffer_reads = 0;
+  m_words_read = 0;
+  m_incomplete_words = 0;
+  m_events_sent = 0;
+  m_events_failed_to_send = 0;
+  m_last_buffer_occupancy = 0;
+  m_max_buffer_occupancy = 0;
+  m_last_read_latency_us = 0;
+
+  m_readout_thread.start_working_thread();
+}
+
+void
+HSIReadout::do_stop(const nlohmann::json&)
+{
+  if (m_readout_thread.thread_running())
+    m_readout_thread.stop_working_thread();
+
+  TLOG() << get_name() << " run " << m_run_number.load() << ": sent " << m_events_sent.load() << " HSI events from "
+         << m_buffer_reads.load() << " buffer reads, " << m_events_failed_to_send.load() << " failed to send, maximum buffer occupancy "
+         << m_max_buffer_occupancy.load() << " words";
+}
+
+void
+HSIReadout::do_scrap(const nlohmann::json&)
+{
+  m_device_backend.reset();
+  scrap_uhal();
+}
+
+size_t
+HSIReadout::decode_hsi_words(const std::vector<uint32_t>& words, // NOLINT(build/unsigned)
+                             uint32_t run_number,                // NOLINT(build/unsigned)
+                             std::vector<dfmessages::HSIEvent>& events)
+{
+  size_t n_events = words.size() / s_hsi_words_per_event;
+  for (size_t i = 0; i < n_events; ++i) {
+    auto event_words = words.data() + i * s_hsi_words_per_event;
+
+    // header: device id in bits 31-16, sequence counter in bits 15-0
+    uint32_t header = event_words[0];                                                          // NOLINT(build/unsigned)
+    uint64_t timestamp = static_cast<uint64_t>(event_words[1]) | (static_cast<uint64_t>(event_words[2]) << 32); // NOLINT(build/unsigned)
+    uint32_t trigger_map = event_words[4];                                                     // NOLINT(build/unsigned)
+
+    events.emplace_back((header & 0xffff0000) >> 16, trigger_map, timestamp, header & 0x0000ffff, run_number);
+  }
+  return words.size() % s_hsi_words_per_event;
+}
+
+void
+HSIReadout::send_hsievents(std::vector<dfmessages::HSIEvent>& events)
+{
+  for (auto& event : events) {
+    try {
+      m_hsievent_sender->send(std::move(event), m_send_timeout);
+      ++m_events_sent;
+    } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
+      ers::warning(excpt);
+      ++m_events_failed_to_send;
+    }
+  }
+  events.clear();
+}
+
+void
+HSIReadout::read_hsievents(std::atomic<bool>& running_flag)
+{
+  TLOG_DEBUG(0) << get_name() << ": Starting read_hsievents() method.";
+  m_thread_placements.get("hsi_readout").apply(pthread_self());
+
+  auto readout_period = std::chrono::microseconds(m_params->get_readout_period());
+  auto occupancy_warning_threshold = m_params->get_occupancy_warning_threshold();
+  auto run_number = m_run_number.load();
+
+  // reused between reads, so that steady state reads do not allocate
+  std::vector<uint32_t> words; // NOLINT(build/unsigned)
+  std::vector<dfmessages::HSIEvent> events;
+  words.reserve(m_params->get_buffer_reserve_events() * s_hsi_words_per_event);
+  events.reserve(m_params->get_buffer_reserve_events());
+
+  bool occupancy_warning_issued = false;
+  while (running_flag.load()) {
+    auto read_start = std::chrono::steady_clock::now();
+    uint32_t occupancy = 0; // NOLINT(build/unsigned)
+    try {
+      occupancy = m_device_backend->read_hsi_buffer(m_hsi_device_name, words);
+      ++m_buffer_reads;
+    } catch (const std::exception& excpt) {
+      ers::warning(HSIBufferReadFailed(ERS_HERE, m_hsi_device_name, excpt));
+      ++m_failed_buffer_reads;
+      words.clear();
+    }
+    m_last_read_latency_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - read_start).count();
+
+    m_last_buffer_occupancy = occupancy;
+    if (occupancy > m_max_buffer_occupancy.load()) {
+      m_max_buffer_occupancy = occupancy;
+    }
+    // warn once per excursion above the threshold
+    if (occupancy_warning_threshold && occupancy > occupancy_warning_threshold) {
+      if (!occupancy_warning_issued) {
+        ers::warning(HSIBufferOccupancyHigh(ERS_HERE, m_hsi_device_name, occupancy, occupancy_warning_threshold));
+        occupancy_warning_issued = true;
+      }
+    } else {
+      occupancy_warning_issued = false;
+    }
+
+    m_words_read += words.size();
+    auto incomplete_words = decode_hsi_words(words, run_number, events);
+    if (incomplete_words) {
+      TLOG_DEBUG(1) << get_name() << ": " << incomplete_words << " words of an incomplete HSI event ignored";
+      m_incomplete_words += incomplete_words;
+    }
+
+    // the buffer may have filled up again while the previous block was read, only wait once it is empty
+    if (!events.empty()) {
+      send_hsievents(events);
+      continue;
+    }
+
+    // check running_flag periodically
+    auto slice_period = std::min(readout_period, std::chrono::microseconds(10000));
+    auto next_read_time = read_start + readout_period;
+    while (running_flag.load() && next_read_time > std::chrono::steady_clock::now() + slice_period) {
+      std::this_thread::sleep_for(slice_period);
+    }
+    if (running_flag.load()) {
+      std::this_thread::sleep_until(next_read_time);
+    }
+  }
+
+  TLOG_DEBUG(0) << get_name() << ": Exiting read_hsievents() method. Sent " << m_events_sent.load() << " HSI events";
+}
+
+void
+HSIReadout::generate_opmon_data()
+{
+  opmon::HSIReadoutInfo info;
+  info.set_buffer_reads(m_buffer_reads.load());
+  info.set_failed_buffer_reads(m_failed_buffer_reads.load());
+  info.set_words_read(m_words_read.load());
+  info.set_incomplete_words(m_incomplete_words.load());
+  info.set_events_sent(m_events_sent.load());
+  info.set_events_failed_to_send(m_events_failed_to_send.load());
+  info.set_last_buffer_occupancy(m_last_buffer_occupancy.load());
+  info.set_max_buffer_occupancy(m_max_buffer_occupancy.load());
+  info.set_last_read_latency_us(m_last_read_latency_us.load());
+  publish(std::move(info), { { "device", m_hsi_device_name } });
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::timinglibs::HSIReadout)
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,121 @@
+/**
+ * @file HSIReadout.hpp
+ *
+ * HSIReadout is a DAQModule implementation that reads HSI events from
+ * HSI hardware and sends them downstream as dfmessages::HSIEvent.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_PLUGINS_HSIREADOUT_HPP_
+#define TIMINGLIBS_PLUGINS_HSIREADOUT_HPP_
+
+#include "UHALDeviceBackend.hpp"
+#include "ThreadPlacement.hpp"
+
+#include "timinglibs/TimingHardwareInterface.hpp"
+#include "timinglibs/TimingIssues.hpp"
+#include "timinglibs/dal/HSIReadoutConf.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "appfwk/ModuleConfiguration.hpp"
+#include "dfmessages/HSIEvent.hpp"
+#include "ers/Issue.hpp"
+#include "iomanager/Sender.hpp"
+#include "logging/Logging.hpp"
+#include "utilities/WorkerThread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief HSIReadout drains the HSI buffer with block reads of the complete
+ * events it holds, decodes them, and sends the events of each read
+ * downstream in one batch. While reads return events, the buffer is read
+ * again immediately; the module only waits readout_period once the buffer
+ * is empty.
+ */
+class HSIReadout : public dunedaq::appfwk::DAQModule, public timinglibs::TimingHardwareInterface
+{
+public:
+  /**
+   * @brief HSIReadout Constructor
+   * @param name Instance name for this HSIReadout instance
+   */
+  explicit HSIReadout(const std::string& name);
+
+  HSIReadout(const HSIReadout&) = delete;            ///< HSIReadout is not copy-constructible
+  HSIReadout& operator=(const HSIReadout&) = delete; ///< HSIReadout is not copy-assignable
+  HSIReadout(HSIReadout&&) = delete;                 ///< HSIReadout is not move-constructible
+  HSIReadout& operator=(HSIReadout&&) = delete;      ///< HSIReadout is not move-assignable
+  virtual ~HSIReadout()
+  {
+    if (m_readout_thread.thread_running())
+      m_readout_thread.stop_working_thread();
+  }
+
+  void init(std::shared_ptr<appfwk::ModuleConfiguration> mcfg) override;
+
+  // words of one event in the HSI buffer: header, timestamp low, timestamp high, signal data, trigger map
+  static constexpr size_t s_hsi_words_per_event = 5;
+
+  /**
+   * @brief Decode the complete events of a block of HSI words
+   * @return Number of trailing words not making a complete event
+   */
+  static size_t decode_hsi_words(const std::vector<uint32_t>& words, // NOLINT(build/unsigned)
+                                 uint32_t run_number,                // NOLINT(build/unsigned)
+                                 std::vector<dfmessages::HSIEvent>& events);
+
+private:
+  // Commands
+  void do_configure(const nlohmann::json& data);
+  void do_start(const nlohmann::json& data);
+  void do_stop(const nlohmann::json& data);
+  void do_scrap(const nlohmann::json& data);
+
+  void read_hsievents(std::atomic<bool>& running_flag);
+  void send_hsievents(std::vector<dfmessages::HSIEvent>& events);
+
+  // opmon
+  void generate_opmon_data() override;
+
+  const dal::HSIReadoutConf* m_params;
+  std::string m_hsi_device_name;
+  std::unique_ptr<UHALDeviceBackend> m_device_backend;
+  dunedaq::utilities::WorkerThread m_readout_thread;
+  ThreadPlacements m_thread_placements;
+  std::atomic<uint32_t> m_run_number; // NOLINT(build/unsigned)
+
+  using sink_t = dunedaq::iomanager::SenderConcept<dfmessages::HSIEvent>;
+  std::shared_ptr<sink_t> m_hsievent_sender;
+  std::string m_hsievent_connection;
+  std::chrono::milliseconds m_send_timeout;
+
+  // written by the readout thread only
+  std::atomic<uint64_t> m_buffer_reads;          // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_failed_buffer_reads;   // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_words_read;            // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_incomplete_words;      // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_events_sent;           // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_events_failed_to_send; // NOLINT(build/unsigned)
+  std::atomic<uint32_t> m_last_buffer_occupancy; // NOLINT(build/unsigned)
+  std::atomic<uint32_t> m_max_buffer_occupancy;  // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_last_read_latency_us;  // NOLINT(build/unsigned)
+};
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_PLUGINS_HSIREADOUT_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
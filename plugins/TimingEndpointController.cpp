@@ -29,7 +29,7 @@ namespace dunedaq {
 namespace timinglibs {
 
 TimingEndpointController::TimingEndpointController(const std::string& name)
-  : dunedaq::timinglibs::TimingEndpointControllerBase(name, 6) // 2nd arg: how many hw commands can this module send?
+  : dunedaq::timinglibs::TimingEndpointControllerBase(name)
   {}
 
 } // namespace timinglibs
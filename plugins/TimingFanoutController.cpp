@@ -8,17 +8,12 @@
  */
 
 #include "TimingFanoutController.hpp"
+#include "DeviceInfoView.hpp"
 #include "timinglibs/dal/TimingFanoutControllerConf.hpp"
 
 #include "timinglibs/timingcmd/Nljs.hpp"
 #include "timinglibs/timingcmd/Structs.hpp"
 
-#include "timing/timingfirmwareinfo/Nljs.hpp"
-#include "timing/timingfirmwareinfo/Structs.hpp"
-
-#include "timing/timingendpointinfo/Nljs.hpp"
-#include "timing/timingendpointinfo/Structs.hpp"
-
 #include "appfwk/cmd/Nljs.hpp"
 #include "ers/Issue.hpp"
 
@@ -32,7 +27,7 @@ namespace dunedaq {
 namespace timinglibs {
 
 TimingFanoutController::TimingFanoutController(const std::string& name)
-  : dunedaq::timinglibs::TimingEndpointControllerBase(name, 6) // 2nd arg: how many hw commands can this module send?
+  : dunedaq::timinglibs::TimingEndpointControllerBase(name)
 {
   register_command("conf", &TimingFanoutController::do_configure);
   register_command("start", &TimingFanoutController::do_start);
@@ -64,32 +59,15 @@ TimingFanoutController::send_configure_hardware_commands(const nlohmann::json& d
   std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 }
 
-//void
-//TimingFanoutController::get_info(opmonlib::InfoCollector& ci, int /*level*/)
-//{
-  // send counters internal to the module
-//  timingfanoutcontrollerinfo::Info module_info;
-
-//  module_info.sent_io_reset_cmds = m_sent_hw_command_counters.at(0).atomic.load();
-//  module_info.sent_print_status_cmds = m_sent_hw_command_counters.at(1).atomic.load();
-//  module_info.sent_fanout_endpoint_enable_cmds = m_sent_hw_command_counters.at(2).atomic.load();
-//  module_info.sent_fanout_endpoint_reset_cmds = m_sent_hw_command_counters.at(4).atomic.load();
-
-//   ci.add(module_info);
-// }
-
 void
 TimingFanoutController::process_device_info(nlohmann::json info)
 {
   ++m_device_infos_received_count;
 
-  timing::timingfirmwareinfo::TimingDeviceInfo device_info;
-  from_json(info, device_info);
-
-  auto ept_info = device_info.endpoint_info;
+  auto ept_info = DeviceInfoView(info).record("endpoint_info");
 
-  uint32_t endpoint_state = ept_info.state;
-  bool ready = ept_info.ready;
+  uint32_t endpoint_state = ept_info.get<uint32_t>("state"); // NOLINT(build/unsigned)
+  bool ready = ept_info.get<bool>("ready");
 
   TLOG_DEBUG(3) << "state: 0x" << std::hex << endpoint_state << ", ready: " << ready << std::dec << ", infos received: " << m_device_infos_received_count;;
 
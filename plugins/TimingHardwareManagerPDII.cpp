@@ -8,6 +8,7 @@
  */
 
 #include "TimingHardwareManagerPDII.hpp"
+#include "TraceRecorder.hpp"
 #include "timinglibs/dal/TimingHardwareManagerPDII.hpp"
 
 #include "timinglibs/timingcmd/Nljs.hpp"
@@ -41,6 +42,9 @@ TimingHardwareManagerPDII::TimingHardwareManagerPDII(const std::string& name)
 void
 TimingHardwareManagerPDII::conf(const nlohmann::json& conf_data)
 {
+  start_configured_tracing();
+  TraceSpan span("conf", "transition");
+
   register_common_hw_commands_for_design();
   register_master_hw_commands_for_design();
   register_endpoint_hw_commands_for_design();
@@ -73,6 +77,7 @@ TimingHardwareManagerPDII::conf(const nlohmann::json& conf_data)
   }
 
   start_hw_mon_gathering();
+  start_link_watchdog();
 } // NOLINT
 
 void
@@ -89,6 +94,9 @@ TimingHardwareManagerPDII::register_common_hw_commands_for_design()
 {
   register_timing_hw_command("io_reset", &TimingHardwareManagerPDII::io_reset);
   register_timing_hw_command("print_status", &TimingHardwareManagerPDII::print_status);
+  register_timing_hw_command("record_config_fingerprint", &TimingHardwareManagerPDII::record_config_fingerprint);
+  register_timing_hw_command("register_watchpoints", &TimingHardwareManagerPDII::register_watchpoints);
+  register_timing_hw_command("unregister_watchpoints", &TimingHardwareManagerPDII::unregister_watchpoints);
 }
 
 void
@@ -96,8 +104,14 @@ TimingHardwareManagerPDII::register_master_hw_commands_for_design()
 {
   register_timing_hw_command("set_timestamp", &TimingHardwareManagerPDII::set_timestamp);
   register_timing_hw_command("set_endpoint_delay", &TimingHardwareManagerPDII::set_endpoint_delay);
+  register_timing_hw_command("set_endpoint_delays", &TimingHardwareManagerPDII::set_endpoint_delays);
   register_timing_hw_command("send_fl_command", &TimingHardwareManagerPDII::send_fl_cmd);
+  register_timing_hw_command("start_fl_command_sequence", &TimingHardwareManagerPDII::start_fl_cmd_sequence);
+  register_timing_hw_command("stop_fl_command_sequence", &TimingHardwareManagerPDII::stop_fl_cmd_sequence);
   register_timing_hw_command("master_endpoint_scan", &TimingHardwareManagerPDII::master_endpoint_scan);
+  register_timing_hw_command("define_endpoint_scan_set", &TimingHardwareManagerPDII::define_endpoint_scan_set);
+  register_timing_hw_command("update_endpoint_scan_set", &TimingHardwareManagerPDII::update_endpoint_scan_set);
+  // PD-II masters have no partitions, so no partition_configure
 }
 
 void
@@ -118,51 +132,6 @@ TimingHardwareManagerPDII::register_hsi_hw_commands_for_design()
   register_timing_hw_command("hsi_print_status", &TimingHardwareManagerPDII::hsi_print_status);
 }
 
-// void
-// TimingHardwareManagerPDII::get_info(opmonlib::InfoCollector& ci, int level)
-// {
-
-//   // send counters internal to the module
-//   timinghardwaremanagerpdiinfo::Info module_info;
-//   module_info.received_hw_commands_counter = m_received_hw_commands_counter.load();
-//   module_info.accepted_hw_commands_counter = m_accepted_hw_commands_counter.load();
-//   module_info.rejected_hw_commands_counter = m_rejected_hw_commands_counter.load();
-//   module_info.failed_hw_commands_counter = m_failed_hw_commands_counter.load();
-
-//   ci.add(module_info);
-
-//   // the hardware device data
-//   for (auto it = m_info_gatherers.begin(); it != m_info_gatherers.end(); ++it) {
-//     // master info
-//     if (m_monitored_device_name_master.find(it->second.get()->get_device_name()) != std::string::npos) {
-//       if (it->second.get()->get_op_mon_level() <= level) {
-//         it->second.get()->add_info_to_collector("master", ci);
-//       }
-//     }
-
-//     for (uint i = 0; i < m_monitored_device_names_fanout.size(); ++i) {
-//       std::string fanout_device_name = m_monitored_device_names_fanout.at(i);
-//       if (fanout_device_name.find(it->second.get()->get_device_name()) != std::string::npos) {
-//         if (it->second.get()->get_op_mon_level() <= level) {
-//           it->second.get()->add_info_to_collector("fanout_" + std::to_string(i), ci);
-//         }
-//       }
-//     }
-
-//     if (m_monitored_device_name_endpoint.find(it->second.get()->get_device_name()) != std::string::npos) {
-//       if (it->second.get()->get_op_mon_level() <= level) {
-//         it->second.get()->add_info_to_collector("endpoint", ci);
-//       }
-//     }
-
-//     if (m_monitored_device_name_hsi.find(it->second.get()->get_device_name()) != std::string::npos) {
-//       if (it->second.get()->get_op_mon_level() <= level) {
-//         it->second.get()->add_info_to_collector("hsi", ci);
-//       }
-//     }
-//   }
-// }
-
 } // namespace timinglibs
 } // namespace dunedaq
 
@@ -68,8 +68,6 @@ public:
   void start(const nlohmann::json& data);
   void stop(const nlohmann::json& data);
 
-  //  void get_info(opmonlib::InfoCollector& ci, int level) override;
-
   void partition_configure(const timingcmd::TimingHwCmd& /*hw_cmd*/) override {}
 
 protected:
@@ -0,0 +1,189 @@
+/**
+ * @file TimingJournalPlayer.cpp TimingJournalPlayer class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "TimingJournalPlayer.hpp"
+#include "timinglibs/dal/TimingJournalPlayer.hpp"
+
+#include "timinglibs/timingcmd/Nljs.hpp"
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include "confmodel/Connection.hpp"
+#include "iomanager/IOManager.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace dunedaq {
+
+DUNE_DAQ_SERIALIZABLE(timinglibs::timingcmd::TimingHwCmd, "TimingHwCmd");
+DUNE_DAQ_SERIALIZABLE(nlohmann::json, "JSON");
+
+namespace timinglibs {
+
+TimingJournalPlayer::TimingJournalPlayer(const std::string& name)
+  : dunedaq::appfwk::DAQModule(name)
+  , m_params(nullptr)
+  , m_journal_reader(nullptr)
+  , m_replay_thread(std::bind(&TimingJournalPlayer::replay, this, std::placeholders::_1))
+  , m_thread_placements({ { "journal_replay", "journal-replay" } })
+  , m_hw_command_sender(nullptr)
+  , m_hw_command_connection("")
+  , m_send_timeout(100)
+  , m_replayed_hw_commands(0)
+  , m_replayed_device_infos(0)
+  , m_failed_sends(0)
+{
+  register_command("conf", &TimingJournalPlayer::do_configure);
+  register_command("start", &TimingJournalPlayer::do_start);
+  register_command("stop", &TimingJournalPlayer::do_stop);
+  register_command("scrap", &TimingJournalPlayer::do_scrap);
+}
+
+void
+TimingJournalPlayer::init(std::shared_ptr<appfwk::ModuleConfiguration> mcfg)
+{
+  auto mod_config = mcfg->module<dal::TimingJournalPlayer>(get_name());
+  m_params = mod_config->get_configuration();
+  m_thread_placements.configure(m_params->get_thread_placements());
+
+  for (auto con : mod_config->get_outputs()) {
+    if (con->get_data_type() == datatype_to_string<timingcmd::TimingHwCmd>()) {
+      m_hw_command_connection = con->UID();
+      m_hw_command_sender = iomanager::IOManager::get()->get_sender<timingcmd::TimingHwCmd>(m_hw_command_connection);
+    } else if (con->get_data_type() == datatype_to_string<nlohmann::json>()) {
+      m_device_info_senders.emplace(con->UID(), iomanager::IOManager::get()->get_sender<nlohmann::json>(con->UID()));
+    }
+  }
+}
+
+void
+TimingJournalPlayer::do_configure(const nlohmann::json&)
+{
+  m_journal_reader = std::make_unique<HardwareJournalReader>(m_params->get_journal_file());
+  TLOG() << get_name() << " conf: journal " << m_params->get_journal_file() << " holds "
+         << m_journal_reader->get_record_count() << " records";
+}
+
+void
+TimingJournalPlayer::do_start(const nlohmann::json&)
+{
+  m_replayed_hw_commands = 0;
+  m_replayed_device_infos = 0;
+  m_failed_sends = 0;
+  m_journal_reader->rewind();
+  m_replay_thread.start_working_thread();
+}
+
+void
+TimingJournalPlayer::do_stop(const nlohmann::json&)
+{
+  if (m_replay_thread.thread_running())
+    m_replay_thread.stop_working_thread();
+
+  TLOG() << get_name() << " replayed " << m_replayed_hw_commands.load() << " hw commands and "
+         << m_replayed_device_infos.load() << " device infos, " << m_failed_sends.load() << " sends failed";
+}
+
+void
+TimingJournalPlayer::do_scrap(const nlohmann::json&)
+{
+  m_journal_reader.reset();
+}
+
+void
+TimingJournalPlayer::send_record(const JournalRecord& record)
+{
+  try {
+    if (record.type == JournalRecordType::kHardwareCommand) {
+      if (!m_params->get_replay_hw_commands() || !m_hw_command_sender)
+        return;
+      m_hw_command_sender->send(journal_record_to_hw_cmd(record), m_send_timeout);
+      ++m_replayed_hw_commands;
+    } else if (record.type == JournalRecordType::kDeviceInfo) {
+      if (!m_params->get_replay_device_info())
+        return;
+      auto sender = m_device_info_senders.find(record.device + "_info");
+      if (sender == m_device_info_senders.end()) {
+        TLOG_DEBUG(3) << "No output for " << record.device << " device info, skipping record";
+        return;
+      }
+      nlohmann::json info = record.data;
+      sender->second->send(std::move(info), m_send_timeout);
+      ++m_replayed_device_infos;
+    }
+  } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
+    ers::warning(excpt);
+    ++m_failed_sends;
+  }
+}
+
+void
+TimingJournalPlayer::replay(std::atomic<bool>& running_flag)
+{
+  TLOG_DEBUG(0) << get_name() << ": Starting replay() method.";
+  m_thread_placements.get("journal_replay").apply(pthread_self());
+
+  const double replay_speed = m_params->get_replay_speed();
+
+  bool keep_replaying = true;
+  while (keep_replaying && running_flag.load()) {
+    JournalRecord record;
+    uint64_t records_in_pass = 0; // NOLINT(build/unsigned)
+    int64_t first_record_time = -1;
+    auto replay_start_time = std::chrono::steady_clock::now();
+
+    while (running_flag.load() && m_journal_reader->next(record)) {
+      // the replay of each session is paced from its own first record
+      if (record.type == JournalRecordType::kSessionStart) {
+        first_record_time = -1;
+        continue;
+      }
+      if (first_record_time < 0) {
+        replay_start_time = std::chrono::steady_clock::now();
+        first_record_time = record.timestamp_ns;
+      }
+
+      if (replay_speed > 0) {
+        auto offset = std::chrono::nanoseconds(
+          static_cast<int64_t>(static_cast<double>(record.timestamp_ns - first_record_time) / replay_speed));
+        auto send_time = replay_start_time + offset;
+
+        // check running_flag periodically
+        auto slice_period = std::chrono::milliseconds(10);
+        while (send_time > std::chrono::steady_clock::now() + slice_period && running_flag.load()) {
+          std::this_thread::sleep_for(slice_period);
+        }
+        if (!running_flag.load()) {
+          break;
+        }
+        std::this_thread::sleep_until(send_time);
+      }
+      send_record(record);
+      ++records_in_pass;
+    }
+
+    keep_replaying = m_params->get_loop() && records_in_pass;
+    if (keep_replaying) {
+      m_journal_reader->rewind();
+    }
+  }
+
+  TLOG_DEBUG(0) << get_name() << ": Exiting replay() method. Replayed " << m_replayed_hw_commands.load()
+                << " hw commands and " << m_replayed_device_infos.load() << " device infos";
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+DEFINE_DUNE_DAQ_MODULE(dunedaq::timinglibs::TimingJournalPlayer)
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
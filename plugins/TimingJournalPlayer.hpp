@@ -0,0 +1,96 @@
+/**
+ * @file TimingJournalPlayer.hpp
+ *
+ * TimingJournalPlayer is a DAQModule implementation that
+ * replays a hardware journal recorded by a timing hardware manager.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_PLUGINS_TIMINGJOURNALPLAYER_HPP_
+#define TIMINGLIBS_PLUGINS_TIMINGJOURNALPLAYER_HPP_
+
+#include "HardwareJournal.hpp"
+#include "ThreadPlacement.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+#include "timinglibs/dal/TimingJournalPlayerConf.hpp"
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include "appfwk/DAQModule.hpp"
+#include "appfwk/ModuleConfiguration.hpp"
+#include "ers/Issue.hpp"
+#include "iomanager/Sender.hpp"
+#include "logging/Logging.hpp"
+#include "utilities/WorkerThread.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief TimingJournalPlayer sends the hw commands and device infos of a
+ * hardware journal on the connections they were originally received/sent on,
+ * so that hardware managers and controllers can be exercised without hardware.
+ */
+class TimingJournalPlayer : public dunedaq::appfwk::DAQModule
+{
+public:
+  /**
+   * @brief TimingJournalPlayer Constructor
+   * @param name Instance name for this TimingJournalPlayer instance
+   */
+  explicit TimingJournalPlayer(const std::string& name);
+
+  TimingJournalPlayer(const TimingJournalPlayer&) = delete;            ///< TimingJournalPlayer is not copy-constructible
+  TimingJournalPlayer& operator=(const TimingJournalPlayer&) = delete; ///< TimingJournalPlayer is not copy-assignable
+  TimingJournalPlayer(TimingJournalPlayer&&) = delete;                 ///< TimingJournalPlayer is not move-constructible
+  TimingJournalPlayer& operator=(TimingJournalPlayer&&) = delete;      ///< TimingJournalPlayer is not move-assignable
+  virtual ~TimingJournalPlayer()
+  {
+    if (m_replay_thread.thread_running())
+      m_replay_thread.stop_working_thread();
+  }
+
+  void init(std::shared_ptr<appfwk::ModuleConfiguration> mcfg) override;
+
+private:
+  // Commands
+  void do_configure(const nlohmann::json& data);
+  void do_start(const nlohmann::json& data);
+  void do_stop(const nlohmann::json& data);
+  void do_scrap(const nlohmann::json& data);
+
+  void replay(std::atomic<bool>& running_flag);
+  void send_record(const JournalRecord& record);
+
+  const dal::TimingJournalPlayerConf* m_params;
+  std::unique_ptr<HardwareJournalReader> m_journal_reader;
+  dunedaq::utilities::WorkerThread m_replay_thread;
+  ThreadPlacements m_thread_placements;
+
+  using hw_cmd_sink_t = dunedaq::iomanager::SenderConcept<timingcmd::TimingHwCmd>;
+  std::shared_ptr<hw_cmd_sink_t> m_hw_command_sender;
+  std::string m_hw_command_connection;
+
+  using info_sink_t = dunedaq::iomanager::SenderConcept<nlohmann::json>;
+  std::map<std::string, std::shared_ptr<info_sink_t>> m_device_info_senders;
+
+  std::chrono::milliseconds m_send_timeout;
+  std::atomic<uint64_t> m_replayed_hw_commands;  // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_replayed_device_infos; // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_failed_sends;          // NOLINT(build/unsigned)
+};
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_PLUGINS_TIMINGJOURNALPLAYER_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
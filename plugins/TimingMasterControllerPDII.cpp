@@ -8,13 +8,11 @@
  */
 
 #include "TimingMasterControllerPDII.hpp"
+#include "DeviceInfoView.hpp"
 
 #include "timinglibs/timingcmd/Nljs.hpp"
 #include "timinglibs/timingcmd/Structs.hpp"
 
-#include "timing/timingfirmwareinfo/Nljs.hpp"
-#include "timing/timingfirmwareinfo/Structs.hpp"
-
 #include "appfwk/cmd/Nljs.hpp"
 #include "ers/Issue.hpp"
 
@@ -30,18 +28,18 @@ namespace timinglibs {
 void
 TimingMasterControllerPDII::process_device_info(nlohmann::json info)
 {
+  auto arrival = MasterTimestampEstimator::clock_t::now();
   ++m_device_infos_received_count;
 
-  timing::timingfirmwareinfo::TimingDeviceInfo device_info;
-  from_json(info, device_info);
+  check_endpoint_scan_set(info);
 
-  auto master_info = device_info.master_info;
+  auto master_info = DeviceInfoView(info).record("master_info");
 
-  uint64_t master_timestamp = master_info.timestamp;
-  bool timestamp_valid = master_info.ts_valid;
-  bool timestamp_tx_error = master_info.ts_tx_err;
-  bool transmit_error = master_info.tx_err;
-  bool counters_ready = master_info.ctrs_rdy;
+  uint64_t master_timestamp = master_info.get<uint64_t>("timestamp"); // NOLINT(build/unsigned)
+  bool timestamp_valid = master_info.get<bool>("ts_valid");
+  bool timestamp_tx_error = master_info.get<bool>("ts_tx_err");
+  bool transmit_error = master_info.get<bool>("tx_err");
+  bool counters_ready = master_info.get<bool>("ctrs_rdy");
 
   TLOG_DEBUG(3) << "Master timestamp: 0x" << std::hex << master_timestamp
   << ", ts_valid: " << timestamp_valid
@@ -57,6 +55,7 @@ TimingMasterControllerPDII::process_device_info(nlohmann::json info)
       m_device_ready = true;
       TLOG_DEBUG(2) << "Timing master became ready";
     }
+    m_timestamp_estimator->add_sample(master_timestamp, arrival);
   }
   else
   {
@@ -65,6 +64,7 @@ TimingMasterControllerPDII::process_device_info(nlohmann::json info)
       m_device_ready = false;
       TLOG_DEBUG(2) << "Timing master no longer ready";
     }
+    m_timestamp_estimator->reset();
   }
 }
 
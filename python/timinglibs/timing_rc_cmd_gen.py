@@ -36,6 +36,29 @@ def generate_timing_rc_cmds(
                                                                 measure_rtt=False,
                                                                 control_sfp=False,
                                                                 sfp_mux=-1))])),
+        # no delays: apply the delays kept in the controller's endpoint_delay_file
+        ("master_set_endpoint_delays", acmd([ (MASTER_CONTROLLER_MOD_NAME, tcmd.TimingMasterSetEndpointDelaysCmdPayload(
+                                                                delays=[]))])),
+        # two channels, interleaved: 1 kHz of fl cmd 0x1 on channel 0, 100 Hz alternating 0x2 and 0x3 on channel 1
+        ("master_start_fl_command_sequence", acmd([ (MASTER_CONTROLLER_MOD_NAME, tcmd.TimingMasterFLCmdSequenceCmdPayload(
+                                                                schedules=[
+                                                                    tcmd.FLCmdSchedule(channel=0, pattern=[0x1], rate=1000, number_of_commands_to_send=0),
+                                                                    tcmd.FLCmdSchedule(channel=1, pattern=[0x2, 0x3], rate=100, number_of_commands_to_send=0),
+                                                                ],
+                                                                batch_period=1000))])),
+        ("master_stop_fl_command_sequence", acmd([ (MASTER_CONTROLLER_MOD_NAME, None)])),
+        # replace the endpoint at address 2, stop scanning the one at address 3
+        ("master_update_endpoint_scan_set", acmd([ (MASTER_CONTROLLER_MOD_NAME, tcmd.TimingMasterUpdateEndpointScanSetPayload(
+                                                                add=[tcmd.EndpointLocation(fanout_slot=0, sfp_slot=1, address=2)],
+                                                                remove=[3]))])),
+        # every ms, report when the master timestamp stops or starts being valid, and when the tx error is raised
+        ("register_watchpoints", acmd([ (MASTER_CONTROLLER_MOD_NAME, tcmd.TimingRegisterWatchpointsCmdPayload(
+                                                                watchpoints=[
+                                                                    tcmd.Watchpoint(id="ts_invalid", node="master.tstamp.csr.stat.ts_valid", mask=0x1, predicate="eq", value=0),
+                                                                    tcmd.Watchpoint(id="tx_err", node="master.global.csr.stat.tx_err", mask=0x1, predicate="ne", value=0),
+                                                                ],
+                                                                interval=1000))])),
+        ("unregister_watchpoints", acmd([ (MASTER_CONTROLLER_MOD_NAME, None)])),
         ]
 
     data_dir = f"{JSON_DIR}/data"
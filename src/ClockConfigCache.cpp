@@ -0,0 +1,157 @@
+/**
+ * @file ClockConfigCache.cpp ClockConfigCache class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "ClockConfigCache.hpp"
+#include "ContentHash.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+ClockConfigCache::ClockConfigCache(const std::string& cache_directory)
+  : m_cache_directory(cache_directory)
+{
+}
+
+ClockConfigCache::~ClockConfigCache()
+{
+  std::lock_guard<std::mutex> lock(m_clock_configs_mutex);
+  for (auto& [content_hash, cached_path] : m_cached_copies) {
+    std::remove(cached_path.c_str());
+  }
+}
+
+void
+ClockConfigCache::load(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(m_clock_configs_mutex);
+  load_locked(path);
+}
+
+std::string
+ClockConfigCache::get_cached_path(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(m_clock_configs_mutex);
+  if (auto clock_config = m_clock_configs.find(path); clock_config != m_clock_configs.end()) {
+    return clock_config->second.cached_path;
+  }
+  TLOG() << "Clock configuration " << path << " was not preloaded, loading it now";
+  return load_locked(path).cached_path;
+}
+
+size_t
+ClockConfigCache::size() const
+{
+  std::lock_guard<std::mutex> lock(m_clock_configs_mutex);
+  return m_clock_configs.size();
+}
+
+const ClockConfigCache::ClockConfig&
+ClockConfigCache::load_locked(const std::string& path)
+{
+  std::ifstream clock_config_file(path, std::ios::binary);
+  if (!clock_config_file) {
+    throw ClockConfigIssue(ERS_HERE, path, "failed to open");
+  }
+  std::string content((std::istreambuf_iterator<char>(clock_config_file)), std::istreambuf_iterator<char>());
+
+  ClockConfig clock_config;
+  clock_config.number_of_registers = validate(path, content);
+
+  clock_config.content_hash = to_hex(fnv1a_hash(content));
+
+  if (auto cached_copy = m_cached_copies.find(clock_config.content_hash); cached_copy != m_cached_copies.end()) {
+    clock_config.cached_path = cached_copy->second;
+  } else {
+    // per process, so that another process scrapping does not remove a copy in use here
+    std::string cached_path =
+      m_cache_directory + "/timinglibs_clock_config_" + std::to_string(::getpid()) + "_" + clock_config.content_hash + ".txt";
+    std::ofstream cached_file(cached_path, std::ios::binary | std::ios::trunc);
+    cached_file << content;
+    cached_file.close();
+    if (cached_file) {
+      m_cached_copies[clock_config.content_hash] = cached_path;
+      clock_config.cached_path = cached_path;
+    } else {
+      // the resets still get a validated configuration, only read from the original file
+      ers::warning(ClockConfigIssue(ERS_HERE, path, "failed to write cached copy " + cached_path + ", using the original file"));
+      std::remove(cached_path.c_str());
+      clock_config.cached_path = path;
+    }
+  }
+
+  TLOG() << "Loaded clock configuration " << path << ": " << clock_config.number_of_registers << " registers, hash "
+         << clock_config.content_hash << ", cached as " << clock_config.cached_path;
+
+  auto& entry = m_clock_configs[path];
+  entry = clock_config;
+  return entry;
+}
+
+size_t
+ClockConfigCache::validate(const std::string& path, const std::string& content)
+{
+  // register list as exported by ClockBuilder Pro: comment lines, an "Address,Data" header and "0xADDR,0xDATA" lines
+  size_t number_of_registers = 0;
+  size_t line_number = 0;
+  std::istringstream lines(content);
+  std::string line;
+  while (std::getline(lines, line)) {
+    ++line_number;
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    line.erase(0, line.find_first_not_of(" \t"));
+    if (line.empty() || line[0] == '#' || line == "Address,Data") {
+      continue;
+    }
+
+    auto comma = line.find(',');
+    bool valid = comma != std::string::npos;
+    if (valid) {
+      try {
+        size_t address_end = 0;
+        size_t data_end = 0;
+        auto address_field = line.substr(0, comma);
+        auto data_field = line.substr(comma + 1);
+        std::stoul(address_field, &address_end, 16);
+        std::stoul(data_field, &data_end, 16);
+        valid = address_end == address_field.size() && data_end == data_field.size();
+      } catch (const std::logic_error&) {
+        valid = false;
+      }
+    }
+    if (!valid) {
+      throw ClockConfigIssue(ERS_HERE, path, "line " + std::to_string(line_number) + " is not a register write: " + line);
+    }
+    ++number_of_registers;
+  }
+
+  if (!number_of_registers) {
+    throw ClockConfigIssue(ERS_HERE, path, "no register writes");
+  }
+  return number_of_registers;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
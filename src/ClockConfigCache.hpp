@@ -0,0 +1,85 @@
+/**
+ * @file ClockConfigCache.hpp
+ *
+ * ClockConfigCache reads and validates clock configuration files ahead of
+ * the io resets using them, and keeps a copy of each on a memory backed
+ * file system, keyed by content hash.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_CLOCKCONFIGCACHE_HPP_
+#define TIMINGLIBS_SRC_CLOCKCONFIGCACHE_HPP_
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Clock configuration files by path. The timing library reads the
+ * clock configuration from a file at each io reset, so the cache hands out
+ * the path of its copy: reading it costs no disk access, and the content
+ * used by the resets is the one validated at conf, even if the original
+ * file changes in the meantime.
+ */
+class ClockConfigCache
+{
+public:
+  /**
+   * @brief ClockConfigCache Constructor
+   * @param cache_directory Directory of the cached copies, a tmpfs mount
+   */
+  explicit ClockConfigCache(const std::string& cache_directory = "/dev/shm");
+  ~ClockConfigCache();
+
+  ClockConfigCache(const ClockConfigCache&) = delete;            ///< ClockConfigCache is not copy-constructible
+  ClockConfigCache& operator=(const ClockConfigCache&) = delete; ///< ClockConfigCache is not copy-assignable
+  ClockConfigCache(ClockConfigCache&&) = delete;                 ///< ClockConfigCache is not move-constructible
+  ClockConfigCache& operator=(ClockConfigCache&&) = delete;      ///< ClockConfigCache is not move-assignable
+
+  /**
+   * @brief Read, validate and cache a clock configuration file. Throws
+   * ClockConfigIssue if the file cannot be read or is not a register list.
+   */
+  void load(const std::string& path);
+
+  /**
+   * @brief Path of the cached copy of a clock configuration file, loading
+   * it first if it was not preloaded
+   */
+  std::string get_cached_path(const std::string& path);
+
+  size_t size() const;
+
+private:
+  struct ClockConfig
+  {
+    std::string content_hash;
+    std::string cached_path;
+    size_t number_of_registers;
+  };
+
+  const ClockConfig& load_locked(const std::string& path);
+  static size_t validate(const std::string& path, const std::string& content);
+
+  std::string m_cache_directory;
+  std::map<std::string, ClockConfig> m_clock_configs;
+  // cached copies by content hash, shared by the paths with the same content
+  std::map<std::string, std::string> m_cached_copies;
+  mutable std::mutex m_clock_configs_mutex;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_CLOCKCONFIGCACHE_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
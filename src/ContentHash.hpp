@@ -0,0 +1,52 @@
+/**
+ * @file ContentHash.hpp
+ *
+ * Hashing of file and configuration contents, for the fingerprints and
+ * caches of timinglibs that must stay the same from one process to the next.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_CONTENTHASH_HPP_
+#define TIMINGLIBS_SRC_CONTENTHASH_HPP_
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief 64 bit FNV-1a hash of data. Unlike std::hash, the value does not depend on the standard library
+ * @param hash Hash to continue from, to hash several pieces of data as one
+ */
+inline uint64_t // NOLINT(build/unsigned)
+fnv1a_hash(const std::string& data, uint64_t hash = 0xcbf29ce484222325) // NOLINT(build/unsigned)
+{
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+inline std::string
+to_hex(uint64_t value) // NOLINT(build/unsigned)
+{
+  std::ostringstream hex;
+  hex << std::hex << std::setw(16) << std::setfill('0') << value;
+  return hex.str();
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_CONTENTHASH_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,78 @@
+/**
+ * @file DeviceInfoView.hpp
+ *
+ * DeviceInfoView reads fields of a device info message, as sent by the
+ * hardware manager, without decoding the rest of the message.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_DEVICEINFOVIEW_HPP_
+#define TIMINGLIBS_SRC_DEVICEINFOVIEW_HPP_
+
+#include "nlohmann/json.hpp"
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief DeviceInfoView refers to a record of a device info message, e.g. a
+ * timing::timingfirmwareinfo::TimingDeviceInfo or one of its sub-records,
+ * and decodes a field only when it is read. Decoding the whole message into
+ * the firmware info structures costs the same whichever fields are used.
+ *
+ * As with from_json, a field missing from the message reads as its default.
+ * The view does not copy the message, which must outlive it.
+ */
+class DeviceInfoView
+{
+public:
+  explicit DeviceInfoView(const nlohmann::json& info)
+    : m_info(info.is_object() ? &info : nullptr)
+  {}
+
+  /**
+   * @brief View of a sub-record, e.g. "endpoint_info"; empty if the record is missing
+   */
+  DeviceInfoView record(const char* name) const
+  {
+    auto field = find(name);
+    return field ? DeviceInfoView(*field) : DeviceInfoView();
+  }
+
+  template<typename T>
+  T get(const char* name, T default_value = T()) const
+  {
+    auto field = find(name);
+    return field ? field->get<T>() : default_value;
+  }
+
+  bool empty() const { return !m_info; }
+
+private:
+  DeviceInfoView()
+    : m_info(nullptr)
+  {}
+
+  const nlohmann::json* find(const char* name) const
+  {
+    if (!m_info) {
+      return nullptr;
+    }
+    auto field = m_info->find(name);
+    return field != m_info->end() ? &*field : nullptr;
+  }
+
+  const nlohmann::json* m_info;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_DEVICEINFOVIEW_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,158 @@
+/**
+ * @file EndpointDelayStore.cpp EndpointDelayStore class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "EndpointDelayStore.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+EndpointDelayStore::EndpointDelayStore(const std::string& path, size_t initial_capacity)
+  : m_file(path, MappedFile::Access::kReadWrite)
+{
+  auto existing_size = m_file.get_file_size();
+
+  size_t existing_capacity = 0;
+  if (existing_size > 0) {
+    EndpointDelayFileHeader existing_header;
+    bool valid = existing_size >= sizeof(EndpointDelayFileHeader) &&
+                 m_file.read(&existing_header, sizeof(existing_header), 0) &&
+                 existing_header.magic == EndpointDelayFileHeader::s_magic &&
+                 existing_header.version == EndpointDelayFileHeader::s_version &&
+                 existing_header.entry_size == sizeof(EndpointDelayEntry) &&
+                 existing_header.count <= existing_header.capacity &&
+                 existing_size >= sizeof(EndpointDelayFileHeader) + existing_header.capacity * sizeof(EndpointDelayEntry);
+    if (!valid) {
+      throw EndpointDelayStoreIssue(ERS_HERE, path, "not an endpoint delay store, or unsupported version");
+    }
+    existing_capacity = existing_header.capacity;
+  }
+
+  auto capacity = std::max<size_t>(std::max(initial_capacity, existing_capacity), 1);
+  map_file(capacity);
+
+  auto file_header = header();
+  if (existing_size > 0) {
+    for (size_t i = 0; i < file_header->count; ++i) {
+      m_slots[entries()[i].address] = i;
+    }
+    TLOG() << "Loaded " << file_header->count << " endpoint delays from " << path;
+  } else {
+    std::memset(file_header, 0, sizeof(EndpointDelayFileHeader));
+    file_header->magic = EndpointDelayFileHeader::s_magic;
+    file_header->version = EndpointDelayFileHeader::s_version;
+    file_header->entry_size = sizeof(EndpointDelayEntry);
+    file_header->count = 0;
+    TLOG() << "Created endpoint delay store " << path;
+  }
+  file_header->capacity = static_cast<uint32_t>(capacity); // NOLINT(build/unsigned)
+}
+
+EndpointDelayStore::~EndpointDelayStore()
+{
+  std::lock_guard<std::mutex> lock(m_store_mutex);
+  m_file.sync(true);
+}
+
+void
+EndpointDelayStore::map_file(size_t capacity)
+{
+  m_file.map(sizeof(EndpointDelayFileHeader) + capacity * sizeof(EndpointDelayEntry));
+}
+
+EndpointDelayFileHeader*
+EndpointDelayStore::header() const
+{
+  return reinterpret_cast<EndpointDelayFileHeader*>(m_file.get_data());
+}
+
+EndpointDelayEntry*
+EndpointDelayStore::entries() const
+{
+  return reinterpret_cast<EndpointDelayEntry*>(m_file.get_data() + sizeof(EndpointDelayFileHeader));
+}
+
+void
+EndpointDelayStore::store(const timingcmd::TimingMasterSetEndpointDelayCmdPayload& delay)
+{
+  std::lock_guard<std::mutex> lock(m_store_mutex);
+
+  EndpointDelayEntry entry;
+  std::memset(&entry, 0, sizeof(EndpointDelayEntry));
+  entry.address = delay.address;
+  entry.coarse_delay = delay.coarse_delay;
+  entry.fine_delay = delay.fine_delay;
+  entry.phase_delay = delay.phase_delay;
+  entry.sfp_mux = delay.sfp_mux;
+  entry.flags = (delay.measure_rtt ? EndpointDelayEntry::s_measure_rtt : 0) |
+                (delay.control_sfp ? EndpointDelayEntry::s_control_sfp : 0);
+
+  if (auto slot = m_slots.find(delay.address); slot != m_slots.end()) {
+    std::memcpy(&entries()[slot->second], &entry, sizeof(EndpointDelayEntry));
+  } else {
+    if (header()->count == header()->capacity) {
+      size_t new_capacity = 2 * header()->capacity;
+      TLOG_DEBUG(1) << "Growing endpoint delay store " << get_path() << " to " << new_capacity << " endpoints";
+      map_file(new_capacity);
+      header()->capacity = static_cast<uint32_t>(new_capacity); // NOLINT(build/unsigned)
+    }
+    size_t index = header()->count;
+    std::memcpy(&entries()[index], &entry, sizeof(EndpointDelayEntry));
+
+    // count the entry only once it has been completely written
+    std::atomic_thread_fence(std::memory_order_release);
+    ++header()->count;
+    m_slots[delay.address] = index;
+  }
+  m_file.sync(false);
+}
+
+timingcmd::TimingMasterEndpointDelays
+EndpointDelayStore::get_delays() const
+{
+  std::lock_guard<std::mutex> lock(m_store_mutex);
+
+  timingcmd::TimingMasterEndpointDelays delays;
+  delays.reserve(header()->count);
+  for (size_t i = 0; i < header()->count; ++i) {
+    auto& entry = entries()[i];
+    timingcmd::TimingMasterSetEndpointDelayCmdPayload delay;
+    delay.address = entry.address;
+    delay.coarse_delay = entry.coarse_delay;
+    delay.fine_delay = entry.fine_delay;
+    delay.phase_delay = entry.phase_delay;
+    delay.measure_rtt = entry.flags & EndpointDelayEntry::s_measure_rtt;
+    delay.control_sfp = entry.flags & EndpointDelayEntry::s_control_sfp;
+    delay.sfp_mux = entry.sfp_mux;
+    delays.push_back(delay);
+  }
+  return delays;
+}
+
+size_t
+EndpointDelayStore::size() const
+{
+  std::lock_guard<std::mutex> lock(m_store_mutex);
+  return header()->count;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,116 @@
+/**
+ * @file EndpointDelayStore.hpp
+ *
+ * EndpointDelayStore keeps the calibrated endpoint delays of a timing
+ * master, keyed by endpoint address, in a memory-mapped file, so that they
+ * can be applied in bulk when the master controller is configured again.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_ENDPOINTDELAYSTORE_HPP_
+#define TIMINGLIBS_SRC_ENDPOINTDELAYSTORE_HPP_
+
+#include "MappedFile.hpp"
+
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief On-disk layout of the store. All integers are host endian.
+ *
+ * The file starts with an EndpointDelayFileHeader, followed by capacity
+ * EndpointDelayEntry slots, the first count of which are in use.
+ */
+struct EndpointDelayFileHeader
+{
+  static constexpr uint64_t s_magic = 0x3159414c45445454; // "TTDELAY1" NOLINT(build/unsigned)
+  static constexpr uint32_t s_version = 1;                // NOLINT(build/unsigned)
+
+  uint64_t magic;       // NOLINT(build/unsigned)
+  uint32_t version;     // NOLINT(build/unsigned)
+  uint32_t entry_size;  // NOLINT(build/unsigned)
+  uint32_t capacity;    // NOLINT(build/unsigned)
+  uint32_t count;       // NOLINT(build/unsigned)
+  uint8_t reserved[40]; // NOLINT(build/unsigned)
+};
+static_assert(sizeof(EndpointDelayFileHeader) == 64, "EndpointDelayFileHeader must be 64 bytes");
+
+struct EndpointDelayEntry
+{
+  static constexpr uint32_t s_measure_rtt = 0x1; // NOLINT(build/unsigned)
+  static constexpr uint32_t s_control_sfp = 0x2; // NOLINT(build/unsigned)
+
+  uint32_t address;      // NOLINT(build/unsigned)
+  uint32_t coarse_delay; // NOLINT(build/unsigned)
+  uint32_t fine_delay;   // NOLINT(build/unsigned)
+  uint32_t phase_delay;  // NOLINT(build/unsigned)
+  int32_t sfp_mux;
+  uint32_t flags;        // NOLINT(build/unsigned)
+  uint8_t reserved[8];   // NOLINT(build/unsigned)
+};
+static_assert(sizeof(EndpointDelayEntry) == 32, "EndpointDelayEntry must be 32 bytes");
+
+/**
+ * @brief EndpointDelayStore holds one delay per endpoint address, in the
+ * order the endpoints were first stored.
+ */
+class EndpointDelayStore
+{
+public:
+  /**
+   * @brief EndpointDelayStore Constructor
+   * @param path File to keep the delays in. Delays already stored at this path are loaded.
+   * @param initial_capacity Initial number of endpoint slots; doubled whenever they are exhausted
+   */
+  explicit EndpointDelayStore(const std::string& path, size_t initial_capacity = s_default_capacity);
+  ~EndpointDelayStore();
+
+  EndpointDelayStore(const EndpointDelayStore&) = delete;            ///< EndpointDelayStore is not copy-constructible
+  EndpointDelayStore& operator=(const EndpointDelayStore&) = delete; ///< EndpointDelayStore is not copy-assignable
+  EndpointDelayStore(EndpointDelayStore&&) = delete;                 ///< EndpointDelayStore is not move-constructible
+  EndpointDelayStore& operator=(EndpointDelayStore&&) = delete;      ///< EndpointDelayStore is not move-assignable
+
+  /**
+   * @brief Store the delay of an endpoint, replacing any delay stored for its address
+   */
+  void store(const timingcmd::TimingMasterSetEndpointDelayCmdPayload& delay);
+
+  /**
+   * @brief All stored delays, in the order the endpoints were first stored
+   */
+  timingcmd::TimingMasterEndpointDelays get_delays() const;
+
+  size_t size() const;
+  const std::string& get_path() const { return m_file.get_path(); }
+
+  static constexpr size_t s_default_capacity = 256;
+
+private:
+  void map_file(size_t capacity);
+  EndpointDelayFileHeader* header() const;
+  EndpointDelayEntry* entries() const;
+
+  MappedFile m_file;
+  std::map<uint32_t, size_t> m_slots; ///< endpoint address to entry index. NOLINT(build/unsigned)
+  mutable std::mutex m_store_mutex;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_ENDPOINTDELAYSTORE_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,49 @@
+/**
+ * @file EndpointScanSetUpdate.hpp
+ *
+ * Update of a set of scanned endpoints, shared by the master controllers,
+ * which keep the endpoints they monitor, and the hardware manager, which
+ * keeps the scan sets.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_ENDPOINTSCANSETUPDATE_HPP_
+#define TIMINGLIBS_SRC_ENDPOINTSCANSETUPDATE_HPP_
+
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include <algorithm>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Remove the endpoints at the addresses of remove, then append add. An added endpoint replaces the one
+ * at the same address
+ */
+inline void
+apply_endpoint_scan_set_update(timingcmd::TimingEndpointLocations& endpoints,
+                               const timingcmd::TimingEndpointLocations& add,
+                               const timingcmd::EndpointAddresses& remove)
+{
+  auto removed = [&remove, &add](const timingcmd::EndpointLocation& endpoint_location) {
+    return std::find(remove.begin(), remove.end(), endpoint_location.address) != remove.end() ||
+           std::any_of(add.begin(), add.end(), [&endpoint_location](const timingcmd::EndpointLocation& added) {
+             return added.address == endpoint_location.address;
+           });
+  };
+  endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), removed), endpoints.end());
+  endpoints.insert(endpoints.end(), add.begin(), add.end());
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_ENDPOINTSCANSETUPDATE_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,250 @@
+/**
+ * @file FLCmdSequencer.cpp FLCmdSequencer class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "FLCmdSequencer.hpp"
+#include "SlicedSleep.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+FLCmdSequencer::FLCmdSequencer(TimingDeviceBackend& backend,
+                               const std::string& device,
+                               const timingcmd::TimingMasterFLCmdSequenceCmdPayload& sequence)
+  : m_backend(backend)
+  , m_device(device)
+  , m_batch_period(std::chrono::microseconds(std::max<uint32_t>(sequence.batch_period, 1))) // NOLINT(build/unsigned)
+  , m_paused(false)
+  , m_interruptions(0)
+  , m_interrupted_time(0)
+  , m_running(false)
+  , m_thread(std::bind(&FLCmdSequencer::run_sequence, this, std::placeholders::_1))
+{
+  for (auto& params : sequence.schedules) {
+    if (params.pattern.empty()) {
+      throw InvalidFLCmdSchedule(ERS_HERE, params.channel, "empty pattern");
+    }
+    if (!(params.rate > 0)) {
+      throw InvalidFLCmdSchedule(ERS_HERE, params.channel, "rate must be positive");
+    }
+    m_schedules.push_back(Schedule{ params, 0, 0, 0, clock_t::time_point(), 0, 0, 0 });
+  }
+}
+
+FLCmdSequencer::~FLCmdSequencer()
+{
+  stop();
+}
+
+void
+FLCmdSequencer::start(const ThreadPlacement& placement)
+{
+  if (m_thread.thread_running()) {
+    return;
+  }
+  m_placement = placement;
+  m_start_time = clock_t::now();
+  m_running = true;
+  m_thread.start_working_thread(m_placement.get_name(m_device));
+}
+
+void
+FLCmdSequencer::stop()
+{
+  if (m_thread.thread_running()) {
+    m_thread.stop_working_thread();
+  }
+  m_running = false;
+}
+
+void
+FLCmdSequencer::pause()
+{
+  std::lock_guard<std::mutex> pause_lock(m_pause_mutex);
+  if (m_paused) {
+    return;
+  }
+  std::lock_guard<std::mutex> schedules_lock(m_schedules_mutex);
+  m_paused = true;
+  m_paused_at = clock_t::now();
+  ++m_interruptions;
+  TLOG_DEBUG(1) << m_device << ": fixed length command sequence paused";
+}
+
+void
+FLCmdSequencer::resume()
+{
+  std::lock_guard<std::mutex> pause_lock(m_pause_mutex);
+  if (!m_paused) {
+    return;
+  }
+  // the commands due during the pause are not made up
+  std::lock_guard<std::mutex> schedules_lock(m_schedules_mutex);
+  m_paused = false;
+  auto paused_for = clock_t::now() - m_paused_at;
+  m_start_time += paused_for;
+  m_interrupted_time += paused_for;
+  TLOG_DEBUG(1) << m_device << ": fixed length command sequence resumed after "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(paused_for).count() << " ms";
+}
+
+std::vector<FLCmdSequencer::ScheduleStats>
+FLCmdSequencer::get_stats() const
+{
+  std::vector<ScheduleStats> stats;
+  std::lock_guard<std::mutex> schedules_lock(m_schedules_mutex);
+  auto interrupted_time = m_interrupted_time + (m_paused ? clock_t::now() - m_paused_at : clock_t::duration::zero());
+  for (auto& schedule : m_schedules) {
+    ScheduleStats schedule_stats{ schedule.params.channel,
+                                  schedule.commands_sent,
+                                  schedule.params.rate,
+                                  0,
+                                  0,
+                                  0,
+                                  schedule.max_lateness_us,
+                                  schedule.done(),
+                                  m_interruptions,
+                                  std::chrono::duration<double>(interrupted_time).count(),
+                                  m_paused };
+    if (schedule.commands_sent) {
+      auto n = static_cast<double>(schedule.commands_sent);
+      std::chrono::duration<double> elapsed = schedule.last_sent - m_start_time;
+      // the first command is due at the start
+      schedule_stats.achieved_rate = elapsed.count() > 0 ? (n - 1) / elapsed.count() : 0;
+      schedule_stats.mean_lateness_us = schedule.lateness_sum_us / n;
+      auto variance = schedule.lateness_sum_squares_us / n - schedule_stats.mean_lateness_us * schedule_stats.mean_lateness_us;
+      schedule_stats.jitter_us = std::sqrt(std::max(variance, 0.));
+    }
+    stats.push_back(schedule_stats);
+  }
+  return stats;
+}
+
+void
+FLCmdSequencer::run_sequence(std::atomic<bool>& running_flag)
+{
+  m_placement.apply(pthread_self(), m_device);
+  TLOG_DEBUG(0) << m_device << ": starting fixed length command sequence of " << m_schedules.size() << " schedules";
+
+  // reused between batches
+  std::vector<FLCmdWrite> batch;
+  std::vector<std::pair<size_t, clock_t::time_point>> batch_due_times;
+
+  // a paused sequence checks for its resume at this period
+  auto paused_poll_period = std::chrono::milliseconds(1);
+
+  auto next_wake = m_start_time;
+  while (running_flag.load()) {
+    std::unique_lock<std::mutex> pause_lock(m_pause_mutex);
+    if (m_paused) {
+      pause_lock.unlock();
+      next_wake = clock_t::now() + paused_poll_period;
+      sleep_until_or_stopped(next_wake, running_flag);
+      continue;
+    }
+
+    auto now = clock_t::now();
+    bool all_done = true;
+    clock_t::time_point next_due = clock_t::time_point::max();
+    {
+      std::lock_guard<std::mutex> schedules_lock(m_schedules_mutex);
+      batch.clear();
+      batch_due_times.clear();
+
+      // merge the commands due of all the schedules, in the order they are due
+      while (true) {
+        Schedule* earliest = nullptr;
+        clock_t::time_point earliest_due;
+        for (auto& schedule : m_schedules) {
+          if (schedule.done()) {
+            continue;
+          }
+          auto due = schedule.due_time(m_start_time);
+          if (!earliest || due < earliest_due) {
+            earliest = &schedule;
+            earliest_due = due;
+          }
+        }
+        if (!earliest || earliest_due > now) {
+          all_done = !earliest;
+          next_due = earliest ? earliest_due : next_due;
+          break;
+        }
+
+        auto fl_cmd_id = earliest->params.pattern[earliest->pattern_position];
+        earliest->pattern_position = (earliest->pattern_position + 1) % earliest->params.pattern.size();
+        ++earliest->commands_due;
+
+        if (!batch.empty() && batch.back().fl_cmd_id == fl_cmd_id && batch.back().channel == earliest->params.channel) {
+          ++batch.back().number_of_commands;
+        } else {
+          batch.push_back(FLCmdWrite{ fl_cmd_id, earliest->params.channel, 1 });
+        }
+        batch_due_times.emplace_back(earliest - m_schedules.data(), earliest_due);
+      }
+    }
+
+    if (!batch.empty()) {
+      try {
+        m_backend.send_fl_cmds(m_device, batch);
+      } catch (const std::exception& excpt) {
+        ers::error(FLCmdSequenceFailed(ERS_HERE, m_device, excpt));
+        break;
+      }
+      auto sent = clock_t::now();
+
+      std::lock_guard<std::mutex> schedules_lock(m_schedules_mutex);
+      for (auto& [schedule_index, due] : batch_due_times) {
+        auto& schedule = m_schedules[schedule_index];
+        double lateness_us = std::chrono::duration<double, std::micro>(sent - due).count();
+        schedule.lateness_sum_us += lateness_us;
+        schedule.lateness_sum_squares_us += lateness_us * lateness_us;
+        schedule.max_lateness_us = std::max(schedule.max_lateness_us, lateness_us);
+        ++schedule.commands_sent;
+        schedule.last_sent = sent;
+      }
+    }
+
+    pause_lock.unlock();
+
+    if (all_done) {
+      break;
+    }
+
+    // wake up on the batch period grid, skipping the periods without commands due and the periods overrun
+    next_wake += m_batch_period;
+    if (next_wake < now) {
+      next_wake = now + m_batch_period;
+    }
+    if (next_due > next_wake) {
+      next_wake = next_due;
+    }
+    sleep_until_or_stopped(next_wake, running_flag);
+  }
+
+  m_running = false;
+  TLOG_DEBUG(0) << m_device << ": fixed length command sequence finished";
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,150 @@
+/**
+ * @file FLCmdSequencer.hpp
+ *
+ * FLCmdSequencer sends scheduled fixed length commands from a timing
+ * master, at a set rate on each channel, from a dedicated paced thread.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_FLCMDSEQUENCER_HPP_
+#define TIMINGLIBS_SRC_FLCMDSEQUENCER_HPP_
+
+#include "ThreadPlacement.hpp"
+#include "TimingDeviceBackend.hpp"
+
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include "utilities/WorkerThread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief FLCmdSequencer runs the schedules of a sequence, each sending the
+ * commands of its pattern in turn on its channel. The thread wakes up every
+ * batch period and sends all the commands that fell due since, of all the
+ * schedules, in one batch, in the order they were due; commands following
+ * each other with the same id on the same channel make a single burst.
+ *
+ * The lateness of each command, from the time it was due to the end of the
+ * write of its batch, is accumulated per schedule to report the achieved
+ * rate and the jitter.
+ *
+ * A paused sequence, e.g. during the io reset of its master, sends nothing;
+ * on resume its schedules carry on from where they were, shifted by the
+ * pause, rather than sending the commands that fell due in a burst.
+ */
+class FLCmdSequencer
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  struct ScheduleStats
+  {
+    uint32_t channel;          // NOLINT(build/unsigned)
+    uint64_t commands_sent;    // NOLINT(build/unsigned)
+    double target_rate;        ///< [Hz]
+    double achieved_rate;      ///< [Hz], over the time the sequence was not paused
+    double mean_lateness_us;
+    double jitter_us;          ///< Standard deviation of the lateness
+    double max_lateness_us;
+    bool done;
+    // of the whole sequence
+    uint64_t interruptions;    ///< Number of pauses NOLINT(build/unsigned)
+    double interrupted_s;      ///< Time spent paused, including the current pause
+    bool interrupted;          ///< Paused now
+  };
+
+  /**
+   * @brief FLCmdSequencer Constructor. Throws InvalidFLCmdSchedule if a schedule cannot be run.
+   * @param backend Device access; must outlive the sequencer
+   * @param device Timing master sending the commands
+   */
+  FLCmdSequencer(TimingDeviceBackend& backend,
+                 const std::string& device,
+                 const timingcmd::TimingMasterFLCmdSequenceCmdPayload& sequence);
+  ~FLCmdSequencer();
+
+  FLCmdSequencer(const FLCmdSequencer&) = delete;            ///< FLCmdSequencer is not copy-constructible
+  FLCmdSequencer& operator=(const FLCmdSequencer&) = delete; ///< FLCmdSequencer is not copy-assignable
+  FLCmdSequencer(FLCmdSequencer&&) = delete;                 ///< FLCmdSequencer is not move-constructible
+  FLCmdSequencer& operator=(FLCmdSequencer&&) = delete;      ///< FLCmdSequencer is not move-assignable
+
+  void start(const ThreadPlacement& placement);
+  void stop();
+
+  /**
+   * @brief Stop sending, once the batch in flight, if any, is written
+   */
+  void pause();
+  void resume();
+  // false once all the commands are sent, or a write failed
+  bool is_running() const { return m_running.load(); }
+
+  const std::string& get_device() const { return m_device; }
+  std::vector<ScheduleStats> get_stats() const;
+
+private:
+  struct Schedule
+  {
+    timingcmd::FLCmdSchedule params;
+    size_t pattern_position;
+    uint64_t commands_due;                  // NOLINT(build/unsigned)
+    uint64_t commands_sent;                 // NOLINT(build/unsigned)
+    clock_t::time_point last_sent;
+    double lateness_sum_us;
+    double lateness_sum_squares_us;
+    double max_lateness_us;
+
+    bool done() const
+    {
+      return params.number_of_commands_to_send && commands_due >= params.number_of_commands_to_send;
+    }
+    // from the count, so that rounding does not accumulate
+    clock_t::time_point due_time(clock_t::time_point start) const
+    {
+      return start + std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<double>(commands_due / params.rate));
+    }
+  };
+
+  void run_sequence(std::atomic<bool>& running_flag);
+
+  TimingDeviceBackend& m_backend;
+  std::string m_device;
+  clock_t::duration m_batch_period;
+
+  std::vector<Schedule> m_schedules;
+  clock_t::time_point m_start_time;
+  mutable std::mutex m_schedules_mutex;
+
+  // held during each batch, so that the master is not accessed once paused
+  std::mutex m_pause_mutex;
+  // written with both m_pause_mutex and m_schedules_mutex held
+  bool m_paused;
+  clock_t::time_point m_paused_at;
+  uint64_t m_interruptions;            // NOLINT(build/unsigned)
+  clock_t::duration m_interrupted_time;
+
+  ThreadPlacement m_placement;
+  std::atomic<bool> m_running;
+  dunedaq::utilities::WorkerThread m_thread;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_FLCMDSEQUENCER_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,347 @@
+/**
+ * @file FakeDeviceBackend.cpp FakeDeviceBackend class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "FakeDeviceBackend.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace dunedaq {
+namespace timinglibs {
+
+namespace {
+
+uint64_t // NOLINT(build/unsigned)
+nanoseconds_to_ticks(std::chrono::nanoseconds duration)
+{
+  // split to avoid overflowing on long durations
+  uint64_t seconds = duration.count() / 1000000000;                             // NOLINT(build/unsigned)
+  uint64_t remainder_ns = duration.count() % 1000000000;                        // NOLINT(build/unsigned)
+  return seconds * FakeDeviceBackend::s_clock_frequency_hz + (remainder_ns * 625) / 10000;
+}
+
+} // namespace
+
+FakeDeviceBackend::FakeDeviceBackend(std::chrono::microseconds operation_latency,
+                                     std::chrono::milliseconds endpoint_lock_time)
+  : m_operation_latency(operation_latency)
+  , m_endpoint_lock_time(endpoint_lock_time)
+{
+  TLOG() << "Using fake timing devices, operation latency [us]: " << m_operation_latency.count()
+         << ", endpoint lock time [ms]: " << m_endpoint_lock_time.count();
+}
+
+void
+FakeDeviceBackend::simulate_latency() const
+{
+  if (m_operation_latency.count() > 0) {
+    std::this_thread::sleep_for(m_operation_latency);
+  }
+}
+
+FakeDeviceBackend::DeviceState&
+FakeDeviceBackend::device_state(const std::string& device)
+{
+  if (device.empty()) {
+    throw UHALDeviceNameIssue(ERS_HERE, "Fake device name is an empty string");
+  }
+  return m_device_states[device];
+}
+
+uint32_t // NOLINT(build/unsigned)
+FakeDeviceBackend::endpoint_state(const DeviceState& state, clock_t::time_point now) const
+{
+  if (!state.endpoint_enabled) {
+    return 0x0;
+  }
+  if (m_endpoint_lock_time.count() == 0) {
+    return 0x8;
+  }
+  // step through the intermediate states 0x1..0x7 over the lock time
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - state.endpoint_enable_time);
+  auto step = 1 + (7 * elapsed.count()) / m_endpoint_lock_time.count();
+  return static_cast<uint32_t>(std::min<int64_t>(step, 0x8)); // NOLINT(build/unsigned)
+}
+
+void
+FakeDeviceBackend::count_fl_cmds(DeviceState& state, const FLCmdWrite& fl_cmd)
+{
+  state.sent_fl_cmds[fl_cmd.channel] += fl_cmd.number_of_commands;
+}
+
+// common
+void
+FakeDeviceBackend::io_reset(const std::string& device, const timingcmd::IOResetCmdPayload& payload)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  if (!payload.soft) {
+    // a full reset drops everything downstream of the clock
+    state = DeviceState();
+    state.clock_source = payload.clock_source;
+  }
+  state.io_reset_done = true;
+}
+
+std::string
+FakeDeviceBackend::get_status(const std::string& device)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  std::stringstream status;
+  status << "Fake device " << device << std::endl
+         << "  io reset done: " << state.io_reset_done << ", clock source: " << state.clock_source << std::endl
+         << "  timestamp synced: " << state.timestamp_synced << ", endpoint scans: " << state.endpoint_scans << std::endl
+         << "  endpoint enabled: " << state.endpoint_enabled << ", state: 0x" << std::hex
+         << endpoint_state(state, clock_t::now()) << std::dec << ", address: " << state.endpoint_address
+         << ", partition: " << state.endpoint_partition << std::endl;
+  return status.str();
+}
+
+void
+FakeDeviceBackend::get_info(const std::string& device, timing::timingfirmwareinfo::TimingDeviceInfo& info)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  auto now = clock_t::now();
+
+  if (state.timestamp_synced) {
+    info.master_info.timestamp = state.timestamp_at_sync + nanoseconds_to_ticks(now - state.timestamp_sync_time);
+  } else {
+    info.master_info.timestamp = 0;
+  }
+  info.master_info.ts_valid = state.timestamp_synced;
+  info.master_info.ts_tx_err = false;
+  info.master_info.tx_err = false;
+  info.master_info.ctrs_rdy = state.io_reset_done;
+
+  auto ept_state = endpoint_state(state, now);
+  info.endpoint_info.state = ept_state;
+  info.endpoint_info.ready = ept_state == 0x8;
+}
+
+LinkState
+FakeDeviceBackend::read_link_state(const std::string& device)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto ept_state = endpoint_state(device_state(device), clock_t::now());
+  return LinkState{ ept_state, ept_state == 0x8 };
+}
+
+void
+FakeDeviceBackend::read_registers(const std::string& device,
+                                  const std::vector<std::string>& nodes,
+                                  std::vector<uint32_t>& values) // NOLINT(build/unsigned)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  auto now = clock_t::now();
+
+  // the simulated devices only have the registers of their simulated state, whatever their path
+  values.clear();
+  for (auto& node : nodes) {
+    auto field = node.substr(node.rfind('.') + 1);
+    if (field == "ep_stat") {
+      values.push_back(endpoint_state(state, now));
+    } else if (field == "ep_rdy") {
+      values.push_back(endpoint_state(state, now) == 0x8);
+    } else if (field == "ts_valid") {
+      values.push_back(state.timestamp_synced);
+    } else if (field == "ctrs_rdy") {
+      values.push_back(state.io_reset_done);
+    } else if (field == "tx_err" || field == "ts_tx_err") {
+      values.push_back(0);
+    } else {
+      throw UHALDeviceNodeIssue(ERS_HERE, "fake device " + device + " has no register " + node);
+    }
+  }
+}
+
+// master
+void
+FakeDeviceBackend::sync_timestamp(const std::string& device, uint32_t /*timestamp_source*/) // NOLINT(build/unsigned)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  state.timestamp_at_sync = nanoseconds_to_ticks(std::chrono::system_clock::now().time_since_epoch());
+  state.timestamp_sync_time = clock_t::now();
+  state.timestamp_synced = true;
+}
+
+void
+FakeDeviceBackend::apply_endpoint_delay(const std::string& device,
+                                        const timingcmd::TimingMasterSetEndpointDelayCmdPayload& payload)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  device_state(device).endpoint_delays[payload.address] = payload;
+}
+
+void
+FakeDeviceBackend::apply_endpoint_delays(const std::string& device, const timingcmd::TimingMasterEndpointDelays& delays)
+{
+  // each delay is still a separate set of register accesses on the hardware
+  for (auto& delay : delays) {
+    simulate_latency();
+    std::lock_guard<std::mutex> lock(m_device_states_mutex);
+    device_state(device).endpoint_delays[delay.address] = delay;
+  }
+}
+
+void
+FakeDeviceBackend::send_fl_cmd(const std::string& device,
+                               uint32_t fl_cmd_id,          // NOLINT(build/unsigned)
+                               uint32_t channel,            // NOLINT(build/unsigned)
+                               uint32_t number_of_commands) // NOLINT(build/unsigned)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  count_fl_cmds(device_state(device), FLCmdWrite{ fl_cmd_id, channel, number_of_commands });
+}
+
+void
+FakeDeviceBackend::send_fl_cmds(const std::string& device, const std::vector<FLCmdWrite>& fl_cmds)
+{
+  // each burst is still a separate set of register accesses on the hardware
+  for (auto& fl_cmd : fl_cmds) {
+    simulate_latency();
+    std::lock_guard<std::mutex> lock(m_device_states_mutex);
+    count_fl_cmds(device_state(device), fl_cmd);
+  }
+}
+
+void
+FakeDeviceBackend::scan_endpoint(const std::string& master_device,
+                                 const std::string& fanout_device,
+                                 const timingcmd::EndpointLocation& location)
+{
+  // sfp switch on, optional mux switching, scan and sfp switch off
+  simulate_latency();
+  if (location.sfp_slot >= 0) {
+    simulate_latency();
+  }
+  simulate_latency();
+  simulate_latency();
+
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  if (location.fanout_slot > 0) {
+    device_state(fanout_device);
+  }
+  ++device_state(master_device).endpoint_scans;
+}
+
+// endpoint
+void
+FakeDeviceBackend::endpoint_enable(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  state.endpoint_enabled = true;
+  state.endpoint_enable_time = clock_t::now();
+  state.endpoint_address = payload.address;
+  state.endpoint_partition = payload.partition;
+}
+
+void
+FakeDeviceBackend::endpoint_disable(const std::string& device, uint32_t /*endpoint_id*/) // NOLINT(build/unsigned)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  device_state(device).endpoint_enabled = false;
+}
+
+void
+FakeDeviceBackend::endpoint_reset(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload)
+{
+  // a reset leaves the endpoint enabled, and restarts the lock sequence
+  endpoint_enable(device, payload);
+}
+
+// hsi
+void
+FakeDeviceBackend::hsi_reset(const std::string& device)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  state.hsi_configured = false;
+  state.hsi_running = false;
+}
+
+void
+FakeDeviceBackend::hsi_configure(const std::string& device, const timingcmd::HSIConfigureCmdPayload& payload)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  state.hsi_configuration = payload;
+  state.hsi_configured = true;
+}
+
+void
+FakeDeviceBackend::hsi_start(const std::string& device)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  device_state(device).hsi_running = true;
+}
+
+void
+FakeDeviceBackend::hsi_stop(const std::string& device)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  device_state(device).hsi_running = false;
+}
+
+std::string
+FakeDeviceBackend::get_hsi_status(const std::string& device)
+{
+  simulate_latency();
+  std::lock_guard<std::mutex> lock(m_device_states_mutex);
+  auto& state = device_state(device);
+  std::stringstream status;
+  status << "Fake HSI " << device << std::endl
+         << "  configured: " << state.hsi_configured << ", running: " << state.hsi_running << std::endl
+         << "  data source: " << state.hsi_configuration.data_source << ", rising edge mask: 0x" << std::hex
+         << state.hsi_configuration.rising_edge_mask << ", falling edge mask: 0x"
+         << state.hsi_configuration.falling_edge_mask << ", invert edge mask: 0x"
+         << state.hsi_configuration.invert_edge_mask << std::dec
+         << ", random rate: " << state.hsi_configuration.random_rate << std::endl;
+  return status.str();
+}
+
+uint32_t // NOLINT(build/unsigned)
+FakeDeviceBackend::read_hsi_buffer(const std::string& /*device*/, std::vector<uint32_t>& words) // NOLINT(build/unsigned)
+{
+  // the simulated HSI sees no signals
+  simulate_latency();
+  words.clear();
+  return 0;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,123 @@
+/**
+ * @file FakeDeviceBackend.hpp
+ *
+ * FakeDeviceBackend is an in-memory TimingDeviceBackend simulating timing
+ * master, fanout, endpoint and HSI designs, for running without hardware.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_FAKEDEVICEBACKEND_HPP_
+#define TIMINGLIBS_SRC_FAKEDEVICEBACKEND_HPP_
+
+#include "TimingDeviceBackend.hpp"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief FakeDeviceBackend keeps a simulated state per device name. Every
+ * operation costs a configurable latency, standing in for the IPBus round
+ * trip(s) of the real device. After an endpoint enable (or reset) the
+ * endpoint state climbs to 0x8 (ready) over the configured lock time, and
+ * the master timestamp counts at 62.5 MHz once it has been synchronised.
+ */
+class FakeDeviceBackend : public TimingDeviceBackend
+{
+public:
+  /**
+   * @brief FakeDeviceBackend Constructor
+   * @param operation_latency Time spent in each device operation
+   * @param endpoint_lock_time Time for an enabled endpoint to go from state 0x1 to 0x8
+   */
+  explicit FakeDeviceBackend(std::chrono::microseconds operation_latency = std::chrono::microseconds(0),
+                             std::chrono::milliseconds endpoint_lock_time = std::chrono::milliseconds(0));
+
+  void io_reset(const std::string& device, const timingcmd::IOResetCmdPayload& payload) override;
+  std::string get_status(const std::string& device) override;
+  void get_info(const std::string& device, timing::timingfirmwareinfo::TimingDeviceInfo& info) override;
+  LinkState read_link_state(const std::string& device) override;
+  void read_registers(const std::string& device,
+                      const std::vector<std::string>& nodes,
+                      std::vector<uint32_t>& values) override; // NOLINT(build/unsigned)
+
+  void sync_timestamp(const std::string& device, uint32_t timestamp_source) override; // NOLINT(build/unsigned)
+  void apply_endpoint_delay(const std::string& device,
+                            const timingcmd::TimingMasterSetEndpointDelayCmdPayload& payload) override;
+  void apply_endpoint_delays(const std::string& device, const timingcmd::TimingMasterEndpointDelays& delays) override;
+  void send_fl_cmd(const std::string& device,
+                   uint32_t fl_cmd_id,                   // NOLINT(build/unsigned)
+                   uint32_t channel,                     // NOLINT(build/unsigned)
+                   uint32_t number_of_commands) override; // NOLINT(build/unsigned)
+  void send_fl_cmds(const std::string& device, const std::vector<FLCmdWrite>& fl_cmds) override;
+  void scan_endpoint(const std::string& master_device,
+                     const std::string& fanout_device,
+                     const timingcmd::EndpointLocation& location) override;
+
+  void endpoint_enable(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload) override;
+  void endpoint_disable(const std::string& device, uint32_t endpoint_id) override; // NOLINT(build/unsigned)
+  void endpoint_reset(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload) override;
+
+  void hsi_reset(const std::string& device) override;
+  void hsi_configure(const std::string& device, const timingcmd::HSIConfigureCmdPayload& payload) override;
+  void hsi_start(const std::string& device) override;
+  void hsi_stop(const std::string& device) override;
+  std::string get_hsi_status(const std::string& device) override;
+  uint32_t read_hsi_buffer(const std::string& device, std::vector<uint32_t>& words) override; // NOLINT(build/unsigned)
+
+  static constexpr uint64_t s_clock_frequency_hz = 62500000; // NOLINT(build/unsigned)
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  struct DeviceState
+  {
+    bool io_reset_done = false;
+    uint32_t clock_source = 0; // NOLINT(build/unsigned)
+
+    // master
+    bool timestamp_synced = false;
+    clock_t::time_point timestamp_sync_time;
+    uint64_t timestamp_at_sync = 0;                                                   // NOLINT(build/unsigned)
+    std::map<uint32_t, timingcmd::TimingMasterSetEndpointDelayCmdPayload> endpoint_delays; // NOLINT(build/unsigned)
+    std::map<uint32_t, uint64_t> sent_fl_cmds;                                         // NOLINT(build/unsigned)
+    uint64_t endpoint_scans = 0;                                                       // NOLINT(build/unsigned)
+
+    // endpoint
+    bool endpoint_enabled = false;
+    clock_t::time_point endpoint_enable_time;
+    uint32_t endpoint_address = 0;   // NOLINT(build/unsigned)
+    uint32_t endpoint_partition = 0; // NOLINT(build/unsigned)
+
+    // hsi
+    bool hsi_configured = false;
+    bool hsi_running = false;
+    timingcmd::HSIConfigureCmdPayload hsi_configuration;
+  };
+
+  void simulate_latency() const;
+  void count_fl_cmds(DeviceState& state, const FLCmdWrite& fl_cmd);
+  DeviceState& device_state(const std::string& device);
+  uint32_t endpoint_state(const DeviceState& state, clock_t::time_point now) const; // NOLINT(build/unsigned)
+
+  std::chrono::microseconds m_operation_latency;
+  std::chrono::milliseconds m_endpoint_lock_time;
+  std::map<std::string, DeviceState> m_device_states;
+  std::mutex m_device_states_mutex;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_FAKEDEVICEBACKEND_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
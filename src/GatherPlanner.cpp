@@ -0,0 +1,80 @@
+/**
+ * @file GatherPlanner.cpp GatherPlanner class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "GatherPlanner.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+GatherPlanner::GatherPlanner(TimingDeviceBackend& backend)
+  : m_backend(backend)
+{
+}
+
+GatherPlanner::DevicePlan&
+GatherPlanner::get_plan(const std::string& device)
+{
+  std::lock_guard<std::mutex> plans_lock(m_plans_mutex);
+  auto [plan, inserted] = m_plans.try_emplace(device);
+  if (inserted) {
+    plan->second = std::make_unique<DevicePlan>();
+    plan->second->start = clock_t::now();
+  }
+  return *plan->second;
+}
+
+GatherPlanner::clock_t::time_point
+GatherPlanner::next_gather_time(const std::string& device,
+                                std::chrono::microseconds interval,
+                                clock_t::time_point after)
+{
+  auto& plan = get_plan(device);
+  auto period = std::max(std::chrono::duration_cast<clock_t::duration>(interval), clock_t::duration(1));
+  if (after < plan.start) {
+    return plan.start;
+  }
+  return plan.start + ((after - plan.start) / period + 1) * period;
+}
+
+GatherPlanner::Gather
+GatherPlanner::gather(const std::string& device, clock_t::time_point gather_time)
+{
+  auto& plan = get_plan(device);
+  std::lock_guard<std::mutex> gather_lock(plan.gather_mutex);
+
+  bool shared = plan.gathered_for == gather_time && (plan.info || plan.failure);
+  if (!shared) {
+    plan.gathered_for = gather_time;
+    plan.info.reset();
+    plan.failure = nullptr;
+    try {
+      auto info = std::make_shared<info_t>();
+      m_backend.get_info(device, *info);
+      plan.info = std::move(info);
+    } catch (...) {
+      plan.failure = std::current_exception();
+    }
+  }
+
+  if (plan.failure) {
+    std::rethrow_exception(plan.failure);
+  }
+  return Gather{ plan.info, shared };
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
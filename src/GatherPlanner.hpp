@@ -0,0 +1,98 @@
+/**
+ * @file GatherPlanner.hpp
+ *
+ * GatherPlanner schedules the device info gathers of a device on a common
+ * time grid, so that the gatherers of the device share the reads due at the
+ * same time.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_GATHERPLANNER_HPP_
+#define TIMINGLIBS_SRC_GATHERPLANNER_HPP_
+
+#include "TimingDeviceBackend.hpp"
+
+#include "timing/timingfirmwareinfo/Structs.hpp"
+
+#include <chrono>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief GatherPlanner aligns the gathers of each device to a grid starting
+ * at the first gather planned for the device: a gatherer with interval T
+ * gathers at the multiples of T from that start, so the gathers of gatherers
+ * whose intervals are multiples of each other coincide. The first gatherer to
+ * ask for the info due at a time reads the device, in one get_info; the
+ * others due at the same time wait for it and share the result, or its
+ * failure. Each gatherer still serialises and sends the info itself.
+ */
+class GatherPlanner
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+  using info_t = timing::timingfirmwareinfo::TimingDeviceInfo;
+
+  struct Gather
+  {
+    std::shared_ptr<const info_t> info;
+    bool shared; ///< read by another gatherer of the device
+  };
+
+  /**
+   * @brief GatherPlanner Constructor
+   * @param backend Device access; must outlive the planner
+   */
+  explicit GatherPlanner(TimingDeviceBackend& backend);
+
+  GatherPlanner(const GatherPlanner&) = delete;            ///< GatherPlanner is not copy-constructible
+  GatherPlanner& operator=(const GatherPlanner&) = delete; ///< GatherPlanner is not copy-assignable
+  GatherPlanner(GatherPlanner&&) = delete;                 ///< GatherPlanner is not move-constructible
+  GatherPlanner& operator=(GatherPlanner&&) = delete;      ///< GatherPlanner is not move-assignable
+
+  /**
+   * @brief First gather time of the device grid for the interval strictly after a time
+   */
+  clock_t::time_point next_gather_time(const std::string& device,
+                                       std::chrono::microseconds interval,
+                                       clock_t::time_point after);
+
+  /**
+   * @brief Info of the device due at a gather time, read if no other gatherer read it yet
+   */
+  Gather gather(const std::string& device, clock_t::time_point gather_time);
+
+private:
+  struct DevicePlan
+  {
+    clock_t::time_point start;
+    std::mutex gather_mutex; ///< held while the device is read, so that the gatherers due at the same time wait
+    clock_t::time_point gathered_for;
+    std::shared_ptr<const info_t> info;
+    std::exception_ptr failure;
+  };
+
+  DevicePlan& get_plan(const std::string& device);
+
+  TimingDeviceBackend& m_backend;
+  std::map<std::string, std::unique_ptr<DevicePlan>> m_plans;
+  std::mutex m_plans_mutex;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_GATHERPLANNER_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
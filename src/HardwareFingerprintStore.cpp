@@ -0,0 +1,91 @@
+/**
+ * @file HardwareFingerprintStore.cpp HardwareFingerprintStore class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "HardwareFingerprintStore.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+#include "nlohmann/json.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+HardwareFingerprintStore::HardwareFingerprintStore(const std::string& path)
+  : m_path(path)
+{
+  std::ifstream state_file(m_path);
+  if (!state_file) {
+    TLOG() << "No hardware state file " << m_path << " yet, no device configuration is known";
+    return;
+  }
+
+  try {
+    m_fingerprints = nlohmann::json::parse(state_file).get<std::map<std::string, std::string>>();
+  } catch (const nlohmann::json::exception& excpt) {
+    // the devices will simply be configured again
+    ers::warning(HardwareStateFileIssue(ERS_HERE, m_path, std::string("ignoring unreadable file: ") + excpt.what()));
+    m_fingerprints.clear();
+  }
+  TLOG() << "Loaded configuration fingerprints of " << m_fingerprints.size() << " devices from " << m_path;
+}
+
+std::string
+HardwareFingerprintStore::get(const std::string& device) const
+{
+  std::lock_guard<std::mutex> lock(m_fingerprints_mutex);
+  auto fingerprint = m_fingerprints.find(device);
+  return fingerprint == m_fingerprints.end() ? "" : fingerprint->second;
+}
+
+void
+HardwareFingerprintStore::record(const std::string& device, const std::string& fingerprint)
+{
+  std::lock_guard<std::mutex> lock(m_fingerprints_mutex);
+  m_fingerprints[device] = fingerprint;
+  write();
+}
+
+void
+HardwareFingerprintStore::invalidate(const std::string& device)
+{
+  std::lock_guard<std::mutex> lock(m_fingerprints_mutex);
+  if (m_fingerprints.erase(device)) {
+    write();
+  }
+}
+
+void
+HardwareFingerprintStore::write() const
+{
+  // replace the file in one go, so that a crash never leaves a partial state file behind
+  std::string tmp_path = m_path + ".tmp";
+  {
+    std::ofstream state_file(tmp_path, std::ios::trunc);
+    state_file << nlohmann::json(m_fingerprints).dump(2) << std::endl;
+    if (!state_file) {
+      ers::warning(HardwareStateFileIssue(ERS_HERE, tmp_path, "failed to write"));
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), m_path.c_str()) != 0) {
+    ers::warning(HardwareStateFileIssue(ERS_HERE, m_path, "failed to replace with " + tmp_path));
+  }
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
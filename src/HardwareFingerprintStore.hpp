@@ -0,0 +1,70 @@
+/**
+ * @file HardwareFingerprintStore.hpp
+ *
+ * HardwareFingerprintStore keeps, per timing device, the fingerprint of the
+ * configuration last applied to it, in a local state file, so that the
+ * controllers can tell after a restart whether a device needs configuring
+ * again.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_HARDWAREFINGERPRINTSTORE_HPP_
+#define TIMINGLIBS_SRC_HARDWAREFINGERPRINTSTORE_HPP_
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Configuration fingerprints by device name. A fingerprint is
+ * recorded by the controller once the device it configured is ready, and
+ * invalidated by any hardware command changing the device configuration.
+ */
+class HardwareFingerprintStore
+{
+public:
+  /**
+   * @brief HardwareFingerprintStore Constructor
+   * @param path State file. Fingerprints already stored at this path are loaded.
+   */
+  explicit HardwareFingerprintStore(const std::string& path);
+
+  HardwareFingerprintStore(const HardwareFingerprintStore&) = delete; ///< HardwareFingerprintStore is not copy-constructible
+  HardwareFingerprintStore& operator=(const HardwareFingerprintStore&) =
+    delete; ///< HardwareFingerprintStore is not copy-assignable
+  HardwareFingerprintStore(HardwareFingerprintStore&&) = delete; ///< HardwareFingerprintStore is not move-constructible
+  HardwareFingerprintStore& operator=(HardwareFingerprintStore&&) =
+    delete; ///< HardwareFingerprintStore is not move-assignable
+
+  /**
+   * @brief Fingerprint of the device configuration, empty if unknown
+   */
+  std::string get(const std::string& device) const;
+
+  void record(const std::string& device, const std::string& fingerprint);
+  void invalidate(const std::string& device);
+
+  const std::string& get_path() const { return m_path; }
+
+private:
+  void write() const;
+
+  std::string m_path;
+  std::map<std::string, std::string> m_fingerprints;
+  mutable std::mutex m_fingerprints_mutex;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_HARDWAREFINGERPRINTSTORE_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,228 @@
+/**
+ * @file HardwareJournal.cpp HardwareJournal class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "HardwareJournal.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+#include "timinglibs/timingcmd/Nljs.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+namespace {
+
+// wall clock time, so that the timestamps of the sessions of a journal, over restarts, follow each other
+int64_t
+journal_now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
+
+} // namespace
+
+HardwareJournal::HardwareJournal(const std::string& path, size_t initial_capacity)
+  : m_file(path, MappedFile::Access::kReadWrite)
+{
+  auto existing_size = m_file.get_file_size();
+
+  // never overwrite a file that is not a journal
+  if (existing_size > 0) {
+    JournalFileHeader existing_header;
+    bool valid = existing_size >= sizeof(JournalFileHeader) &&
+                 m_file.read(&existing_header, sizeof(existing_header), 0) &&
+                 existing_header.magic == JournalFileHeader::s_magic &&
+                 existing_header.version == JournalFileHeader::s_version &&
+                 existing_header.header_size >= sizeof(JournalFileHeader) &&
+                 existing_header.end_offset >= existing_header.header_size && existing_header.end_offset <= existing_size;
+    if (!valid) {
+      throw HardwareJournalIssue(ERS_HERE, path, "not a hardware journal, or unsupported version");
+    }
+  }
+
+  m_file.map(std::max(std::max(initial_capacity, existing_size), sizeof(JournalFileHeader)));
+
+  auto file_header = header();
+  if (existing_size > 0) {
+    TLOG() << "Appending to existing hardware journal " << path << " with " << file_header->record_count << " records";
+  } else {
+    std::memset(file_header, 0, sizeof(JournalFileHeader));
+    file_header->magic = JournalFileHeader::s_magic;
+    file_header->version = JournalFileHeader::s_version;
+    file_header->header_size = sizeof(JournalFileHeader);
+    file_header->end_offset = sizeof(JournalFileHeader);
+    file_header->record_count = 0;
+    TLOG() << "Created hardware journal " << path;
+  }
+
+  // the time between sessions is not replayed
+  append(JournalRecordType::kSessionStart, nlohmann::json::to_msgpack(nlohmann::json::object()));
+}
+
+HardwareJournal::~HardwareJournal()
+{
+  std::lock_guard<std::mutex> lock(m_append_mutex);
+  if (m_file.get_data()) {
+    auto end_offset = header()->end_offset;
+    m_file.sync(true);
+    // drop the unused tail of the mapping
+    try {
+      m_file.truncate(end_offset);
+    } catch (const MappedFileIssue& excpt) {
+      TLOG_DEBUG(1) << excpt.what();
+    }
+  }
+}
+
+void
+HardwareJournal::append(JournalRecordType type, const std::vector<uint8_t>& payload) // NOLINT(build/unsigned)
+{
+  JournalRecordHeader record_header;
+  record_header.type = static_cast<uint32_t>(type); // NOLINT(build/unsigned)
+  record_header.payload_size = static_cast<uint32_t>(payload.size()); // NOLINT(build/unsigned)
+  record_header.timestamp_ns = journal_now_ns();
+
+  std::lock_guard<std::mutex> lock(m_append_mutex);
+
+  size_t record_size = sizeof(JournalRecordHeader) + payload.size();
+  if (header()->end_offset + record_size > m_file.get_mapped_size()) {
+    size_t new_capacity = m_file.get_mapped_size();
+    while (header()->end_offset + record_size > new_capacity) {
+      new_capacity *= 2;
+    }
+    TLOG_DEBUG(1) << "Growing hardware journal " << get_path() << " to " << new_capacity << " bytes";
+    m_file.map(new_capacity);
+  }
+
+  auto file_header = header();
+  auto record = m_file.get_data() + file_header->end_offset;
+  std::memcpy(record, &record_header, sizeof(JournalRecordHeader));
+  std::memcpy(record + sizeof(JournalRecordHeader), payload.data(), payload.size());
+
+  // publish the record only once it has been completely written
+  std::atomic_thread_fence(std::memory_order_release);
+  file_header->end_offset += record_size;
+  ++file_header->record_count;
+}
+
+void
+HardwareJournal::record_hw_cmd(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  nlohmann::json record;
+  timingcmd::to_json(record, hw_cmd);
+  append(JournalRecordType::kHardwareCommand, nlohmann::json::to_msgpack(record));
+}
+
+void
+HardwareJournal::record_device_info(const std::string& device, const nlohmann::json& info)
+{
+  nlohmann::json record = { { "device", device }, { "info", info } };
+  append(JournalRecordType::kDeviceInfo, nlohmann::json::to_msgpack(record));
+}
+
+uint64_t // NOLINT(build/unsigned)
+HardwareJournal::get_record_count() const
+{
+  std::lock_guard<std::mutex> lock(m_append_mutex);
+  return header()->record_count;
+}
+
+HardwareJournalReader::HardwareJournalReader(const std::string& path)
+  : m_file(path, MappedFile::Access::kReadOnly)
+  , m_size(0)
+  , m_offset(sizeof(JournalFileHeader))
+{
+  auto file_size = m_file.get_file_size();
+  if (file_size < sizeof(JournalFileHeader)) {
+    throw HardwareJournalIssue(ERS_HERE, path, "file too short to be a journal");
+  }
+  m_file.map(file_size);
+  ::madvise(m_file.get_data(), file_size, MADV_SEQUENTIAL);
+
+  if (header()->magic != JournalFileHeader::s_magic || header()->version < 1 ||
+      header()->version > JournalFileHeader::s_version) {
+    throw HardwareJournalIssue(ERS_HERE, path, "not a hardware journal, or unsupported version");
+  }
+  // the writer may still own part of the file as unused capacity
+  m_size = std::min<size_t>(file_size, header()->end_offset);
+  m_offset = header()->header_size;
+}
+
+bool
+HardwareJournalReader::next(JournalRecord& record)
+{
+  if (m_offset + sizeof(JournalRecordHeader) > m_size) {
+    return false;
+  }
+
+  JournalRecordHeader record_header;
+  auto data = m_file.get_data();
+  std::memcpy(&record_header, data + m_offset, sizeof(JournalRecordHeader));
+  auto payload_start = data + m_offset + sizeof(JournalRecordHeader);
+  if (m_offset + sizeof(JournalRecordHeader) + record_header.payload_size > m_size) {
+    TLOG() << "Truncated record at offset " << m_offset << " in hardware journal " << m_file.get_path();
+    return false;
+  }
+  m_offset += sizeof(JournalRecordHeader) + record_header.payload_size;
+
+  auto decoded = nlohmann::json::from_msgpack(payload_start, payload_start + record_header.payload_size);
+
+  record.type = static_cast<JournalRecordType>(record_header.type);
+  record.timestamp_ns = record_header.timestamp_ns;
+  if (record.type == JournalRecordType::kSessionStart) {
+    record.device.clear();
+    record.data = std::move(decoded);
+    return true;
+  }
+  record.device = decoded.at("device").get<std::string>();
+  if (record.type == JournalRecordType::kDeviceInfo) {
+    record.data = std::move(decoded.at("info"));
+  } else {
+    record.data = std::move(decoded);
+  }
+  return true;
+}
+
+void
+HardwareJournalReader::rewind()
+{
+  m_offset = header()->header_size;
+}
+
+uint64_t // NOLINT(build/unsigned)
+HardwareJournalReader::get_record_count() const
+{
+  return header()->record_count;
+}
+
+timingcmd::TimingHwCmd
+journal_record_to_hw_cmd(const JournalRecord& record)
+{
+  timingcmd::TimingHwCmd hw_cmd;
+  timingcmd::from_json(record.data, hw_cmd);
+  return hw_cmd;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
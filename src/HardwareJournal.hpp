@@ -0,0 +1,162 @@
+/**
+ * @file HardwareJournal.hpp
+ *
+ * HardwareJournal provides an append-only, memory-mapped binary record of
+ * the hardware commands and device infos handled by a hardware manager,
+ * together with a reader used to replay them.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_HARDWAREJOURNAL_HPP_
+#define TIMINGLIBS_SRC_HARDWAREJOURNAL_HPP_
+
+#include "MappedFile.hpp"
+
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief On-disk layout of the journal. All integers are host endian.
+ *
+ * The file starts with a JournalFileHeader, followed by a sequence of records.
+ * Each record is a JournalRecordHeader followed by payload_size bytes of
+ * MsgPack-encoded JSON.
+ */
+enum class JournalRecordType : uint32_t // NOLINT(build/unsigned)
+{
+  kHardwareCommand = 1,
+  kDeviceInfo = 2,
+  kSessionStart = 3, ///< written when a journal is opened for writing; the records up to the next one form a session
+};
+
+struct JournalFileHeader
+{
+  static constexpr uint64_t s_magic = 0x314c4e524a4c5454; // "TTLJRNL1" NOLINT(build/unsigned)
+  // version 1 journals have steady clock timestamps and no session records; they can be read, not appended to
+  static constexpr uint32_t s_version = 2;                // NOLINT(build/unsigned)
+
+  uint64_t magic;        // NOLINT(build/unsigned)
+  uint32_t version;      // NOLINT(build/unsigned)
+  uint32_t header_size;  // NOLINT(build/unsigned)
+  uint64_t end_offset;   // NOLINT(build/unsigned)
+  uint64_t record_count; // NOLINT(build/unsigned)
+  uint8_t reserved[32];  // NOLINT(build/unsigned)
+};
+static_assert(sizeof(JournalFileHeader) == 64, "JournalFileHeader must be 64 bytes");
+
+struct JournalRecordHeader
+{
+  uint32_t type;         // NOLINT(build/unsigned)
+  uint32_t payload_size; // NOLINT(build/unsigned)
+  int64_t timestamp_ns;  ///< system clock time of the record, since the epoch [ns]
+};
+static_assert(sizeof(JournalRecordHeader) == 16, "JournalRecordHeader must be 16 bytes");
+
+/**
+ * @brief A decoded journal record
+ */
+struct JournalRecord
+{
+  JournalRecordType type;
+  int64_t timestamp_ns;
+  std::string device;
+  nlohmann::json data;
+};
+
+/**
+ * @brief HardwareJournal appends timestamped records to a memory-mapped file.
+ * Safe to use from the command callback and gatherer threads concurrently.
+ */
+class HardwareJournal
+{
+public:
+  /**
+   * @brief HardwareJournal Constructor
+   * @param path File to write to. An existing journal at this path is appended to, after a session start record.
+   * @param initial_capacity Initial size of the mapping [bytes]; doubled whenever it is exhausted
+   */
+  explicit HardwareJournal(const std::string& path, size_t initial_capacity = s_default_capacity);
+  ~HardwareJournal();
+
+  HardwareJournal(const HardwareJournal&) = delete;            ///< HardwareJournal is not copy-constructible
+  HardwareJournal& operator=(const HardwareJournal&) = delete; ///< HardwareJournal is not copy-assignable
+  HardwareJournal(HardwareJournal&&) = delete;                 ///< HardwareJournal is not move-constructible
+  HardwareJournal& operator=(HardwareJournal&&) = delete;      ///< HardwareJournal is not move-assignable
+
+  void record_hw_cmd(const timingcmd::TimingHwCmd& hw_cmd);
+  void record_device_info(const std::string& device, const nlohmann::json& info);
+
+  uint64_t get_record_count() const; // NOLINT(build/unsigned)
+  const std::string& get_path() const { return m_file.get_path(); }
+
+  static constexpr size_t s_default_capacity = 64 * 1024 * 1024;
+
+private:
+  void append(JournalRecordType type, const std::vector<uint8_t>& payload); // NOLINT(build/unsigned)
+  JournalFileHeader* header() const { return reinterpret_cast<JournalFileHeader*>(m_file.get_data()); }
+
+  MappedFile m_file;
+  mutable std::mutex m_append_mutex;
+};
+
+/**
+ * @brief HardwareJournalReader iterates over the records of a journal file.
+ */
+class HardwareJournalReader
+{
+public:
+  explicit HardwareJournalReader(const std::string& path);
+
+  HardwareJournalReader(const HardwareJournalReader&) = delete;            ///< HardwareJournalReader is not copy-constructible
+  HardwareJournalReader& operator=(const HardwareJournalReader&) = delete; ///< HardwareJournalReader is not copy-assignable
+  HardwareJournalReader(HardwareJournalReader&&) = delete;                 ///< HardwareJournalReader is not move-constructible
+  HardwareJournalReader& operator=(HardwareJournalReader&&) = delete;      ///< HardwareJournalReader is not move-assignable
+
+  /**
+   * @brief Decode the next record
+   * @return false once the end of the journal has been reached
+   */
+  bool next(JournalRecord& record);
+
+  /**
+   * @brief Go back to the first record
+   */
+  void rewind();
+
+  uint64_t get_record_count() const; // NOLINT(build/unsigned)
+
+private:
+  const JournalFileHeader* header() const { return reinterpret_cast<const JournalFileHeader*>(m_file.get_data()); }
+
+  MappedFile m_file;
+  size_t m_size;
+  size_t m_offset;
+};
+
+/**
+ * @brief Convert a decoded hardware command record back to a TimingHwCmd
+ */
+timingcmd::TimingHwCmd
+journal_record_to_hw_cmd(const JournalRecord& record);
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_HARDWAREJOURNAL_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -12,6 +12,13 @@
 #ifndef TIMINGLIBS_SRC_INFOGATHERER_HPP_
 #define TIMINGLIBS_SRC_INFOGATHERER_HPP_
 
+#include "GatherPlanner.hpp"
+#include "HardwareFingerprintStore.hpp"
+#include "HardwareJournal.hpp"
+#include "ThreadPlacement.hpp"
+
+#include "timinglibs/opmon/timinghardwaremanager.pb.h"
+
 #include "timing/timingfirmwareinfo/Nljs.hpp"
 #include "timing/timingfirmwareinfo/Structs.hpp"
 
@@ -23,12 +30,15 @@
 
 #include "nlohmann/json.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <list>
 #include <memory>
 #include <shared_mutex>
 #include <string>
+#include <vector>
 
 namespace dunedaq {
 
@@ -71,11 +81,9 @@ public:
     , m_gather_data(gather_data)
     , m_device_info_connection_id(device_name+"_info")
     , m_hw_info_sender(nullptr)
-    , m_sent_counter(0)
-    , m_failed_to_send_counter(0)
     , m_queue_timeout(1)
+    , m_journal(nullptr)
   {
-    //    m_info_collector = std::make_unique<opmonlib::InfoCollector>();
     m_hw_info_sender = iomanager::IOManager::get()->get_sender<nlohmann::json>(m_device_info_connection_id);
   }
 
@@ -91,9 +99,10 @@ public:
 
   /**
    * @brief Start the monitoring thread (which executes the m_gather_data() function)
+   * @param placement Placement of the thread, named after the device
    * @throws MonitorThreadingIssue if the thread is already running
    */
-  void start_gathering_thread(const std::string& name = "noname")
+  void start_gathering_thread(const ThreadPlacement& placement)
   {
     if (run_gathering()) {
       ers::warning(GatherThreadingIssue(ERS_HERE,
@@ -103,13 +112,7 @@ public:
     }
     m_run_gathering = true;
     m_gathering_thread.reset(new std::thread([&] { m_gather_data(*this); }));
-    auto handle = m_gathering_thread->native_handle();
-    auto rc = pthread_setname_np(handle, name.c_str());
-    if (rc != 0) {
-      std::ostringstream s;
-      s << "The name " << name << " provided for the thread is too long.";
-      ers::warning(GatherThreadingIssue(ERS_HERE, s.str()));
-    }
+    placement.apply(m_gathering_thread->native_handle(), m_device_name);
   }
 
   /**
@@ -154,28 +157,46 @@ public:
 
   int get_op_mon_level() const { return m_op_mon_level; }
 
-  template<class DSGN>
-  void collect_info_from_device(const DSGN& device)
+  void set_journal(std::shared_ptr<HardwareJournal> journal) { m_journal = journal; }
+  void set_fingerprints(std::shared_ptr<HardwareFingerprintStore> fingerprints) { m_fingerprints = fingerprints; }
+  // names of the endpoint scan sets of a device, sent with its infos so that the controllers notice a lost set
+  void set_endpoint_scan_sets(std::function<std::vector<std::string>(const std::string&)> get_endpoint_scan_sets)
+  {
+    m_get_endpoint_scan_sets = get_endpoint_scan_sets;
+  }
+
+  /**
+   * @brief Gather the info due at gather_time, or share the read of another gatherer due at the same time, and send it
+   */
+  void collect_info_from_device(GatherPlanner& planner, GatherPlanner::clock_t::time_point gather_time)
   {
     std::unique_lock info_collector_lock(m_info_collector_mutex);
-    m_device_info.reset( new timing::timingfirmwareinfo::TimingDeviceInfo() );
-    device.get_info(*m_device_info);
+    auto gather = planner.gather(m_device_name, gather_time);
+    m_device_info = gather.info;
     update_last_gathered_time(std::time(nullptr));
+    if (gather.shared) {
+      ++m_counters.shared_gathers;
+    }
     send_device_info();
   }
 
-  // void add_info_to_collector(std::string label, opmonlib::InfoCollector& ic)
-  // {
-  //   std::unique_lock info_collector_lock(m_info_collector_mutex);
-  //   if (m_info_collector->is_empty()) {
-  //     TLOG_DEBUG(3) << "skipping add info for gatherer: " << get_device_name()
-  //            << " with gathered time: " << get_last_gathered_time() << " and level " << get_op_mon_level();
-  //   } else {
-  //     ic.add(label, *m_info_collector);
-  //   }
-  //   m_info_collector = std::make_unique<opmonlib::InfoCollector>();
-  //   update_last_gathered_time(0);
-  // }
+  void count_gather(bool succeeded, std::chrono::microseconds latency)
+  {
+    ++(succeeded ? m_counters.gathers_done : m_counters.gathers_failed);
+    m_counters.last_gather_latency_us.store(latency.count(), std::memory_order_relaxed);
+  }
+
+  opmon::InfoGathererInfo get_opmon_info() const
+  {
+    opmon::InfoGathererInfo info;
+    info.set_gathers_done(m_counters.gathers_done.load(std::memory_order_relaxed));
+    info.set_gathers_failed(m_counters.gathers_failed.load(std::memory_order_relaxed));
+    info.set_last_gather_latency_us(m_counters.last_gather_latency_us.load(std::memory_order_relaxed));
+    info.set_info_sent(m_counters.info_sent.load(std::memory_order_relaxed));
+    info.set_info_send_failures(m_counters.info_send_failures.load(std::memory_order_relaxed));
+    info.set_shared_gathers(m_counters.shared_gathers.load(std::memory_order_relaxed));
+    return info;
+  }
 
 private:
   void send_device_info()
@@ -194,6 +215,22 @@ private:
     
     nlohmann::json info;
     to_json(info, *m_device_info);
+
+    if (m_journal)
+    {
+      m_journal->record_device_info(m_device_name, info);
+    }
+
+    if (m_fingerprints)
+    {
+      info["config_fingerprint"] = m_fingerprints->get(m_device_name);
+    }
+
+    if (m_get_endpoint_scan_sets)
+    {
+      info["endpoint_scan_sets"] = m_get_endpoint_scan_sets(m_device_name);
+    }
+
     bool was_successfully_sent = false;
     while (!was_successfully_sent)
     {
@@ -201,13 +238,13 @@ private:
       {
         m_hw_info_sender->send(std::move(info), m_queue_timeout);
         TLOG_DEBUG(4) << "sent " << get_device_name() <<  " info";
-        ++m_sent_counter;
+        ++m_counters.info_sent;
         was_successfully_sent = true;
       }
       catch (const dunedaq::iomanager::TimeoutExpired& excpt)
       {
         ers::error(DeviceInfoSendFailed(ERS_HERE, m_device_name, m_device_info_connection_id));
-        ++m_failed_to_send_counter;
+        ++m_counters.info_send_failures;
       }
     }
   }
@@ -220,16 +257,28 @@ protected:
   std::string m_device_name;
   std::atomic<time_t> m_last_gathered_time;
   int m_op_mon_level;
-  //  std::unique_ptr<opmonlib::InfoCollector> m_info_collector;
-  std::unique_ptr<timing::timingfirmwareinfo::TimingDeviceInfo> m_device_info;
+  std::shared_ptr<const timing::timingfirmwareinfo::TimingDeviceInfo> m_device_info; ///< may be shared with the other gatherers of the device
   mutable std::mutex m_info_collector_mutex;
   std::function<void(InfoGatherer&)> m_gather_data;
   std::string m_device_info_connection_id;
   using sink_t = dunedaq::iomanager::SenderConcept<nlohmann::json>;
   std::shared_ptr<sink_t> m_hw_info_sender;
-  std::atomic<uint> m_sent_counter;
-  std::atomic<uint> m_failed_to_send_counter;
+
+  // written by the gathering thread only; each gatherer's counters on their own cache line
+  struct alignas(64) GatherCounters
+  {
+    std::atomic<uint64_t> gathers_done{ 0 };           // NOLINT(build/unsigned)
+    std::atomic<uint64_t> gathers_failed{ 0 };         // NOLINT(build/unsigned)
+    std::atomic<uint64_t> last_gather_latency_us{ 0 }; // NOLINT(build/unsigned)
+    std::atomic<uint64_t> info_sent{ 0 };              // NOLINT(build/unsigned)
+    std::atomic<uint64_t> info_send_failures{ 0 };     // NOLINT(build/unsigned)
+    std::atomic<uint64_t> shared_gathers{ 0 };         // NOLINT(build/unsigned)
+  };
+  GatherCounters m_counters;
   std::chrono::milliseconds m_queue_timeout;
+  std::shared_ptr<HardwareJournal> m_journal;
+  std::shared_ptr<HardwareFingerprintStore> m_fingerprints;
+  std::function<std::vector<std::string>(const std::string&)> m_get_endpoint_scan_sets;
 };
 
 } // namespace timinglibs
@@ -0,0 +1,195 @@
+/**
+ * @file LinkWatchdog.cpp LinkWatchdog class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "LinkWatchdog.hpp"
+#include "SlicedSleep.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "iomanager/IOManager.hpp"
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+LinkWatchdog::LinkWatchdog(TimingDeviceBackend& backend,
+                           const std::vector<std::string>& devices,
+                           std::chrono::microseconds poll_period)
+  : m_backend(backend)
+  , m_poll_period(std::max(poll_period, std::chrono::microseconds(1)))
+  , m_send_timeout(1)
+  , m_thread(std::bind(&LinkWatchdog::run_watchdog, this, std::placeholders::_1))
+{
+  for (auto& device : devices) {
+    Device watched_device{ DeviceStats{ device, 0, 0, 0, 0, 0, 0, false }, device + "_link_events", nullptr, false, false };
+    try {
+      watched_device.event_sender = iomanager::IOManager::get()->get_sender<nlohmann::json>(watched_device.event_connection);
+    } catch (const ers::Issue& excpt) {
+      // the link state is still published to opmon
+      ers::warning(LinkWatchdogIssue(
+        ERS_HERE, device, "no " + watched_device.event_connection + " connection, link events are not sent", excpt));
+    }
+    m_devices.push_back(std::move(watched_device));
+  }
+}
+
+LinkWatchdog::~LinkWatchdog()
+{
+  stop();
+}
+
+void
+LinkWatchdog::start(const ThreadPlacement& placement)
+{
+  if (m_thread.thread_running()) {
+    return;
+  }
+  m_placement = placement;
+  m_thread.start_working_thread(m_placement.get_name());
+}
+
+void
+LinkWatchdog::stop()
+{
+  if (m_thread.thread_running()) {
+    m_thread.stop_working_thread();
+  }
+}
+
+void
+LinkWatchdog::pause_device(const std::string& device)
+{
+  std::lock_guard<std::mutex> pause_lock(m_pause_mutex);
+  m_paused_devices.insert(device);
+}
+
+void
+LinkWatchdog::resume_device(const std::string& device)
+{
+  std::lock_guard<std::mutex> pause_lock(m_pause_mutex);
+  m_paused_devices.erase(device);
+}
+
+std::vector<LinkWatchdog::DeviceStats>
+LinkWatchdog::get_stats() const
+{
+  std::vector<DeviceStats> stats;
+  std::lock_guard<std::mutex> stats_lock(m_stats_mutex);
+  for (auto& device : m_devices) {
+    stats.push_back(device.stats);
+  }
+  return stats;
+}
+
+void
+LinkWatchdog::run_watchdog(std::atomic<bool>& running_flag)
+{
+  m_placement.apply(pthread_self());
+  TLOG_DEBUG(0) << "Starting link watchdog of " << m_devices.size() << " devices, poll period "
+                << std::chrono::duration_cast<std::chrono::microseconds>(m_poll_period).count() << " us";
+
+  auto next_poll = clock_t::now();
+  while (running_flag.load()) {
+    for (auto& device : m_devices) {
+      std::lock_guard<std::mutex> pause_lock(m_pause_mutex);
+      if (!m_paused_devices.count(device.stats.device)) {
+        poll(device);
+      }
+    }
+
+    // a round of polls longer than the period starts the next round at once, without catching up the rounds
+    // it overran
+    next_poll += m_poll_period;
+    auto now = clock_t::now();
+    if (next_poll < now) {
+      next_poll = now;
+    }
+    sleep_until_or_stopped(next_poll, running_flag);
+  }
+
+  TLOG_DEBUG(0) << "Link watchdog stopped";
+}
+
+void
+LinkWatchdog::poll(Device& device)
+{
+  LinkState current{ 0, false };
+  try {
+    current = m_backend.read_link_state(device.stats.device);
+  } catch (const std::exception& excpt) {
+    // a device without link keeps failing every poll: warn when it starts, the failures are counted in the stats
+    if (!device.failing) {
+      ers::warning(LinkWatchdogIssue(ERS_HERE, device.stats.device, "reading the link state failed", excpt));
+    }
+    device.failing = true;
+    std::lock_guard<std::mutex> stats_lock(m_stats_mutex);
+    ++device.stats.poll_failures;
+    return;
+  }
+  device.failing = false;
+
+  LinkState previous{ device.stats.state, device.stats.ready };
+  bool changed = device.has_state && (current.state != previous.state || current.ready != previous.ready);
+  device.has_state = true;
+  {
+    std::lock_guard<std::mutex> stats_lock(m_stats_mutex);
+    ++device.stats.polls;
+    device.stats.state = current.state;
+    device.stats.ready = current.ready;
+    if (changed) {
+      ++device.stats.transitions;
+    }
+  }
+
+  if (changed) {
+    TLOG_DEBUG(1) << device.stats.device << " link state changed from 0x" << std::hex << previous.state << " to 0x"
+                  << current.state << std::dec << ", ready: " << previous.ready << " -> " << current.ready;
+    send_event(device, previous, current);
+  }
+}
+
+void
+LinkWatchdog::send_event(Device& device, const LinkState& previous, const LinkState& current)
+{
+  if (!device.event_sender) {
+    return;
+  }
+
+  nlohmann::json event;
+  event["device"] = device.stats.device;
+  event["state"] = current.state;
+  event["ready"] = current.ready;
+  event["previous_state"] = previous.state;
+  event["previous_ready"] = previous.ready;
+  event["detected_at"] =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+  bool sent = true;
+  try {
+    device.event_sender->send(std::move(event), m_send_timeout);
+  } catch (const iomanager::TimeoutExpired& excpt) {
+    ers::warning(LinkWatchdogIssue(ERS_HERE, device.stats.device, "sending a link event failed", excpt));
+    sent = false;
+  }
+  std::lock_guard<std::mutex> stats_lock(m_stats_mutex);
+  ++(sent ? device.stats.events_sent : device.stats.events_failed_to_send);
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
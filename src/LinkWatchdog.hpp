@@ -0,0 +1,127 @@
+/**
+ * @file LinkWatchdog.hpp
+ *
+ * LinkWatchdog polls the link state of timing devices at a high rate and
+ * sends an event on each change, from a dedicated thread.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_LINKWATCHDOG_HPP_
+#define TIMINGLIBS_SRC_LINKWATCHDOG_HPP_
+
+#include "ThreadPlacement.hpp"
+#include "TimingDeviceBackend.hpp"
+
+#include "iomanager/Sender.hpp"
+
+#include "nlohmann/json.hpp"
+#include "utilities/WorkerThread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief LinkWatchdog reads the endpoint state and ready bits of each of its
+ * devices every poll period, one transaction per device, so that a lost
+ * link is noticed within about a period instead of at the next gather of
+ * the full device info. Each change of the state or ready bits is sent as
+ * an event to the <device>_link_events connection, if it exists:
+ *
+ *   { "device", "state", "ready", "previous_state", "previous_ready", "detected_at" }
+ *
+ * with detected_at in ns since the epoch. The first read of a device only
+ * sets its reference state. A paused device, e.g. during its io reset, is
+ * not polled.
+ */
+class LinkWatchdog
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  struct DeviceStats
+  {
+    std::string device;
+    uint64_t polls;                 // NOLINT(build/unsigned)
+    uint64_t poll_failures;         // NOLINT(build/unsigned)
+    uint64_t transitions;           // NOLINT(build/unsigned)
+    uint64_t events_sent;           // NOLINT(build/unsigned)
+    uint64_t events_failed_to_send; // NOLINT(build/unsigned)
+    uint32_t state;                 // NOLINT(build/unsigned)
+    bool ready;
+  };
+
+  /**
+   * @brief LinkWatchdog Constructor
+   * @param backend Device access; must outlive the watchdog
+   * @param devices Endpoint, fanout or HSI devices to watch
+   */
+  LinkWatchdog(TimingDeviceBackend& backend, const std::vector<std::string>& devices, std::chrono::microseconds poll_period);
+  ~LinkWatchdog();
+
+  LinkWatchdog(const LinkWatchdog&) = delete;            ///< LinkWatchdog is not copy-constructible
+  LinkWatchdog& operator=(const LinkWatchdog&) = delete; ///< LinkWatchdog is not copy-assignable
+  LinkWatchdog(LinkWatchdog&&) = delete;                 ///< LinkWatchdog is not move-constructible
+  LinkWatchdog& operator=(LinkWatchdog&&) = delete;      ///< LinkWatchdog is not move-assignable
+
+  void start(const ThreadPlacement& placement);
+  void stop();
+
+  /**
+   * @brief Stop polling a device, once the poll in flight, if any, is done
+   */
+  void pause_device(const std::string& device);
+  void resume_device(const std::string& device);
+
+  std::vector<DeviceStats> get_stats() const;
+
+private:
+  using sink_t = iomanager::SenderConcept<nlohmann::json>;
+
+  struct Device
+  {
+    DeviceStats stats;
+    std::string event_connection;
+    std::shared_ptr<sink_t> event_sender;
+    bool has_state;
+    bool failing;
+  };
+
+  void run_watchdog(std::atomic<bool>& running_flag);
+  void poll(Device& device);
+  void send_event(Device& device, const LinkState& previous, const LinkState& current);
+
+  TimingDeviceBackend& m_backend;
+  clock_t::duration m_poll_period;
+  std::chrono::milliseconds m_send_timeout;
+
+  std::vector<Device> m_devices;
+  mutable std::mutex m_stats_mutex;
+
+  // held during each poll, so that a device is not accessed once paused
+  std::set<std::string> m_paused_devices;
+  std::mutex m_pause_mutex;
+
+  ThreadPlacement m_placement;
+  dunedaq::utilities::WorkerThread m_thread;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_LINKWATCHDOG_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,120 @@
+/**
+ * @file MappedFile.cpp MappedFile class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "MappedFile.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+MappedFile::MappedFile(const std::string& path, Access access)
+  : m_path(path)
+  , m_access(access)
+  , m_fd(-1)
+  , m_data(nullptr)
+  , m_mapped_size(0)
+{
+  m_fd = access == Access::kReadWrite ? ::open(m_path.c_str(), O_RDWR | O_CREAT, 0644) : ::open(m_path.c_str(), O_RDONLY);
+  if (m_fd < 0) {
+    throw MappedFileIssue(ERS_HERE, m_path, std::string("failed to open: ") + std::strerror(errno));
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  unmap();
+  ::close(m_fd);
+}
+
+size_t
+MappedFile::get_file_size() const
+{
+  struct stat file_stat;
+  if (::fstat(m_fd, &file_stat) != 0) {
+    throw MappedFileIssue(ERS_HERE, m_path, std::string("failed to stat: ") + std::strerror(errno));
+  }
+  return static_cast<size_t>(file_stat.st_size);
+}
+
+bool
+MappedFile::read(void* buffer, size_t size, size_t offset) const
+{
+  return ::pread(m_fd, buffer, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+}
+
+void
+MappedFile::map(size_t size)
+{
+  // the previous mapping is only released once the new one is in place, so that a failure leaves it usable
+  int protection = PROT_READ;
+  size_t previous_file_size = 0;
+  if (m_access == Access::kReadWrite) {
+    previous_file_size = get_file_size();
+    if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+      throw MappedFileIssue(ERS_HERE, m_path, std::string("failed to resize: ") + std::strerror(errno));
+    }
+    protection |= PROT_WRITE;
+  }
+  void* data = ::mmap(nullptr, size, protection, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED) {
+    auto map_errno = errno;
+    if (m_access == Access::kReadWrite) {
+      // best effort: the previous mapping stays valid as long as the file covers it
+      static_cast<void>(::ftruncate(m_fd, static_cast<off_t>(previous_file_size)));
+    }
+    throw MappedFileIssue(ERS_HERE, m_path, std::string("failed to map: ") + std::strerror(map_errno));
+  }
+  unmap();
+  m_data = static_cast<uint8_t*>(data); // NOLINT(build/unsigned)
+  m_mapped_size = size;
+}
+
+void
+MappedFile::unmap()
+{
+  if (m_data) {
+    ::munmap(m_data, m_mapped_size);
+    m_data = nullptr;
+    m_mapped_size = 0;
+  }
+}
+
+void
+MappedFile::sync(bool wait)
+{
+  if (m_data) {
+    ::msync(m_data, m_mapped_size, wait ? MS_SYNC : MS_ASYNC);
+  }
+}
+
+void
+MappedFile::truncate(size_t size)
+{
+  unmap();
+  if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+    throw MappedFileIssue(ERS_HERE, m_path, std::string("failed to truncate: ") + std::strerror(errno));
+  }
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,91 @@
+/**
+ * @file MappedFile.hpp
+ *
+ * MappedFile owns an open file and its memory mapping, for the file backed
+ * stores of timinglibs (hardware journal, endpoint delay store).
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_MAPPEDFILE_HPP_
+#define TIMINGLIBS_SRC_MAPPEDFILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief MappedFile opens a file, and maps it shared, read-only or
+ * read-write. The mapping is released and the file closed on destruction,
+ * including when the owner fails to construct. Failures throw
+ * MappedFileIssue. Not thread safe.
+ */
+class MappedFile
+{
+public:
+  enum class Access
+  {
+    kReadOnly,
+    kReadWrite, ///< the file is created if it does not exist
+  };
+
+  MappedFile(const std::string& path, Access access);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;            ///< MappedFile is not copy-constructible
+  MappedFile& operator=(const MappedFile&) = delete; ///< MappedFile is not copy-assignable
+  MappedFile(MappedFile&&) = delete;                 ///< MappedFile is not move-constructible
+  MappedFile& operator=(MappedFile&&) = delete;      ///< MappedFile is not move-assignable
+
+  size_t get_file_size() const;
+
+  /**
+   * @brief Read from the file, mapped or not
+   * @return false if fewer than size bytes could be read
+   */
+  bool read(void* buffer, size_t size, size_t offset) const;
+
+  /**
+   * @brief Map the first size bytes of the file, replacing any previous mapping. With read-write access the file
+   * is resized to size first, so it can be used to grow the mapping. On failure, the previous mapping, if any, and
+   * the size of the file are kept.
+   */
+  void map(size_t size);
+  void unmap();
+
+  /**
+   * @brief Write the mapped pages back to the file
+   * @param wait Whether to wait for the write to finish
+   */
+  void sync(bool wait);
+
+  /**
+   * @brief Unmap, and cut the file to size bytes
+   */
+  void truncate(size_t size);
+
+  uint8_t* get_data() const { return m_data; } // NOLINT(build/unsigned)
+  size_t get_mapped_size() const { return m_mapped_size; }
+  const std::string& get_path() const { return m_path; }
+
+private:
+  std::string m_path;
+  Access m_access;
+  int m_fd;
+  uint8_t* m_data; // NOLINT(build/unsigned)
+  size_t m_mapped_size;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_MAPPEDFILE_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,235 @@
+/**
+ * @file MasterTimestampEstimator.cpp MasterTimestampEstimator class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "timinglibs/MasterTimestampEstimator.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace dunedaq {
+namespace timinglibs {
+
+namespace {
+std::mutex&
+registry_mutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, std::weak_ptr<const MasterTimestampEstimator>>&
+registry()
+{
+  static std::map<std::string, std::weak_ptr<const MasterTimestampEstimator>> estimators;
+  return estimators;
+}
+} // namespace
+
+MasterTimestampEstimator::MasterTimestampEstimator(size_t window,
+                                                   size_t min_samples,
+                                                   clock_t::duration max_extrapolation)
+  : m_window(std::max<size_t>(window, 2))
+  , m_min_samples(std::clamp<size_t>(min_samples, 2, m_window))
+  , m_max_extrapolation_ns(std::chrono::duration_cast<std::chrono::nanoseconds>(max_extrapolation).count())
+{
+}
+
+int64_t
+MasterTimestampEstimator::to_ns(clock_t::time_point time)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void
+MasterTimestampEstimator::add_sample(uint64_t timestamp, clock_t::time_point arrival) // NOLINT(build/unsigned)
+{
+  std::lock_guard<std::mutex> lock(m_samples_mutex);
+
+  auto host_ns = to_ns(arrival);
+  if (!m_samples.empty()) {
+    auto& last = m_samples.back();
+    bool consistent = timestamp > last.timestamp && host_ns > last.host_ns;
+    if (consistent) {
+      double expected_ticks = (host_ns - last.host_ns) * s_nominal_clock_frequency * 1e-9;
+      double ticks = static_cast<double>(timestamp - last.timestamp);
+      consistent = std::abs(ticks - expected_ticks) <= s_max_frequency_offset * expected_ticks + s_max_arrival_jitter_ticks;
+    }
+    if (!consistent) {
+      TLOG_DEBUG(3) << "Master timestamp 0x" << std::hex << timestamp << " inconsistent with previous 0x"
+                    << last.timestamp << std::dec << ", restarting timestamp estimation";
+      m_samples.clear();
+    }
+  }
+
+  m_samples.push_back({ host_ns, timestamp });
+  if (m_samples.size() > m_window) {
+    m_samples.pop_front();
+  }
+  fit();
+}
+
+void
+MasterTimestampEstimator::reset()
+{
+  std::lock_guard<std::mutex> lock(m_samples_mutex);
+  m_samples.clear();
+  store_model(Model());
+}
+
+void
+MasterTimestampEstimator::fit()
+{
+  Model model;
+  model.last_sample_ns = m_samples.back().host_ns;
+
+  auto n = m_samples.size();
+  if (n < 2) {
+    store_model(model);
+    return;
+  }
+
+  // work relative to the first sample, where doubles are exact enough
+  auto& first = m_samples.front();
+  double mean_x = 0;
+  double mean_y = 0;
+  for (auto& sample : m_samples) {
+    mean_x += sample.host_ns - first.host_ns;
+    mean_y += static_cast<double>(sample.timestamp - first.timestamp);
+  }
+  mean_x /= n;
+  mean_y /= n;
+
+  double sxx = 0;
+  double sxy = 0;
+  for (auto& sample : m_samples) {
+    double dx = (sample.host_ns - first.host_ns) - mean_x;
+    double dy = static_cast<double>(sample.timestamp - first.timestamp) - mean_y;
+    sxx += dx * dx;
+    sxy += dx * dy;
+  }
+  double slope = sxy / sxx;
+
+  double residual = 0;
+  double squared_residuals = 0;
+  for (auto& sample : m_samples) {
+    double dx = (sample.host_ns - first.host_ns) - mean_x;
+    double r = static_cast<double>(sample.timestamp - first.timestamp) - (mean_y + slope * dx);
+    residual = std::max(residual, std::abs(r));
+    squared_residuals += r * r;
+  }
+
+  auto anchor_x = std::llround(mean_x);
+  model.valid = n >= m_min_samples;
+  model.anchor_ns = first.host_ns + anchor_x;
+  model.anchor_timestamp = first.timestamp + std::llround(mean_y + slope * (anchor_x - mean_x));
+  model.slope = slope;
+  model.residual = residual;
+  model.slope_error = n > 2 ? std::sqrt(squared_residuals / (n - 2) / sxx) : 0;
+  store_model(model);
+}
+
+void
+MasterTimestampEstimator::store_model(const Model& model)
+{
+  // single writer, serialised by m_samples_mutex
+  m_model_sequence.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  m_model_valid.store(model.valid, std::memory_order_relaxed);
+  m_anchor_ns.store(model.anchor_ns, std::memory_order_relaxed);
+  m_anchor_timestamp.store(model.anchor_timestamp, std::memory_order_relaxed);
+  m_slope.store(model.slope, std::memory_order_relaxed);
+  m_residual.store(model.residual, std::memory_order_relaxed);
+  m_slope_error.store(model.slope_error, std::memory_order_relaxed);
+  m_last_sample_ns.store(model.last_sample_ns, std::memory_order_relaxed);
+  m_model_sequence.fetch_add(1, std::memory_order_release);
+}
+
+MasterTimestampEstimator::Model
+MasterTimestampEstimator::load_model() const
+{
+  Model model;
+  while (true) {
+    auto sequence = m_model_sequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      continue;
+    }
+    model.valid = m_model_valid.load(std::memory_order_relaxed);
+    model.anchor_ns = m_anchor_ns.load(std::memory_order_relaxed);
+    model.anchor_timestamp = m_anchor_timestamp.load(std::memory_order_relaxed);
+    model.slope = m_slope.load(std::memory_order_relaxed);
+    model.residual = m_residual.load(std::memory_order_relaxed);
+    model.slope_error = m_slope_error.load(std::memory_order_relaxed);
+    model.last_sample_ns = m_last_sample_ns.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_model_sequence.load(std::memory_order_relaxed) == sequence) {
+      return model;
+    }
+  }
+}
+
+MasterTimestampEstimator::Estimate
+MasterTimestampEstimator::estimate(clock_t::time_point when) const
+{
+  Estimate estimate;
+  auto model = load_model();
+
+  auto when_ns = to_ns(when);
+  if (!model.valid || when_ns - model.last_sample_ns > m_max_extrapolation_ns) {
+    return estimate;
+  }
+
+  auto dt = static_cast<double>(when_ns - model.anchor_ns);
+  estimate.valid = true;
+  estimate.timestamp = model.anchor_timestamp + std::llround(model.slope * dt);
+  // largest residual seen, plus three standard errors of the slope over the extrapolation
+  estimate.error = static_cast<uint64_t>(std::ceil(model.residual + 3 * model.slope_error * std::abs(dt))); // NOLINT(build/unsigned)
+  return estimate;
+}
+
+double
+MasterTimestampEstimator::get_clock_frequency() const
+{
+  auto model = load_model();
+  return model.valid ? model.slope * 1e9 : 0;
+}
+
+void
+MasterTimestampEstimator::publish(const std::string& device, std::shared_ptr<const MasterTimestampEstimator> estimator)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  registry()[device] = estimator;
+}
+
+void
+MasterTimestampEstimator::withdraw(const std::string& device)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  registry().erase(device);
+}
+
+std::shared_ptr<const MasterTimestampEstimator>
+MasterTimestampEstimator::find(const std::string& device)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex());
+  auto estimator = registry().find(device);
+  return estimator == registry().end() ? nullptr : estimator->second.lock();
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
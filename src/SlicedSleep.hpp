@@ -0,0 +1,53 @@
+/**
+ * @file SlicedSleep.hpp
+ *
+ * Sleep of the worker threads of timinglibs, which notices that the thread
+ * is stopped while sleeping.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_SLICEDSLEEP_HPP_
+#define TIMINGLIBS_SRC_SLICEDSLEEP_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Sleep until wake_time, in slices of 10 ms, checking running_flag between slices
+ * @return false if running_flag was cleared, possibly before wake_time
+ */
+template<typename Clock, typename Duration>
+bool
+sleep_until_or_stopped(const std::chrono::time_point<Clock, Duration>& wake_time, const std::atomic<bool>& running_flag)
+{
+  auto slice_period = std::chrono::microseconds(10000);
+  auto next_slice_time = Clock::now() + slice_period;
+  while (next_slice_time < wake_time) {
+    if (!running_flag.load()) {
+      return false;
+    }
+    std::this_thread::sleep_until(next_slice_time);
+    next_slice_time += slice_period;
+  }
+  if (!running_flag.load()) {
+    return false;
+  }
+  std::this_thread::sleep_until(wake_time);
+  return running_flag.load();
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_SLICEDSLEEP_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,172 @@
+/**
+ * @file ThreadPlacement.cpp ThreadPlacement class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "ThreadPlacement.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <sched.h>
+
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+namespace {
+constexpr size_t s_max_thread_name_length = 15;
+} // namespace
+
+ThreadPlacement::ThreadPlacement(const std::string& name,
+                                 const std::vector<unsigned>& cpus, // NOLINT(build/unsigned)
+                                 int fifo_priority)
+  : m_name(name)
+  , m_cpus(cpus)
+  , m_fifo_priority(fifo_priority)
+{
+}
+
+std::string
+ThreadPlacement::get_name(const std::string& instance) const
+{
+  auto name = instance.empty() ? m_name : m_name + "-" + instance;
+  return name.substr(0, s_max_thread_name_length);
+}
+
+std::string
+ThreadPlacement::describe() const
+{
+  std::ostringstream description;
+  description << m_name << ", cpus:";
+  if (m_cpus.empty()) {
+    description << " any";
+  }
+  for (auto cpu : m_cpus) {
+    description << " " << cpu;
+  }
+  description << ", fifo priority: " << m_fifo_priority;
+  return description.str();
+}
+
+std::string
+ThreadPlacement::try_apply(pthread_t thread, const std::string& instance) const
+{
+  std::ostringstream failures;
+
+  auto name = get_name(instance);
+  if (auto rc = pthread_setname_np(thread, name.c_str()); rc != 0) {
+    failures << "setting the name " << name << ": " << std::strerror(rc) << "; ";
+  }
+
+  if (!m_cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (auto cpu : m_cpus) {
+      CPU_SET(cpu, &cpu_set);
+    }
+    if (auto rc = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set); rc != 0) {
+      failures << "setting the cpu affinity: " << std::strerror(rc) << "; ";
+    }
+  }
+
+  if (m_fifo_priority) {
+    sched_param param{};
+    param.sched_priority = m_fifo_priority;
+    if (auto rc = pthread_setschedparam(thread, SCHED_FIFO, &param); rc != 0) {
+      failures << "setting SCHED_FIFO priority " << m_fifo_priority << ": " << std::strerror(rc) << "; ";
+    }
+  }
+
+  return failures.str();
+}
+
+void
+ThreadPlacement::apply(pthread_t thread, const std::string& instance) const
+{
+  auto failures = try_apply(thread, instance);
+  if (!failures.empty()) {
+    ers::warning(ThreadPlacementIssue(ERS_HERE, get_name(instance), failures));
+  }
+}
+
+ThreadPlacements::ThreadPlacements(std::initializer_list<std::pair<const std::string, std::string>> roles)
+  : m_default_names(roles)
+{
+}
+
+void
+ThreadPlacements::configure(const std::vector<const dal::TimingThreadPlacement*>& placements)
+{
+  m_placements.clear();
+  for (auto placement : placements) {
+    auto& role = placement->get_role();
+    auto default_name = m_default_names.find(role);
+    if (default_name == m_default_names.end()) {
+      // placements may be shared by modules with different thread roles
+      TLOG_DEBUG(1) << "No " << role << " threads, skipping thread placement " << placement->UID();
+      continue;
+    }
+    if (m_placements.count(role)) {
+      throw InvalidThreadPlacement(ERS_HERE, role, "more than one placement for the role");
+    }
+
+    std::vector<unsigned> cpus; // NOLINT(build/unsigned)
+    for (auto cpu : placement->get_cpus()) {
+      if (cpu >= CPU_SETSIZE) {
+        throw InvalidThreadPlacement(ERS_HERE, role, "no cpu " + std::to_string(cpu));
+      }
+      cpus.push_back(cpu);
+    }
+    int fifo_priority = placement->get_fifo_priority();
+    if (fifo_priority &&
+        (fifo_priority < sched_get_priority_min(SCHED_FIFO) || fifo_priority > sched_get_priority_max(SCHED_FIFO))) {
+      throw InvalidThreadPlacement(ERS_HERE, role, "fifo priority " + std::to_string(fifo_priority) + " out of range");
+    }
+
+    ThreadPlacement thread_placement(
+      placement->get_name().empty() ? default_name->second : placement->get_name(), cpus, fifo_priority);
+
+    // applied to a thread that only waits, so that the host limits are found now
+    std::promise<void> release;
+    auto released = release.get_future();
+    std::thread probe([&released] { released.wait(); });
+    auto failures = thread_placement.try_apply(probe.native_handle());
+    release.set_value();
+    probe.join();
+    if (!failures.empty()) {
+      throw InvalidThreadPlacement(ERS_HERE, role, failures);
+    }
+
+    TLOG() << "Threads of role " << role << ": " << thread_placement.describe();
+    m_placements.emplace(role, std::move(thread_placement));
+  }
+}
+
+ThreadPlacement
+ThreadPlacements::get(const std::string& role) const
+{
+  if (auto placement = m_placements.find(role); placement != m_placements.end()) {
+    return placement->second;
+  }
+  auto default_name = m_default_names.find(role);
+  return ThreadPlacement(default_name != m_default_names.end() ? default_name->second : role);
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
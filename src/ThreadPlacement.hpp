@@ -0,0 +1,96 @@
+/**
+ * @file ThreadPlacement.hpp
+ *
+ * ThreadPlacement names the threads of the timinglibs modules and places
+ * them on the CPUs and with the scheduling configured for their role.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_THREADPLACEMENT_HPP_
+#define TIMINGLIBS_SRC_THREADPLACEMENT_HPP_
+
+#include "timinglibs/dal/TimingThreadPlacement.hpp"
+
+#include <pthread.h>
+
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief ThreadPlacement is the name, CPU affinity and scheduling of a
+ * thread. Without CPUs the thread keeps the affinity of the process, and
+ * without a priority the default scheduling.
+ */
+class ThreadPlacement
+{
+public:
+  explicit ThreadPlacement(const std::string& name = "timinglibs",
+                           const std::vector<unsigned>& cpus = {}, // NOLINT(build/unsigned)
+                           int fifo_priority = 0);
+
+  /**
+   * @brief Apply to a thread, with a ThreadPlacementIssue warning if any of it cannot be applied
+   * @param instance Appended to the name, e.g. the device the thread works for. Names are cut to the 15 characters
+   * allowed by the system.
+   */
+  void apply(pthread_t thread, const std::string& instance = "") const;
+
+  /**
+   * @brief Apply to a thread
+   * @return What could not be applied, empty if all of it was
+   */
+  std::string try_apply(pthread_t thread, const std::string& instance = "") const;
+
+  std::string get_name(const std::string& instance = "") const;
+  std::string describe() const;
+
+private:
+  std::string m_name;
+  std::vector<unsigned> m_cpus; // NOLINT(build/unsigned)
+  int m_fifo_priority;
+};
+
+/**
+ * @brief ThreadPlacements holds the placements of the thread roles of a
+ * module, read from its thread_placements configuration. Roles without a
+ * placement only get their default name.
+ */
+class ThreadPlacements
+{
+public:
+  /**
+   * @param roles Thread roles of the module, with the default name of their threads
+   */
+  explicit ThreadPlacements(std::initializer_list<std::pair<const std::string, std::string>> roles);
+
+  /**
+   * @brief Replace the placements by the configured ones. Each is applied to a probe thread first, so that a
+   * placement the host does not allow, e.g. a missing CPU or a FIFO priority without the privilege for it, throws
+   * InvalidThreadPlacement here rather than leaving the threads unplaced.
+   */
+  void configure(const std::vector<const dal::TimingThreadPlacement*>& placements);
+
+  ThreadPlacement get(const std::string& role) const;
+
+private:
+  std::map<std::string, std::string> m_default_names;
+  std::map<std::string, ThreadPlacement> m_placements;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_THREADPLACEMENT_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
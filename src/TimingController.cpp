@@ -8,10 +8,13 @@
  */
 
 #include "timinglibs/TimingController.hpp"
+#include "ContentHash.hpp"
 #include "timinglibs/timingcmd/Nljs.hpp"
 #include "timinglibs/timingcmd/Structs.hpp"
 #include "timinglibs/timingcmd/msgp.hpp"
 #include "timinglibs/TimingIssues.hpp"
+#include "timinglibs/opmon/timingcontroller.pb.h"
+#include "timinglibs/dal/TimingDeviceRoute.hpp"
 
 #include "appfwk/cmd/Nljs.hpp"
 #include "ers/Issue.hpp"
@@ -21,6 +24,9 @@
 
 #include <chrono>
 #include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -32,7 +38,7 @@ DUNE_DAQ_SERIALIZABLE(nlohmann::json, "JSON");
 
 namespace timinglibs {
 
-TimingController::TimingController(const std::string& name, uint number_hw_commands)
+TimingController::TimingController(const std::string& name)
   : dunedaq::appfwk::DAQModule(name)
   , m_hw_command_out_connection("timing_cmds")
   , m_hw_cmd_out_timeout(100)
@@ -40,19 +46,18 @@ TimingController::TimingController(const std::string& name, uint number_hw_comma
   , m_timing_device("")
   , m_timing_session_name("")
   , m_device_info_receiver(nullptr)
-  , m_number_hw_commands(number_hw_commands)
-  , m_sent_hw_command_counters(m_number_hw_commands)
+  , m_link_event_receiver(nullptr)
   , m_device_ready_timeout(10000)
   , m_device_ready(false)
   , m_device_infos_received_count(0)
   , m_hardware_state_recovery_enabled(false)
+  , m_device_config_fingerprint_matches(false)
+  , m_device_config_fingerprint_checked(false)
 {
-  for (auto it = m_sent_hw_command_counters.begin(); it != m_sent_hw_command_counters.end(); ++it) {
-    it->atomic.store(0);
-  }
-
-  register_command("io_reset", &TimingController::do_io_reset);
-  register_command("print_status", &TimingController::do_print_status);
+  register_hw_command(ControllerHwCmd::kIOReset, &TimingController::do_io_reset);
+  register_hw_command(ControllerHwCmd::kPrintStatus, &TimingController::do_print_status);
+  register_hw_command(ControllerHwCmd::kRegisterWatchpoints, &TimingController::do_register_watchpoints);
+  register_hw_command(ControllerHwCmd::kUnregisterWatchpoints, &TimingController::do_unregister_watchpoints);
 }
 
 void
@@ -74,28 +79,63 @@ TimingController::do_configure(const nlohmann::json& data)
     throw UHALDeviceNameIssue(ERS_HERE, "Device name should not be empty");
   }
 
+  m_device_config_fingerprint_matches = false;
+  m_device_config_fingerprint_checked = false;
+  m_config_fingerprint.clear();
+  if (m_params->get_skip_unchanged_configuration())
+  {
+    auto components = get_config_fingerprint_components().dump();
+    m_config_fingerprint = to_hex(fnv1a_hash(components));
+    TLOG_DEBUG(3) << get_name() << " configuration fingerprint " << m_config_fingerprint << " of " << components;
+  }
+
+  // routes only select the hw command connection; whichever hardware manager owns the device publishes
+  // its infos and link events on <device>_info and <device>_link_events
+  m_hw_command_routes.clear();
+  for (auto route : m_params->get_device_routes())
+  {
+    TLOG_DEBUG(3) << get_name() << " hw commands for " << route->get_device() << " are routed to " << route->get_hw_cmd_connection();
+    m_hw_command_routes[route->get_device()] = { route->get_hw_cmd_connection(), get_hw_command_sender(route->get_hw_cmd_connection()) };
+  }
+  std::string device_info_connection = m_timing_device + "_info";
+
   if (!m_hw_command_out_connection.empty())
   {
-    if (m_timing_session_name.empty())
+    // with a route for the managed device, the default connection may not exist at all
+    if (m_hw_command_routes.count(m_timing_device))
     {
-      m_hw_command_sender = iomanager::IOManager::get()->get_sender<timingcmd::TimingHwCmd>(m_hw_command_out_connection);
+      m_hw_command_sender = nullptr;
     }
     else
     {
-      m_hw_command_sender = iomanager::IOManager::get()->get_sender<timingcmd::TimingHwCmd>(
-        iomanager::ConnectionId{m_hw_command_out_connection, datatype_to_string<timingcmd::TimingHwCmd>(), m_timing_session_name} );
+      m_hw_command_sender = get_hw_command_sender(m_hw_command_out_connection);
     }
   
     if (m_timing_session_name.empty())
     {
-       m_device_info_receiver = iomanager::IOManager::get()->get_receiver<nlohmann::json>(m_timing_device+"_info");
+       m_device_info_receiver = iomanager::IOManager::get()->get_receiver<nlohmann::json>(device_info_connection);
     }
     else
     {
       m_device_info_receiver = iomanager::IOManager::get()->get_receiver<nlohmann::json>(
-        iomanager::ConnectionId{m_timing_device+"_info", datatype_to_string<nlohmann::json>(), m_timing_session_name});
+        iomanager::ConnectionId{device_info_connection, datatype_to_string<nlohmann::json>(), m_timing_session_name});
+    }
+    m_device_info_receiver->add_callback(std::bind(&TimingController::receive_device_info, this, std::placeholders::_1));
+
+    if (m_params->get_receive_link_events())
+    {
+      std::string link_event_connection = m_timing_device + "_link_events";
+      if (m_timing_session_name.empty())
+      {
+        m_link_event_receiver = iomanager::IOManager::get()->get_receiver<nlohmann::json>(link_event_connection);
+      }
+      else
+      {
+        m_link_event_receiver = iomanager::IOManager::get()->get_receiver<nlohmann::json>(
+          iomanager::ConnectionId{link_event_connection, datatype_to_string<nlohmann::json>(), m_timing_session_name});
+      }
+      m_link_event_receiver->add_callback(std::bind(&TimingController::process_link_event, this, std::placeholders::_1));
     }
-    m_device_info_receiver->add_callback(std::bind(&TimingController::process_device_info, this, std::placeholders::_1));
   }
 }
 
@@ -106,27 +146,53 @@ TimingController::do_scrap(const nlohmann::json&)
   {
     m_device_info_receiver->remove_callback();
   }
+  if (m_link_event_receiver)
+  {
+    m_link_event_receiver->remove_callback();
+    m_link_event_receiver = nullptr;
+  }
   m_device_infos_received_count=0;
   m_device_ready = false;
+  m_device_config_fingerprint_matches = false;
+  m_device_config_fingerprint_checked = false;
   
-  for (auto it = m_sent_hw_command_counters.begin(); it != m_sent_hw_command_counters.end(); ++it)
+  for (auto& counter : m_sent_hw_command_counters)
   {
-    it->atomic.store(0);
+    counter.value.store(0);
   }
 }
 
+std::shared_ptr<TimingController::sink_t>
+TimingController::get_hw_command_sender(const std::string& connection) const
+{
+  if (m_timing_session_name.empty())
+  {
+    return iomanager::IOManager::get()->get_sender<timingcmd::TimingHwCmd>(connection);
+  }
+  return iomanager::IOManager::get()->get_sender<timingcmd::TimingHwCmd>(
+    iomanager::ConnectionId{connection, datatype_to_string<timingcmd::TimingHwCmd>(), m_timing_session_name} );
+}
+
 void
 TimingController::send_hw_cmd(timingcmd::TimingHwCmd&& hw_cmd)
 {
-  if (!m_hw_command_sender)
+  auto connection = m_hw_command_out_connection;
+  auto sender = m_hw_command_sender;
+  if (auto route = m_hw_command_routes.find(hw_cmd.device); route != m_hw_command_routes.end())
+  {
+    connection = route->second.connection;
+    sender = route->second.sender;
+  }
+
+  if (!sender)
   {
-    throw QueueIsNullFatalError(ERS_HERE, get_name(), m_hw_command_out_connection);
+    throw QueueIsNullFatalError(ERS_HERE, get_name(), connection);
   }
   try {
-    m_hw_command_sender->send(std::move(hw_cmd), m_hw_cmd_out_timeout);
+    sender->send(std::move(hw_cmd), m_hw_cmd_out_timeout);
   } catch (const dunedaq::iomanager::TimeoutExpired& excpt) {
     std::ostringstream oss_warn;
-    oss_warn << "push to output queue \"" << m_hw_command_out_connection << "\"";
+    oss_warn << "push to output queue \"" << connection << "\"";
     ers::warning(dunedaq::iomanager::TimeoutExpired(
       ERS_HERE,
       get_name(),
@@ -135,6 +201,77 @@ TimingController::send_hw_cmd(timingcmd::TimingHwCmd&& hw_cmd)
   }
 }
 
+void
+TimingController::send_hw_cmd(ControllerHwCmd cmd, const nlohmann::json& payload)
+{
+  send_hw_cmd(construct_hw_cmd(std::string(describe(cmd).hw_cmd_id), payload));
+  m_sent_hw_command_counters[to_index(cmd)].value.fetch_add(1, std::memory_order_relaxed);
+}
+
+void
+TimingController::generate_opmon_data()
+{
+  for (auto& descriptor : s_controller_hw_cmds)
+  {
+    auto sent = m_sent_hw_command_counters[to_index(descriptor.cmd)].value.load(std::memory_order_relaxed);
+    // internally sent commands are never registered
+    if (!m_registered_hw_commands.test(to_index(descriptor.cmd)) && !sent)
+    {
+      continue;
+    }
+    opmon::TimingControllerHwCmdInfo info;
+    info.set_sent_hw_commands_counter(sent);
+    publish(std::move(info), { { "command", std::string(descriptor.hw_cmd_id) } });
+  }
+}
+
+nlohmann::json
+TimingController::get_config_fingerprint_components() const
+{
+  nlohmann::json components;
+  components["device"] = m_timing_device;
+  components["clock_source"] = m_params->get_clock_source();
+  components["soft"] = m_params->get_soft();
+
+  auto clock_config = m_params->get_clock_config();
+  if (!clock_config.empty())
+  {
+    // the content matters, not the path
+    std::ifstream clock_config_file(clock_config, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(clock_config_file)), std::istreambuf_iterator<char>());
+    components["clock_config"] = clock_config;
+    components["clock_config_hash"] = clock_config_file ? to_hex(fnv1a_hash(content)) : "";
+  }
+  return components;
+}
+
+void
+TimingController::receive_device_info(nlohmann::json info)
+{
+  if (!m_config_fingerprint.empty())
+  {
+    m_device_config_fingerprint_matches = info.value("config_fingerprint", "") == m_config_fingerprint;
+  }
+  process_device_info(std::move(info));
+  // only once the info has set m_device_ready
+  m_device_config_fingerprint_checked = true;
+}
+
+void
+TimingController::process_link_event(nlohmann::json event)
+{
+  bool ready = event.value("ready", false);
+  TLOG_DEBUG(3) << "link event: " << event.dump();
+
+  // the device becomes ready again with the next device info that says so
+  if (!ready && m_device_ready)
+  {
+    m_device_ready = false;
+    TLOG_DEBUG(2) << "Timing device " << m_timing_device << " lost its link, state: 0x" << std::hex
+                  << event.value("state", 0u) << std::dec;
+  }
+}
+
 timingcmd::TimingHwCmd
 TimingController::construct_hw_cmd( const std::string& cmd_id)
 {
@@ -155,23 +292,46 @@ TimingController::construct_hw_cmd( const std::string& cmd_id, const nlohmann::j
 void
 TimingController::do_io_reset(const nlohmann::json& data)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "io_reset", data);
-
-  hw_cmd.payload["clock_source"] = m_params->get_clock_source();
-  hw_cmd.payload["soft"] = m_params->get_soft();
+  nlohmann::json payload = data;
+  payload["clock_source"] = m_params->get_clock_source();
+  payload["soft"] = m_params->get_soft();
 
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(0).atomic);
+  send_hw_cmd(ControllerHwCmd::kIOReset, payload);
 }
 
 void
 TimingController::do_print_status(const nlohmann::json&)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "print_status");
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(1).atomic);
+  send_hw_cmd(ControllerHwCmd::kPrintStatus);
+}
+
+void
+TimingController::do_register_watchpoints(const nlohmann::json& data)
+{
+  // watchpoints registered without a subscriber belong to the controller
+  timingcmd::TimingRegisterWatchpointsCmdPayload payload;
+  timingcmd::from_json(data, payload);
+  if (payload.subscriber.empty()) {
+    payload.subscriber = get_name();
+  }
+
+  nlohmann::json payload_json;
+  timingcmd::to_json(payload_json, payload);
+  send_hw_cmd(ControllerHwCmd::kRegisterWatchpoints, payload_json);
+}
+
+void
+TimingController::do_unregister_watchpoints(const nlohmann::json& data)
+{
+  timingcmd::TimingUnregisterWatchpointsCmdPayload payload;
+  timingcmd::from_json(data, payload);
+  if (payload.subscriber.empty()) {
+    payload.subscriber = get_name();
+  }
+
+  nlohmann::json payload_json;
+  timingcmd::to_json(payload_json, payload);
+  send_hw_cmd(ControllerHwCmd::kUnregisterWatchpoints, payload_json);
 }
 
 } // namespace timinglibs
@@ -0,0 +1,142 @@
+/**
+ * @file TimingDeviceBackend.hpp
+ *
+ * TimingDeviceBackend is the interface through which the hardware manager
+ * talks to timing devices.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_TIMINGDEVICEBACKEND_HPP_
+#define TIMINGLIBS_SRC_TIMINGDEVICEBACKEND_HPP_
+
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include "timing/timingfirmwareinfo/Structs.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief A burst of identical fixed length commands on a channel
+ */
+struct FLCmdWrite
+{
+  uint32_t fl_cmd_id;          // NOLINT(build/unsigned)
+  uint32_t channel;            // NOLINT(build/unsigned)
+  uint32_t number_of_commands; // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief Lock state of the endpoint of a device, as reported in its device info endpoint_info
+ */
+struct LinkState
+{
+  uint32_t state; // NOLINT(build/unsigned)
+  bool ready;
+};
+
+/**
+ * @brief TimingDeviceBackend provides the device operations used by the
+ * hardware manager command handlers and info gatherers. Devices are
+ * identified by their name in the connections file.
+ */
+class TimingDeviceBackend
+{
+public:
+  TimingDeviceBackend() = default;
+  virtual ~TimingDeviceBackend() = default;
+
+  TimingDeviceBackend(const TimingDeviceBackend&) = delete;            ///< TimingDeviceBackend is not copy-constructible
+  TimingDeviceBackend& operator=(const TimingDeviceBackend&) = delete; ///< TimingDeviceBackend is not copy-assignable
+  TimingDeviceBackend(TimingDeviceBackend&&) = delete;                 ///< TimingDeviceBackend is not move-constructible
+  TimingDeviceBackend& operator=(TimingDeviceBackend&&) = delete;      ///< TimingDeviceBackend is not move-assignable
+
+  // common
+  /**
+   * @brief Set up the access to a device ahead of its first operation. Called concurrently for different devices.
+   */
+  virtual void prepare_device(const std::string& /*device*/) {}
+  virtual void io_reset(const std::string& device, const timingcmd::IOResetCmdPayload& payload) = 0;
+  virtual std::string get_status(const std::string& device) = 0;
+  virtual void get_info(const std::string& device, timing::timingfirmwareinfo::TimingDeviceInfo& info) = 0;
+  /**
+   * @brief Read the state and ready bits of the endpoint of an endpoint, fanout or HSI device, in one transaction
+   */
+  virtual LinkState read_link_state(const std::string& device) = 0;
+  /**
+   * @brief Read registers of a device, in one transaction
+   * @param nodes Register node paths, from the top node of the device
+   * @param values Replaced by the values read, in the order of the nodes
+   */
+  virtual void read_registers(const std::string& device,
+                              const std::vector<std::string>& nodes,
+                              std::vector<uint32_t>& values) = 0; // NOLINT(build/unsigned)
+
+  // master
+  virtual void sync_timestamp(const std::string& device, uint32_t timestamp_source) = 0; // NOLINT(build/unsigned)
+  virtual void apply_endpoint_delay(const std::string& device,
+                                    const timingcmd::TimingMasterSetEndpointDelayCmdPayload& payload) = 0;
+  /**
+   * @brief Apply several endpoint delays, in order. Backends override this to share per call overheads.
+   */
+  virtual void apply_endpoint_delays(const std::string& device, const timingcmd::TimingMasterEndpointDelays& delays)
+  {
+    for (auto& delay : delays) {
+      apply_endpoint_delay(device, delay);
+    }
+  }
+  virtual void send_fl_cmd(const std::string& device,
+                           uint32_t fl_cmd_id,               // NOLINT(build/unsigned)
+                           uint32_t channel,                 // NOLINT(build/unsigned)
+                           uint32_t number_of_commands) = 0; // NOLINT(build/unsigned)
+  /**
+   * @brief Send several bursts of fixed length commands, in order. Backends override this to share per call overheads.
+   */
+  virtual void send_fl_cmds(const std::string& device, const std::vector<FLCmdWrite>& fl_cmds)
+  {
+    for (auto& fl_cmd : fl_cmds) {
+      send_fl_cmd(device, fl_cmd.fl_cmd_id, fl_cmd.channel, fl_cmd.number_of_commands);
+    }
+  }
+  /**
+   * @brief Scan one endpoint from the master
+   * @param fanout_device Fanout to route the scan through, empty if the endpoint is connected to the master directly
+   */
+  virtual void scan_endpoint(const std::string& master_device,
+                             const std::string& fanout_device,
+                             const timingcmd::EndpointLocation& location) = 0;
+
+  // endpoint
+  virtual void endpoint_enable(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload) = 0;
+  virtual void endpoint_disable(const std::string& device, uint32_t endpoint_id) = 0; // NOLINT(build/unsigned)
+  virtual void endpoint_reset(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload) = 0;
+
+  // hsi
+  virtual void hsi_reset(const std::string& device) = 0;
+  virtual void hsi_configure(const std::string& device, const timingcmd::HSIConfigureCmdPayload& payload) = 0;
+  virtual void hsi_start(const std::string& device) = 0;
+  virtual void hsi_stop(const std::string& device) = 0;
+  virtual std::string get_hsi_status(const std::string& device) = 0;
+  /**
+   * @brief Read the complete events in the HSI buffer, in one block read
+   * @param words Replaced by the words read, 5 per event; its capacity is reused between reads
+   * @return Buffer occupancy at the time of the read [words]
+   */
+  virtual uint32_t read_hsi_buffer(const std::string& device, std::vector<uint32_t>& words) = 0; // NOLINT(build/unsigned)
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_TIMINGDEVICEBACKEND_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -8,6 +8,7 @@
  */
 
 #include "timinglibs/TimingEndpointControllerBase.hpp"
+#include "DeviceInfoView.hpp"
 #include "timinglibs/dal/TimingEndpointControllerConf.hpp"
 #include "timinglibs/dal/TimingEndpointControllerBase.hpp"
 
@@ -15,9 +16,6 @@
 #include "timinglibs/timingcmd/Nljs.hpp"
 #include "timinglibs/timingcmd/Structs.hpp"
 
-#include "timing/timingfirmwareinfo/Nljs.hpp"
-#include "timing/timingfirmwareinfo/Structs.hpp"
-
 #include "appfwk/cmd/Nljs.hpp"
 #include "ers/Issue.hpp"
 #include "logging/Logging.hpp"
@@ -31,13 +29,13 @@
 namespace dunedaq {
 namespace timinglibs {
 
-TimingEndpointControllerBase::TimingEndpointControllerBase(const std::string& name, uint number_hw_commands)
-  : dunedaq::timinglibs::TimingController(name, number_hw_commands) // 2nd arg: how many hw commands can this module send?
+TimingEndpointControllerBase::TimingEndpointControllerBase(const std::string& name)
+  : dunedaq::timinglibs::TimingController(name)
 {
   // timing endpoint hardware commands
-  register_command("endpoint_enable", &TimingEndpointControllerBase::do_endpoint_enable);
-  register_command("endpoint_disable", &TimingEndpointControllerBase::do_endpoint_disable);
-  register_command("endpoint_reset", &TimingEndpointControllerBase::do_endpoint_reset);
+  register_hw_command(ControllerHwCmd::kEndpointEnable, &TimingEndpointControllerBase::do_endpoint_enable);
+  register_hw_command(ControllerHwCmd::kEndpointDisable, &TimingEndpointControllerBase::do_endpoint_disable);
+  register_hw_command(ControllerHwCmd::kEndpointReset, &TimingEndpointControllerBase::do_endpoint_reset);
 }
 
 void
@@ -63,6 +61,18 @@ TimingEndpointControllerBase::send_configure_hardware_commands(const nlohmann::j
   do_endpoint_enable(data);
 }
 
+nlohmann::json
+TimingEndpointControllerBase::get_config_fingerprint_components() const
+{
+  auto components = TimingController::get_config_fingerprint_components();
+
+  auto mdal = m_params->cast<dal::TimingEndpointControllerConf>();
+  components["endpoint_id"] = mdal->get_endpoint_id();
+  components["address"] = mdal->get_address();
+  components["partition"] = mdal->get_partition();
+  return components;
+}
+
 timingcmd::TimingHwCmd
 TimingEndpointControllerBase::construct_endpoint_hw_cmd( const std::string& cmd_id, uint endpoint_id)
 {
@@ -80,65 +90,35 @@ TimingEndpointControllerBase::construct_endpoint_hw_cmd( const std::string& cmd_
 void
 TimingEndpointControllerBase::do_endpoint_enable(const nlohmann::json& data)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "endpoint_enable", data);
-
   // print out some debug info
   timingcmd::TimingEndpointConfigureCmdPayload cmd_payload;
   timingcmd::from_json(data, cmd_payload);
 
   TLOG_DEBUG(0) << "ept enable hw cmd; a: " << cmd_payload.address;
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(2).atomic);
+  send_hw_cmd(ControllerHwCmd::kEndpointEnable, data);
 }
 
 void
 TimingEndpointControllerBase::do_endpoint_disable(const nlohmann::json& data)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "endpoint_disable", data);
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(3).atomic);
+  send_hw_cmd(ControllerHwCmd::kEndpointDisable, data);
 }
 
 void
 TimingEndpointControllerBase::do_endpoint_reset(const nlohmann::json& data)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "endpoint_reset", data);
-
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(4).atomic);
+  send_hw_cmd(ControllerHwCmd::kEndpointReset, data);
 }
 
-//void
-//TimingEndpointControllerBase::get_info(opmonlib::InfoCollector& ci, int /*level*/)
-//{
-
-  // send counters internal to the module
-//  timingendpointcontrollerinfo::Info module_info;
-//  module_info.sent_endpoint_io_reset_cmds = m_sent_hw_command_counters.at(0).atomic.load();
-//  module_info.sent_endpoint_print_status_cmds = m_sent_hw_command_counters.at(1).atomic.load();
-
-//  module_info.sent_endpoint_enable_cmds = m_sent_hw_command_counters.at(2).atomic.load();
-//  module_info.sent_endpoint_disable_cmds = m_sent_hw_command_counters.at(3).atomic.load();
-//  module_info.sent_endpoint_reset_cmds = m_sent_hw_command_counters.at(4).atomic.load();
-//  module_info.sent_endpoint_print_timestamp_cmds = m_sent_hw_command_counters.at(5).atomic.load();
-//  ci.add(module_info);
-//}
-
 void
 TimingEndpointControllerBase::process_device_info(nlohmann::json info)
 {
   ++m_device_infos_received_count;
   
-  timing::timingfirmwareinfo::TimingDeviceInfo device_info;
-  from_json(info, device_info);
-
-  auto ept_info = device_info.endpoint_info;
+  auto ept_info = DeviceInfoView(info).record("endpoint_info");
 
-  m_endpoint_state = ept_info.state;
-  bool ready = ept_info.ready;
+  m_endpoint_state = ept_info.get<uint32_t>("state"); // NOLINT(build/unsigned)
+  bool ready = ept_info.get<bool>("ready");
 
   TLOG_DEBUG(3) << "state: 0x" << std::hex << m_endpoint_state << ", ready: " << ready << std::dec << ", infos received: " << m_device_infos_received_count;
 
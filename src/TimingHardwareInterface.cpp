@@ -9,6 +9,8 @@
 
 #include "timinglibs/TimingHardwareInterface.hpp"
 
+#include "ContentHash.hpp"
+#include "UHALFileHash.hpp"
 #include "timinglibs/TimingIssues.hpp"
 #include "confmodel/Connection.hpp"
 
@@ -18,6 +20,7 @@
 #include <chrono>
 #include <cstdlib>
 #include <memory>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
@@ -26,25 +29,14 @@
 namespace dunedaq {
 namespace timinglibs {
 
-inline void
-resolve_environment_variables(std::string& input_string)
-{
-  static std::regex env_var_pattern("\\$\\{([^}]+)\\}");
-  std::smatch match;
-  while (std::regex_search(input_string, match, env_var_pattern)) {
-    const char* s = getenv(match[1].str().c_str());
-    const std::string env_var(s == nullptr ? "" : s);
-    input_string.replace(match[0].first, match[0].second, env_var);
-  }
-}
-
 TimingHardwareInterface::TimingHardwareInterface()
   : m_connections_file("")
+  , m_connections_file_hash(0)
   , m_connection_manager(nullptr)
 {
 }
 
-void
+bool
 TimingHardwareInterface::configure_uhal(const std::string& uhal_log_level, const std::string& connections_file)
 {
   m_uhal_log_level = uhal_log_level;
@@ -65,27 +57,40 @@ TimingHardwareInterface::configure_uhal(const std::string& uhal_log_level, const
     throw InvalidUHALLogLevel(ERS_HERE, m_uhal_log_level);
   }
 
+  // an address table edited in place changes the hash as well
+  std::set<std::string> hashed_paths;
+  auto connections_file_hash = hash_uhal_file(connections_file, fnv1a_hash(""), hashed_paths);
+
+  if (m_connection_manager && connections_file == m_connections_file && connections_file_hash == m_connections_file_hash) {
+    TLOG_DEBUG(0) << "Connections file " << m_connections_file << " unchanged, keeping the uhal connection manager";
+    return false;
+  }
+
+  m_connection_manager.reset(nullptr);
   m_connections_file = connections_file;
+  m_connections_file_hash = connections_file_hash;
   try {
     m_connection_manager = std::make_unique<uhal::ConnectionManager>("file://" + m_connections_file);
   } catch (const uhal::exception::FileNotFound& excpt) {
     std::stringstream message;
     message << m_connections_file << " not found. Has TIMING_SHARE been set?";
+    m_connections_file = "";
     throw UHALConnectionsFileIssue(ERS_HERE, message.str(), excpt);
   }
+  return true;
 }
 
-void
+bool
 TimingHardwareInterface::configure_uhal(const dunedaq::timinglibs::dal::TimingHardwareInterfaceConf* mdal)
 {
-  TimingHardwareInterface::configure_uhal(mdal->get_uhal_log_level(), mdal->get_connections_file());
+  return TimingHardwareInterface::configure_uhal(mdal->get_uhal_log_level(), mdal->get_connections_file());
 }
 
 void
 TimingHardwareInterface::scrap_uhal()
 {
-  m_connection_manager.reset(nullptr);
-  m_connections_file="";
+  // parsing the connections and address tables is slow, and their content rarely changes between configurations
+  TLOG_DEBUG(0) << "Keeping the uhal connection manager of " << m_connections_file << " for the next configuration";
 }
 
 } // namespace timinglibs
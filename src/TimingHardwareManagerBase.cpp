@@ -7,21 +7,22 @@
  */
 
 #include "TimingHardwareManagerBase.hpp"
+#include "EndpointScanSetUpdate.hpp"
+#include "TraceRecorder.hpp"
+#include "FakeDeviceBackend.hpp"
+#include "UHALDeviceBackend.hpp"
 
 #include "timinglibs/dal/TimingHardwareManagerBase.hpp"
+#include "timinglibs/opmon/timinghardwaremanager.pb.h"
 
 #include "iomanager/IOManager.hpp"
 #include "logging/Logging.hpp"
-#include "timing/definitions.hpp"
-
-#include "timing/FanoutDesign.hpp"
-#include "timing/CDRMuxDesignInterface.hpp"
-#include "timing/MasterMuxDesign.hpp"
 
 #include "timing/timingfirmware/Nljs.hpp"
 #include "timing/timingfirmware/Structs.hpp"
 #include "appfwk/ModuleConfiguration.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
@@ -46,15 +47,34 @@ TimingHardwareManagerBase::TimingHardwareManagerBase(const std::string& name)
   , m_monitored_device_names_fanout({})
   , m_monitored_device_name_endpoint("")
   , m_monitored_device_name_hsi("")
+  , m_device_backend(nullptr)
+  , m_device_backend_type("")
   , m_received_hw_commands_counter{ 0 }
   , m_accepted_hw_commands_counter{ 0 }
   , m_rejected_hw_commands_counter{ 0 }
   , m_failed_hw_commands_counter{ 0 }
+  , m_endpoint_scans_done_counter{ 0 }
+  , m_endpoint_scans_failed_counter{ 0 }
   , m_endpoint_scan_threads_clean_up_thread(nullptr)
+  , m_run_endpoint_scan_cleanup_thread(false)
+  , m_params(nullptr)
+  , m_journal(nullptr)
+  , m_clock_configs(nullptr)
+  , m_fingerprints(nullptr)
+  , m_thread_placements({ { "gatherer", "gather" },
+                          { "io_reset", "io-reset" },
+                          { "endpoint_scan", "ep-scan" },
+                          { "endpoint_scan_cleanup", "ep-scan-clean" },
+                          { "fl_cmd_sequencer", "fl-cmd-seq" },
+                          { "link_watchdog", "link-watchdog" },
+                          { "watchpoint_monitor", "watchpoints" },
+                          { "device_prepare", "prepare" } })
 {
   //  register_command("start", &TimingHardwareManagerBase::do_start);
   //  register_command("stop", &TimingHardwareManagerBase::do_stop);
    register_command("scrap", &TimingHardwareManagerBase::do_scrap);
+   register_command("start_tracing", &TimingHardwareManagerBase::do_start_tracing);
+   register_command("stop_tracing", &TimingHardwareManagerBase::do_stop_tracing);
 }
 
 void
@@ -63,6 +83,9 @@ TimingHardwareManagerBase::init(std::shared_ptr<appfwk::ModuleConfiguration> mcf
   auto mod_config = mcfg->module<timinglibs::dal::TimingHardwareManagerBase>(get_name());
   m_params = mod_config->get_configuration();
 
+  // a placement the host does not allow fails the init, rather than running unplaced
+  m_thread_placements.configure(m_params->get_thread_placements());
+
   // set up queues
   for (auto con : mod_config->get_inputs())
   {
@@ -82,6 +105,14 @@ TimingHardwareManagerBase::init(std::shared_ptr<appfwk::ModuleConfiguration> mcf
   m_endpoint_scan_threads_clean_up_thread = std::make_unique<dunedaq::utilities::ReusableThread>(0);
 }
 
+void
+TimingHardwareManagerBase::start_configured_tracing()
+{
+  if (!m_params->get_trace_file().empty()) {
+    TraceRecorder::get().enable(m_params->get_trace_file());
+  }
+}
+
 void
 TimingHardwareManagerBase::conf(const nlohmann::json& data)
 {
@@ -89,6 +120,8 @@ TimingHardwareManagerBase::conf(const nlohmann::json& data)
   m_accepted_hw_commands_counter = 0;
   m_rejected_hw_commands_counter = 0;
   m_failed_hw_commands_counter = 0;
+  m_endpoint_scans_done_counter = 0;
+  m_endpoint_scans_failed_counter = 0;
 
   m_gather_interval = m_params->get_gather_interval();
   m_gather_interval_debug = m_params->get_gather_interval_debug();
@@ -98,7 +131,22 @@ TimingHardwareManagerBase::conf(const nlohmann::json& data)
   m_monitored_device_name_endpoint = m_params->get_monitored_device_name_endpoint();
   m_monitored_device_name_hsi = m_params->get_monitored_device_name_hsi();
 
-  configure_uhal(m_params); // configure hw ipbus connection
+  create_device_backend();
+  prepare_monitored_devices();
+
+  if (!m_params->get_journal_file().empty()) {
+    m_journal = std::make_shared<HardwareJournal>(m_params->get_journal_file());
+  }
+
+  // a bad clock configuration fails the conf, not a reset in the middle of a run
+  m_clock_configs = std::make_unique<ClockConfigCache>();
+  for (auto& clock_config : m_params->get_clock_config_files()) {
+    m_clock_configs->load(clock_config);
+  }
+
+  if (!m_params->get_hardware_state_file().empty()) {
+    m_fingerprints = std::make_shared<HardwareFingerprintStore>(m_params->get_hardware_state_file());
+  }
 
   m_hw_command_receiver->add_callback(std::bind(&TimingHardwareManagerBase::process_hardware_command, this, std::placeholders::_1));
 
@@ -106,10 +154,109 @@ TimingHardwareManagerBase::conf(const nlohmann::json& data)
   m_endpoint_scan_threads_clean_up_thread->set_work(&TimingHardwareManagerBase::clean_endpoint_scan_threads, this);
 }
 
+void
+TimingHardwareManagerBase::start_link_watchdog()
+{
+  auto link_watchdog_interval = m_params->get_link_watchdog_interval();
+  if (!link_watchdog_interval) {
+    return;
+  }
+
+  // the devices with an endpoint
+  std::vector<std::string> devices;
+  for (auto& device : m_monitored_device_names_fanout) {
+    if (!device.empty()) {
+      devices.push_back(device);
+    }
+  }
+  for (auto& device : { m_monitored_device_name_endpoint, m_monitored_device_name_hsi }) {
+    if (!device.empty()) {
+      devices.push_back(device);
+    }
+  }
+  if (devices.empty()) {
+    return;
+  }
+
+  TLOG() << get_name() << ": watching the link state of " << devices.size() << " devices every "
+         << link_watchdog_interval << " us";
+  auto link_watchdog =
+    std::make_unique<LinkWatchdog>(*m_device_backend, devices, std::chrono::microseconds(link_watchdog_interval));
+  link_watchdog->start(m_thread_placements.get("link_watchdog"));
+
+  std::lock_guard<std::mutex> link_watchdog_lock(m_link_watchdog_mutex);
+  m_link_watchdog = std::move(link_watchdog);
+}
+
+void
+TimingHardwareManagerBase::create_device_backend()
+{
+  auto device_backend_type = m_params->get_device_backend();
+  if (device_backend_type == "fake") {
+    m_device_backend = std::make_unique<FakeDeviceBackend>(std::chrono::microseconds(m_params->get_fake_device_latency()),
+                                                           std::chrono::milliseconds(m_params->get_fake_endpoint_lock_time()));
+  } else {
+    bool connections_changed = configure_uhal(m_params); // configure hw ipbus connection
+    // the device interfaces created by the previous configuration stay valid with its connection manager
+    if (connections_changed || m_device_backend_type != device_backend_type || !m_device_backend) {
+      m_device_backend = std::make_unique<UHALDeviceBackend>(*m_connection_manager);
+    } else {
+      TLOG() << get_name() << ": keeping the device interfaces of the previous configuration";
+    }
+  }
+  m_device_backend_type = device_backend_type;
+  m_gather_planner = std::make_unique<GatherPlanner>(*m_device_backend);
+}
+
+void
+TimingHardwareManagerBase::prepare_monitored_devices()
+{
+  std::vector<std::string> devices = m_monitored_device_names_fanout;
+  for (auto& device : { m_monitored_device_name_master, m_monitored_device_name_endpoint, m_monitored_device_name_hsi }) {
+    devices.push_back(device);
+  }
+
+  TraceSpan span("prepare_devices", "transition", "");
+
+  // one thread per device, device creation is dominated by waiting on uhal
+  std::vector<std::thread> prepare_threads;
+  auto placement = m_thread_placements.get("device_prepare");
+  for (auto& device : devices) {
+    if (device.empty()) {
+      continue;
+    }
+    prepare_threads.emplace_back([this, device, &placement]() {
+      placement.apply(pthread_self(), device);
+      TraceSpan device_span("prepare_device", "device", device);
+      try {
+        m_device_backend->prepare_device(device);
+      } catch (const std::exception& excpt) {
+        ers::warning(FailedToPrepareDevice(ERS_HERE, device, excpt));
+      }
+    });
+  }
+  for (auto& prepare_thread : prepare_threads) {
+    prepare_thread.join();
+  }
+}
+
 void TimingHardwareManagerBase::do_scrap(const nlohmann::json& data)
 {
+  auto scrap_start = TraceRecorder::clock_t::now();
+
   m_hw_command_receiver->remove_callback();
 
+  wait_for_io_resets();
+  stop_fl_cmd_sequencer();
+  {
+    std::lock_guard<std::mutex> link_watchdog_lock(m_link_watchdog_mutex);
+    m_link_watchdog.reset();
+  }
+  {
+    std::lock_guard<std::mutex> watchpoint_monitor_lock(m_watchpoint_monitor_mutex);
+    m_watchpoint_monitor.reset();
+  }
+
   auto time_of_scrap = std::chrono::high_resolution_clock::now();
   while(m_command_threads.size())
   {
@@ -121,46 +268,53 @@ void TimingHardwareManagerBase::do_scrap(const nlohmann::json& data)
   m_run_endpoint_scan_cleanup_thread.store(false);
   
   stop_hw_mon_gathering();
-  
+  m_gather_planner.reset();
+
+  // the uhal device interfaces are kept, with the connection manager, for the next conf
+  if (m_device_backend_type != "uhal") {
+    m_device_backend.reset();
+  }
   scrap_uhal();
 
   m_command_threads.clear(); 
-  m_info_gatherers.clear();
+  {
+    std::lock_guard<std::mutex> info_gatherers_lock(m_info_gatherers_mutex);
+    m_info_gatherers.clear();
+  }
   m_timing_hw_cmd_map_.clear();
-  m_hw_device_map.clear();
-  m_connection_manager.reset();
-}
-
-const timing::TimingNode*
-TimingHardwareManagerBase::get_timing_device_plain(const std::string& device_name)
-{
-
-  if (!device_name.compare("")) {
-    std::stringstream message;
-    message << "UHAL device name is an empty string";
-    throw UHALDeviceNameIssue(ERS_HERE, message.str());
+  m_journal.reset();
+  m_fingerprints.reset();
+  m_clock_configs.reset();
+  {
+    std::lock_guard<std::mutex> endpoint_scan_sets_lock(m_endpoint_scan_sets_mutex);
+    m_endpoint_scan_sets.clear();
   }
 
-  if (auto hw_device_entry = m_hw_device_map.find(device_name); hw_device_entry != m_hw_device_map.end()) {
-    return dynamic_cast<const timing::TimingNode*>(&hw_device_entry->second->getNode(""));
-  } else {
-    TLOG_DEBUG(0) << get_name() << ": hw device interface for: " << device_name
-                  << " does not exist. I will try to create it.";
-
-    try {
-      std::lock_guard<std::mutex> hw_device_map_guard(m_hw_device_map_mutex);
-      m_hw_device_map.emplace(device_name,
-                              std::make_unique<uhal::HwInterface>(m_connection_manager->getDevice(device_name)));
-    } catch (const uhal::exception::ConnectionUIDDoesNotExist& exception) {
-      std::stringstream message;
-      message << "UHAL device name not " << device_name << " in connections file";
-      throw UHALDeviceNameIssue(ERS_HERE, message.str(), exception);
-    }
+  TraceRecorder::get().record("scrap", "transition", "", scrap_start, TraceRecorder::clock_t::now());
 
-    TLOG_DEBUG(0) << get_name() << ": hw device interface for: " << device_name << " successfully created.";
+  // tracing started from the configuration ends with it
+  if (!m_params->get_trace_file().empty()) {
+    TraceRecorder::get().disable();
+  }
+}
 
-    return dynamic_cast<const timing::TimingNode*>(&m_hw_device_map.find(device_name)->second->getNode(""));
+void
+TimingHardwareManagerBase::do_start_tracing(const nlohmann::json& data)
+{
+  std::string trace_file = m_params ? m_params->get_trace_file() : "";
+  if (data.is_object()) {
+    trace_file = data.value("trace_file", trace_file);
   }
+  if (trace_file.empty()) {
+    trace_file = get_name() + "_trace.json";
+  }
+  TraceRecorder::get().enable(trace_file);
+}
+
+void
+TimingHardwareManagerBase::do_stop_tracing(const nlohmann::json& /*data*/)
+{
+  TraceRecorder::get().disable();
 }
 
 void
@@ -168,19 +322,27 @@ TimingHardwareManagerBase::gather_monitor_data(InfoGatherer& gatherer)
 {
   auto device_name = gatherer.get_device_name();
 
+  // the first gather is not delayed to the grid of the device
+  auto gather_time = std::chrono::steady_clock::now();
   while (gatherer.run_gathering()) {
 
-    // collect the data from the hardware
+    // collect the data from the hardware, or from the read of another gatherer due at the same time
+    auto gather_start = std::chrono::steady_clock::now();
+    bool gathered = true;
     try {
-      auto design = get_timing_device<const timing::TopDesignInterface*>(device_name);
-
-      gatherer.collect_info_from_device(*design);
+      TraceSpan span("gather", "gather", device_name);
+      gatherer.collect_info_from_device(*m_gather_planner, gather_time);
     } catch (const std::exception& excpt) {
       ers::warning(FailedToCollectOpMonInfo(ERS_HERE, device_name, excpt));
+      gathered = false;
     }
+    gatherer.count_gather(
+      gathered, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - gather_start));
 
     auto prev_gather_time = std::chrono::steady_clock::now();
-    auto next_gather_time = prev_gather_time + std::chrono::microseconds(gatherer.get_gather_interval());
+    auto next_gather_time = m_gather_planner->next_gather_time(
+      device_name, std::chrono::microseconds(gatherer.get_gather_interval()), prev_gather_time);
+    gather_time = next_gather_time;
 
     // check running_flag periodically
     auto slice_period = std::chrono::microseconds(10000);
@@ -213,30 +375,55 @@ TimingHardwareManagerBase::register_info_gatherer(uint gather_interval, const st
       device_name,
       op_mon_level);
 
+    gatherer->set_journal(m_journal);
+    gatherer->set_fingerprints(m_fingerprints);
+    gatherer->set_endpoint_scan_sets(
+      std::bind(&TimingHardwareManagerBase::get_endpoint_scan_set_names, this, std::placeholders::_1));
+
     TLOG_DEBUG(0) << "Registering info gatherer: " << gatherer_name;
+    std::lock_guard<std::mutex> info_gatherers_lock(m_info_gatherers_mutex);
     m_info_gatherers.emplace(std::make_pair(gatherer_name, std::move(gatherer)));
   } else {
     TLOG() << "Skipping registration of " << gatherer_name << ". Already exists.";
   }
 }
 
+std::vector<std::pair<std::string, InfoGatherer*>>
+TimingHardwareManagerBase::find_info_gatherers(const std::string& name)
+{
+  // name is either a gatherer name, or a device name matching all the gatherers of the device
+  std::string device_prefix = name + "_level_";
+
+  std::vector<std::pair<std::string, InfoGatherer*>> gatherers;
+  std::lock_guard<std::mutex> info_gatherers_lock(m_info_gatherers_mutex);
+  for (auto it = m_info_gatherers.lower_bound(name); it != m_info_gatherers.end(); ++it) {
+    if (it->first.compare(0, name.size(), name) != 0) {
+      break;
+    }
+    if (it->first == name || it->first.compare(0, device_prefix.size(), device_prefix) == 0) {
+      gatherers.emplace_back(it->first, it->second.get());
+    }
+  }
+  return gatherers;
+}
+
 void
 TimingHardwareManagerBase::start_hw_mon_gathering(const std::string& device_name)
 {
   // start all gatherers if no device name is given
   if (!device_name.compare("")) {
     TLOG_DEBUG(0) << get_name() << " Starting all info gatherers";
+    std::lock_guard<std::mutex> info_gatherers_lock(m_info_gatherers_mutex);
     for (auto it = m_info_gatherers.begin(); it != m_info_gatherers.end(); ++it)
-      it->second.get()->start_gathering_thread();
+      it->second.get()->start_gathering_thread(m_thread_placements.get("gatherer"));
   } else {
-    // find gatherer for suppled device name and start it
-    bool gatherer_found=false;
-    for (auto it = m_info_gatherers.lower_bound(device_name); it != m_info_gatherers.end(); ++it) {
-      TLOG_DEBUG(0) << get_name() << " Starting info gatherer: " << it->first;
-      it->second.get()->start_gathering_thread();
-      gatherer_found=true;
+    // find gatherers for suppled device name and start them
+    auto gatherers = find_info_gatherers(device_name);
+    for (auto& [gatherer_name, gatherer] : gatherers) {
+      TLOG_DEBUG(0) << get_name() << " Starting info gatherer: " << gatherer_name;
+      gatherer->start_gathering_thread(m_thread_placements.get("gatherer"));
     } 
-    if (!gatherer_found) ers::warning(AttemptedToControlNonExantInfoGatherer(ERS_HERE, "start", device_name));
+    if (gatherers.empty()) ers::warning(AttemptedToControlNonExantInfoGatherer(ERS_HERE, "start", device_name));
   }
 }
 
@@ -246,17 +433,17 @@ TimingHardwareManagerBase::stop_hw_mon_gathering(const std::string& device_name)
   // stop all gatherers if no device name is given
   if (!device_name.compare("")) {
     TLOG_DEBUG(0) << get_name() << " Stopping all info gatherers";
+    std::lock_guard<std::mutex> info_gatherers_lock(m_info_gatherers_mutex);
     for (auto it = m_info_gatherers.begin(); it != m_info_gatherers.end(); ++it)
       it->second.get()->stop_gathering_thread();
   } else {
-    // find gatherer for suppled device name and stop it
-    bool gatherer_found=false;
-    for (auto it = m_info_gatherers.lower_bound(device_name); it != m_info_gatherers.end(); ++it) {
-      TLOG_DEBUG(0) << get_name() << " Stopping info gatherer: " << it->first;
-      it->second.get()->stop_gathering_thread();
-      gatherer_found=true;
+    // find gatherers for suppled device name and stop them
+    auto gatherers = find_info_gatherers(device_name);
+    for (auto& [gatherer_name, gatherer] : gatherers) {
+      TLOG_DEBUG(0) << get_name() << " Stopping info gatherer: " << gatherer_name;
+      gatherer->stop_gathering_thread();
     } 
-    if (!gatherer_found) ers::warning(AttemptedToControlNonExantInfoGatherer(ERS_HERE, "stop", device_name));
+    if (gatherers.empty()) ers::warning(AttemptedToControlNonExantInfoGatherer(ERS_HERE, "stop", device_name));
   }
 }
 
@@ -264,17 +451,98 @@ std::vector<std::string>
 TimingHardwareManagerBase::check_hw_mon_gatherer_is_running(const std::string& device_name)
 {
   std::vector<std::string> running_gatherers;
-  for (auto it = m_info_gatherers.lower_bound(device_name); it != m_info_gatherers.end(); ++it)
+  for (auto& [gatherer_name, gatherer] : find_info_gatherers(device_name))
   {
-    TLOG_DEBUG(0) << get_name() << " Checking run state of info gatherer: " << it->first << ", and the state is " << it->second.get()->run_gathering();
-    if (it->second.get()->run_gathering())
+    TLOG_DEBUG(0) << get_name() << " Checking run state of info gatherer: " << gatherer_name << ", and the state is " << gatherer->run_gathering();
+    if (gatherer->run_gathering())
     {
-      running_gatherers.push_back(it->first);
+      running_gatherers.push_back(gatherer_name);
     }
   }
   return running_gatherers;  
 }
 
+void
+TimingHardwareManagerBase::generate_opmon_data()
+{
+  opmon::TimingHardwareManagerInfo module_info;
+  module_info.set_received_hw_commands_counter(m_received_hw_commands_counter.load());
+  module_info.set_accepted_hw_commands_counter(m_accepted_hw_commands_counter.load());
+  module_info.set_rejected_hw_commands_counter(m_rejected_hw_commands_counter.load());
+  module_info.set_failed_hw_commands_counter(m_failed_hw_commands_counter.load());
+  module_info.set_endpoint_scans_done_counter(m_endpoint_scans_done_counter.load());
+  module_info.set_endpoint_scans_failed_counter(m_endpoint_scans_failed_counter.load());
+  publish(std::move(module_info));
+
+  {
+    std::lock_guard<std::mutex> fl_cmd_sequencer_lock(m_fl_cmd_sequencer_mutex);
+    if (m_fl_cmd_sequencer) {
+      for (auto& stats : m_fl_cmd_sequencer->get_stats()) {
+        opmon::FLCmdSequenceInfo sequence_info;
+        sequence_info.set_commands_sent(stats.commands_sent);
+        sequence_info.set_target_rate(stats.target_rate);
+        sequence_info.set_achieved_rate(stats.achieved_rate);
+        sequence_info.set_mean_lateness_us(stats.mean_lateness_us);
+        sequence_info.set_jitter_us(stats.jitter_us);
+        sequence_info.set_max_lateness_us(stats.max_lateness_us);
+        sequence_info.set_done(stats.done);
+        sequence_info.set_interruptions(stats.interruptions);
+        sequence_info.set_interrupted_s(stats.interrupted_s);
+        sequence_info.set_interrupted(stats.interrupted);
+        publish(std::move(sequence_info),
+                { { "device", m_fl_cmd_sequencer->get_device() }, { "channel", std::to_string(stats.channel) } });
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> link_watchdog_lock(m_link_watchdog_mutex);
+    if (m_link_watchdog) {
+      for (auto& stats : m_link_watchdog->get_stats()) {
+        opmon::LinkWatchdogInfo link_info;
+        link_info.set_polls(stats.polls);
+        link_info.set_poll_failures(stats.poll_failures);
+        link_info.set_transitions(stats.transitions);
+        link_info.set_events_sent(stats.events_sent);
+        link_info.set_events_failed_to_send(stats.events_failed_to_send);
+        link_info.set_state(stats.state);
+        link_info.set_ready(stats.ready);
+        publish(std::move(link_info), { { "device", stats.device } });
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> watchpoint_monitor_lock(m_watchpoint_monitor_mutex);
+    if (m_watchpoint_monitor) {
+      for (auto& stats : m_watchpoint_monitor->get_device_stats()) {
+        opmon::WatchpointDeviceInfo device_info;
+        device_info.set_reads(stats.reads);
+        device_info.set_read_failures(stats.read_failures);
+        device_info.set_events_sent(stats.events_sent);
+        device_info.set_events_failed_to_send(stats.events_failed_to_send);
+        publish(std::move(device_info), { { "device", stats.device } });
+      }
+      for (auto& stats : m_watchpoint_monitor->get_watchpoint_stats()) {
+        opmon::WatchpointInfo watchpoint_info;
+        watchpoint_info.set_field(stats.field);
+        watchpoint_info.set_condition(stats.condition);
+        watchpoint_info.set_transitions(stats.transitions);
+        publish(std::move(watchpoint_info),
+                { { "device", stats.device }, { "subscriber", stats.subscriber }, { "watchpoint", stats.watchpoint } });
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> info_gatherers_lock(m_info_gatherers_mutex);
+  for (auto& [gatherer_name, gatherer] : m_info_gatherers) {
+    // published at the opmon level of the gatherer, so that opmon filters it by level
+    publish(gatherer->get_opmon_info(),
+            { { "device", gatherer->get_device_name() } },
+            static_cast<opmonlib::OpMonLevel>(gatherer->get_op_mon_level()));
+  }
+}
+
 // cmd stuff
 
 void
@@ -284,8 +552,14 @@ TimingHardwareManagerBase::process_hardware_command(timingcmd::TimingHwCmd& timi
   starting_stream << ": Executing process_hardware_command() callback.";
   TLOG_DEBUG(0) << get_name() << starting_stream.str();
 
+  TraceSpan span(timing_hw_cmd.id, "command", timing_hw_cmd.device);
+
   ++m_received_hw_commands_counter;
 
+  if (m_journal) {
+    m_journal->record_hw_cmd(timing_hw_cmd);
+  }
+
   TLOG_DEBUG(0) << get_name() << ": Received hardware command #" << m_received_hw_commands_counter.load()
                   << ", it is of type: " << timing_hw_cmd.id << ", targeting device: " << timing_hw_cmd.device << ", with payload: " << timing_hw_cmd.payload.dump();
 
@@ -295,6 +569,10 @@ TimingHardwareManagerBase::process_hardware_command(timingcmd::TimingHwCmd& timi
     ++m_accepted_hw_commands_counter;
 
     TLOG_DEBUG(0) << "Found hw cmd: " << hw_cmd_name;
+
+    // commands for a device are executed in order, after any reset of the device still running
+    wait_for_io_reset(timing_hw_cmd.device);
+
     try {
       std::invoke(cmd->second, timing_hw_cmd);
     } catch (const std::exception& exception) {
@@ -321,6 +599,50 @@ TimingHardwareManagerBase::io_reset(const timingcmd::TimingHwCmd& hw_cmd)
   
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " io reset";
 
+  invalidate_config_fingerprint(hw_cmd.device);
+
+  // the previous reset of the device is joined before its thread is replaced
+  wait_for_io_reset(hw_cmd.device);
+
+  auto queue_time = TraceRecorder::clock_t::now();
+  auto io_reset_thread = std::make_unique<dunedaq::utilities::WorkerThread>([this, hw_cmd, queue_time](std::atomic<bool>&) {
+    m_thread_placements.get("io_reset").apply(pthread_self(), hw_cmd.device);
+    TraceRecorder::get().record("io_reset_queued", "command", hw_cmd.device, queue_time, TraceRecorder::clock_t::now());
+    try {
+      perform_io_reset(hw_cmd);
+    } catch (const std::exception& exception) {
+      ers::error(FailedToExecuteHardwareCommand(ERS_HERE, hw_cmd.id, hw_cmd.device, exception));
+      ++m_failed_hw_commands_counter;
+    }
+  });
+
+  std::lock_guard<std::mutex> io_reset_threads_lock(m_io_reset_threads_mutex);
+  auto [io_reset_entry, inserted] = m_io_reset_threads.emplace(hw_cmd.device, nullptr);
+  if (!inserted) {
+    // another reset of the device was queued meanwhile
+    throw IOResetInProgress(ERS_HERE, hw_cmd.device);
+  }
+  try {
+    io_reset_thread->start_working_thread(m_thread_placements.get("io_reset").get_name(hw_cmd.device));
+  } catch (...) {
+    m_io_reset_threads.erase(io_reset_entry);
+    throw;
+  }
+  io_reset_entry->second = std::move(io_reset_thread);
+}
+
+void
+TimingHardwareManagerBase::perform_io_reset(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  TraceSpan span("io_reset", "command", hw_cmd.device);
+
+  timingcmd::IOResetCmdPayload cmd_payload;
+  timingcmd::from_json(hw_cmd.payload, cmd_payload);
+
+  if (!cmd_payload.clock_config.empty() && m_clock_configs) {
+    cmd_payload.clock_config = m_clock_configs->get_cached_path(cmd_payload.clock_config);
+  }
+
   // io reset disrupts hw mon gathering, so stop if running
   auto running_hw_gatherers = check_hw_mon_gatherer_is_running(hw_cmd.device);
   for (auto& gatherer: running_hw_gatherers)
@@ -328,28 +650,98 @@ TimingHardwareManagerBase::io_reset(const timingcmd::TimingHwCmd& hw_cmd)
     stop_hw_mon_gathering(gatherer);
   }
 
-  auto design = get_timing_device<const timing::TopDesignInterface*>(hw_cmd.device);
-
-  if (cmd_payload.soft) {
-    TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " soft io reset";
-    design->soft_reset_io();
-  } else if (!cmd_payload.clock_config.empty()) {
-    TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device
-                  << " io reset, with supplied clk file: " << cmd_payload.clock_config;
-    design->reset_io(cmd_payload.clock_config);
-  }
-  else
-  {
-    TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device
-                  << " io reset, with supplied clk source: " << cmd_payload.clock_source;
-    design->reset_io(static_cast<timing::ClockSource>(cmd_payload.clock_source));
+  pause_device_threads(hw_cmd.device);
+  try {
+    m_device_backend->io_reset(hw_cmd.device, cmd_payload);
+  } catch (...) {
+    resume_device_threads(hw_cmd.device);
+    throw;
   }
+  resume_device_threads(hw_cmd.device);
 
   // if hw mon gathering was running previously, start it again
   for (auto& gatherer: running_hw_gatherers)
   {
     start_hw_mon_gathering(gatherer);
   }
+
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " io reset done";
+}
+
+void
+TimingHardwareManagerBase::wait_for_io_reset(const std::string& device)
+{
+  std::unique_ptr<dunedaq::utilities::WorkerThread> io_reset_thread;
+  {
+    std::lock_guard<std::mutex> io_reset_threads_lock(m_io_reset_threads_mutex);
+    auto io_reset_entry = m_io_reset_threads.find(device);
+    if (io_reset_entry == m_io_reset_threads.end()) {
+      return;
+    }
+    io_reset_thread = std::move(io_reset_entry->second);
+    m_io_reset_threads.erase(io_reset_entry);
+  }
+  TraceSpan span("io_reset_wait", "lock", device);
+  if (io_reset_thread->thread_running()) {
+    io_reset_thread->stop_working_thread();
+  }
+}
+
+void
+TimingHardwareManagerBase::wait_for_io_resets()
+{
+  std::vector<std::string> devices;
+  {
+    std::lock_guard<std::mutex> io_reset_threads_lock(m_io_reset_threads_mutex);
+    for (auto& [device, io_reset_thread] : m_io_reset_threads) {
+      devices.push_back(device);
+    }
+  }
+  for (auto& device : devices) {
+    wait_for_io_reset(device);
+  }
+}
+
+void
+TimingHardwareManagerBase::pause_device_threads(const std::string& device)
+{
+  {
+    std::lock_guard<std::mutex> fl_cmd_sequencer_lock(m_fl_cmd_sequencer_mutex);
+    if (m_fl_cmd_sequencer && m_fl_cmd_sequencer->get_device() == device) {
+      m_fl_cmd_sequencer->pause();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> link_watchdog_lock(m_link_watchdog_mutex);
+    if (m_link_watchdog) {
+      m_link_watchdog->pause_device(device);
+    }
+  }
+  std::lock_guard<std::mutex> watchpoint_monitor_lock(m_watchpoint_monitor_mutex);
+  if (m_watchpoint_monitor) {
+    m_watchpoint_monitor->pause_device(device);
+  }
+}
+
+void
+TimingHardwareManagerBase::resume_device_threads(const std::string& device)
+{
+  {
+    std::lock_guard<std::mutex> fl_cmd_sequencer_lock(m_fl_cmd_sequencer_mutex);
+    if (m_fl_cmd_sequencer && m_fl_cmd_sequencer->get_device() == device) {
+      m_fl_cmd_sequencer->resume();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> link_watchdog_lock(m_link_watchdog_mutex);
+    if (m_link_watchdog) {
+      m_link_watchdog->resume_device(device);
+    }
+  }
+  std::lock_guard<std::mutex> watchpoint_monitor_lock(m_watchpoint_monitor_mutex);
+  if (m_watchpoint_monitor) {
+    m_watchpoint_monitor->resume_device(device);
+  }
 }
 
 void
@@ -357,8 +749,60 @@ TimingHardwareManagerBase::print_status(const timingcmd::TimingHwCmd& hw_cmd)
 {
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " print status";
 
-  auto design = get_timing_device<const timing::TopDesignInterface*>(hw_cmd.device);
-  TLOG() << std::endl << design->get_status();
+  TLOG() << std::endl << m_device_backend->get_status(hw_cmd.device);
+}
+
+void
+TimingHardwareManagerBase::record_config_fingerprint(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  timingcmd::ConfigFingerprintCmdPayload cmd_payload;
+  timingcmd::from_json(hw_cmd.payload, cmd_payload);
+
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " record config fingerprint " << cmd_payload.fingerprint;
+
+  if (m_fingerprints) {
+    m_fingerprints->record(hw_cmd.device, cmd_payload.fingerprint);
+  }
+}
+
+void
+TimingHardwareManagerBase::register_watchpoints(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  timingcmd::TimingRegisterWatchpointsCmdPayload cmd_payload;
+  timingcmd::from_json(hw_cmd.payload, cmd_payload);
+
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " register " << cmd_payload.watchpoints.size()
+                << " watchpoints of " << cmd_payload.subscriber;
+
+  std::lock_guard<std::mutex> watchpoint_monitor_lock(m_watchpoint_monitor_mutex);
+  if (!m_watchpoint_monitor) {
+    m_watchpoint_monitor =
+      std::make_unique<WatchpointMonitor>(*m_device_backend, m_thread_placements.get("watchpoint_monitor"));
+  }
+  m_watchpoint_monitor->register_watchpoints(hw_cmd.device, cmd_payload);
+}
+
+void
+TimingHardwareManagerBase::unregister_watchpoints(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  timingcmd::TimingUnregisterWatchpointsCmdPayload cmd_payload;
+  timingcmd::from_json(hw_cmd.payload, cmd_payload);
+
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " unregister watchpoints of " << cmd_payload.subscriber;
+
+  std::lock_guard<std::mutex> watchpoint_monitor_lock(m_watchpoint_monitor_mutex);
+  if (m_watchpoint_monitor) {
+    m_watchpoint_monitor->unregister_watchpoints(hw_cmd.device, cmd_payload.subscriber);
+  }
+}
+
+void
+TimingHardwareManagerBase::invalidate_config_fingerprint(const std::string& device)
+{
+  // the device configuration is about to change, and is unknown until a controller records it again
+  if (m_fingerprints) {
+    m_fingerprints->invalidate(device);
+  }
 }
 
 // master commands
@@ -371,14 +815,30 @@ TimingHardwareManagerBase::set_timestamp(const timingcmd::TimingHwCmd& hw_cmd)
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device
                               << " set timestamp, with supplied ts source: " << cmd_payload.timestamp_source;
 
-  auto design = get_timing_device<const timing::MasterDesignInterface*>(hw_cmd.device);
-  design->sync_timestamp(static_cast<timing::TimestampSource>(cmd_payload.timestamp_source));
+  invalidate_config_fingerprint(hw_cmd.device);
+  m_device_backend->sync_timestamp(hw_cmd.device, cmd_payload.timestamp_source);
 }
 
 void
 TimingHardwareManagerBase::master_endpoint_scan(const timingcmd::TimingHwCmd& hw_cmd)
 {
-  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " master_endpoint_scan";
+  timingcmd::TimingMasterEndpointScanPayload cmd_payload;
+  timingcmd::from_json(hw_cmd.payload, cmd_payload);
+
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " master_endpoint_scan, scan set: " << cmd_payload.scan_set;
+
+  // the scan runs on the endpoints as they are when it is queued
+  EndpointScanSet endpoints;
+  if (cmd_payload.scan_set.empty()) {
+    endpoints = std::make_shared<const timingcmd::TimingEndpointLocations>(std::move(cmd_payload.endpoints));
+  } else {
+    std::lock_guard<std::mutex> endpoint_scan_sets_lock(m_endpoint_scan_sets_mutex);
+    auto scan_set = m_endpoint_scan_sets.find({ hw_cmd.device, cmd_payload.scan_set });
+    if (scan_set == m_endpoint_scan_sets.end()) {
+      throw UnknownEndpointScanSet(ERS_HERE, hw_cmd.device, cmd_payload.scan_set);
+    }
+    endpoints = scan_set->second;
+  }
 
   std::stringstream command_thread_uid;
   auto t = std::time(nullptr);
@@ -396,54 +856,92 @@ TimingHardwareManagerBase::master_endpoint_scan(const timingcmd::TimingHwCmd& hw
     auto thread_key = command_thread_uid.str();
     std::unique_lock map_lock(m_command_threads_map_mutex);
 
-    m_command_threads.emplace(thread_key, std::make_unique<std::thread>(std::bind(&TimingHardwareManagerBase::perform_endpoint_scan, this, hw_cmd)));
+    auto queue_time = TraceRecorder::clock_t::now();
+    m_command_threads.emplace(thread_key, std::make_unique<std::thread>([this, device = hw_cmd.device, endpoints, queue_time]() {
+      m_thread_placements.get("endpoint_scan").apply(pthread_self(), device);
+      TraceRecorder::get().record("endpoint_scan_queued", "scan", device, queue_time, TraceRecorder::clock_t::now());
+      perform_endpoint_scan(device, *endpoints);
+    }));
   }
 }
 
-void TimingHardwareManagerBase::perform_endpoint_scan(const timingcmd::TimingHwCmd& hw_cmd)
+void
+TimingHardwareManagerBase::define_endpoint_scan_set(const timingcmd::TimingHwCmd& hw_cmd)
 {
-  timingcmd::TimingMasterEndpointScanPayload cmd_payload;
+  timingcmd::TimingMasterDefineEndpointScanSetPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  for (auto& endpoint_location : cmd_payload.endpoints)
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " define endpoint scan set " << cmd_payload.scan_set << " of "
+                << cmd_payload.endpoints.size() << " endpoints";
+
+  auto endpoints = std::make_shared<const timingcmd::TimingEndpointLocations>(std::move(cmd_payload.endpoints));
+
+  std::lock_guard<std::mutex> endpoint_scan_sets_lock(m_endpoint_scan_sets_mutex);
+  m_endpoint_scan_sets[{ hw_cmd.device, cmd_payload.scan_set }] = std::move(endpoints);
+}
+
+std::vector<std::string>
+TimingHardwareManagerBase::get_endpoint_scan_set_names(const std::string& device)
+{
+  std::vector<std::string> names;
+  std::lock_guard<std::mutex> endpoint_scan_sets_lock(m_endpoint_scan_sets_mutex);
+  for (auto& [device_scan_set, endpoints] : m_endpoint_scan_sets) {
+    if (device_scan_set.first == device) {
+      names.push_back(device_scan_set.second);
+    }
+  }
+  return names;
+}
+
+void
+TimingHardwareManagerBase::update_endpoint_scan_set(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  timingcmd::TimingMasterUpdateEndpointScanSetPayload cmd_payload;
+  timingcmd::from_json(hw_cmd.payload, cmd_payload);
+
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " update endpoint scan set " << cmd_payload.scan_set
+                << ", adding " << cmd_payload.add.size() << " and removing " << cmd_payload.remove.size() << " endpoints";
+
+  std::lock_guard<std::mutex> endpoint_scan_sets_lock(m_endpoint_scan_sets_mutex);
+  auto scan_set = m_endpoint_scan_sets.find({ hw_cmd.device, cmd_payload.scan_set });
+  if (scan_set == m_endpoint_scan_sets.end()) {
+    throw UnknownEndpointScanSet(ERS_HERE, hw_cmd.device, cmd_payload.scan_set);
+  }
+
+  auto endpoints = *scan_set->second;
+  apply_endpoint_scan_set_update(endpoints, cmd_payload.add, cmd_payload.remove);
+  scan_set->second = std::make_shared<const timingcmd::TimingEndpointLocations>(std::move(endpoints));
+}
+
+void TimingHardwareManagerBase::perform_endpoint_scan(const std::string& device, const timingcmd::TimingEndpointLocations& endpoints)
+{
+  TraceSpan scan_span("endpoint_scan", "scan", device);
+
+  for (auto& endpoint_location : endpoints)
   {
     auto endpoint_address = endpoint_location.address;
     auto fanout_slot = endpoint_location.fanout_slot;
     auto sfp_slot = endpoint_location.sfp_slot;
 
-    std::unique_lock<std::mutex> master_sfp_lock(master_sfp_mutex);
-
-    TLOG_DEBUG(1) << get_name() << ": " << hw_cmd.device << " master_endpoint_scan starting: ept adr: " << endpoint_address << ", ept sfp: " << sfp_slot << ", fanout slot: " << fanout_slot;
+    std::unique_lock<std::mutex> master_sfp_lock(master_sfp_mutex, std::defer_lock);
+    {
+      TraceSpan lock_span("master_sfp_mutex_wait", "lock", device);
+      master_sfp_lock.lock();
+    }
+    TraceSpan step_span("endpoint_scan_step", "scan", device);
 
-    auto master_design = get_timing_device<const timing::MasterDesignInterface*>(hw_cmd.device);
+    TLOG_DEBUG(1) << get_name() << ": " << device << " master_endpoint_scan starting: ept adr: " << endpoint_address << ", ept sfp: " << sfp_slot << ", fanout slot: " << fanout_slot;
 
     try
     {
-      master_design->get_master_node_plain()->switch_endpoint_sfp(endpoint_address, true);
-
-      if (sfp_slot >= 0)
-      {
-        if (fanout_slot > 0)
-        {
-          // configure fanout/FIB
-          get_timing_device<const timing::CDRMuxDesignInterface*>(m_monitored_device_names_fanout.at(fanout_slot-1))->switch_cdr_mux(sfp_slot);
-
-          // configure MIB
-          dynamic_cast<const timing::CDRMuxDesignInterface*>(master_design)->switch_cdr_mux(fanout_slot-1);
-        }
-        else
-        {
-          dynamic_cast<const timing::MasterMuxDesign*>(master_design)->switch_downstream_mux_channel(sfp_slot, false);
-        }
-      }
-      // configure any master mux, possibly
-      master_design->get_master_node_plain()->scan_endpoint(endpoint_address, false);
-      master_design->get_master_node_plain()->switch_endpoint_sfp(endpoint_address, false);
+      std::string fanout_device = fanout_slot > 0 ? m_monitored_device_names_fanout.at(fanout_slot-1) : "";
+      m_device_backend->scan_endpoint(device, fanout_device, endpoint_location);
+      ++m_endpoint_scans_done_counter;
     }
     catch(std::exception& e)
     {
       ers::error(EndpointScanFailure(ERS_HERE,e));
-      master_design->get_master_node_plain()->switch_endpoint_sfp(endpoint_address, false);
+      ++m_endpoint_scans_failed_counter;
     }
   }
 }
@@ -451,6 +949,7 @@ void TimingHardwareManagerBase::perform_endpoint_scan(const timingcmd::TimingHwC
 void TimingHardwareManagerBase::clean_endpoint_scan_threads()
 {
   TLOG_DEBUG(0) << "Entering clean_endpoint_scan_threads()";
+  m_thread_placements.get("endpoint_scan_cleanup").apply(pthread_self());
   bool break_flag = false;
   while (!break_flag)
   {
@@ -497,8 +996,20 @@ TimingHardwareManagerBase::set_endpoint_delay(const timingcmd::TimingHwCmd& hw_c
   timingcmd::TimingMasterSetEndpointDelayCmdPayload cmd_payload;
   timingcmd::from_json(hw_cmd.payload, cmd_payload);
 
-  auto design = get_timing_device<const timing::MasterDesignInterface*>(hw_cmd.device);
-  design->apply_endpoint_delay(cmd_payload.address, cmd_payload.coarse_delay, cmd_payload.fine_delay, cmd_payload.phase_delay, cmd_payload.measure_rtt, cmd_payload.control_sfp, cmd_payload.sfp_mux);
+  m_device_backend->apply_endpoint_delay(hw_cmd.device, cmd_payload);
+}
+
+void
+TimingHardwareManagerBase::set_endpoint_delays(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  timingcmd::TimingMasterSetEndpointDelaysCmdPayload cmd_payload;
+  timingcmd::from_json(hw_cmd.payload, cmd_payload);
+
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " set " << cmd_payload.delays.size() << " endpoint delays";
+
+  // delays may switch the master sfp mux, keep endpoint scans out until the whole batch is applied
+  std::lock_guard<std::mutex> master_sfp_lock(master_sfp_mutex);
+  m_device_backend->apply_endpoint_delays(hw_cmd.device, cmd_payload.delays);
 }
 
 void
@@ -512,8 +1023,51 @@ TimingHardwareManagerBase::send_fl_cmd(const timingcmd::TimingHwCmd& hw_cmd)
          << ", " << cmd_payload.channel
          << ", " << cmd_payload.number_of_commands_to_send;
 
-  auto design = get_timing_device<const timing::MasterDesignInterface*>(hw_cmd.device);
-  design->get_master_node_plain()->send_fl_cmd(cmd_payload.fl_cmd_id, cmd_payload.channel, cmd_payload.number_of_commands_to_send);
+  m_device_backend->send_fl_cmd(hw_cmd.device, cmd_payload.fl_cmd_id, cmd_payload.channel, cmd_payload.number_of_commands_to_send);
+}
+
+void
+TimingHardwareManagerBase::start_fl_cmd_sequence(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  timingcmd::TimingMasterFLCmdSequenceCmdPayload cmd_payload;
+  timingcmd::from_json(hw_cmd.payload, cmd_payload);
+
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " start fl cmd sequence of " << cmd_payload.schedules.size()
+                << " schedules, batch period " << cmd_payload.batch_period << " us";
+
+  // a new sequence replaces the running one
+  stop_fl_cmd_sequencer();
+
+  auto fl_cmd_sequencer = std::make_unique<FLCmdSequencer>(*m_device_backend, hw_cmd.device, cmd_payload);
+  fl_cmd_sequencer->start(m_thread_placements.get("fl_cmd_sequencer"));
+
+  std::lock_guard<std::mutex> fl_cmd_sequencer_lock(m_fl_cmd_sequencer_mutex);
+  m_fl_cmd_sequencer = std::move(fl_cmd_sequencer);
+}
+
+void
+TimingHardwareManagerBase::stop_fl_cmd_sequence(const timingcmd::TimingHwCmd& hw_cmd)
+{
+  TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " stop fl cmd sequence";
+
+  stop_fl_cmd_sequencer();
+}
+
+void
+TimingHardwareManagerBase::stop_fl_cmd_sequencer()
+{
+  std::lock_guard<std::mutex> fl_cmd_sequencer_lock(m_fl_cmd_sequencer_mutex);
+  if (!m_fl_cmd_sequencer) {
+    return;
+  }
+  m_fl_cmd_sequencer->stop();
+  for (auto& stats : m_fl_cmd_sequencer->get_stats()) {
+    TLOG() << get_name() << ": " << m_fl_cmd_sequencer->get_device() << " fl cmd sequence on channel " << stats.channel << ": sent "
+           << stats.commands_sent << " commands at " << stats.achieved_rate << " Hz (target " << stats.target_rate
+           << " Hz), lateness mean " << stats.mean_lateness_us << " us, jitter " << stats.jitter_us << " us, max "
+           << stats.max_lateness_us << " us, " << stats.interruptions << " interruptions for " << stats.interrupted_s << " s";
+  }
+  m_fl_cmd_sequencer.reset();
 }
 
 // endpoint commands
@@ -526,8 +1080,8 @@ TimingHardwareManagerBase::endpoint_enable(const timingcmd::TimingHwCmd& hw_cmd)
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " ept enable, adr: " << cmd_payload.address
                 << ", part: " << cmd_payload.partition;
 
-  auto design = get_timing_device<const timing::EndpointDesignInterface*>(hw_cmd.device);
-  design->get_endpoint_node_plain(cmd_payload.endpoint_id)->enable(cmd_payload.address, cmd_payload.partition);
+  invalidate_config_fingerprint(hw_cmd.device);
+  m_device_backend->endpoint_enable(hw_cmd.device, cmd_payload);
 }
 
 void
@@ -538,8 +1092,8 @@ TimingHardwareManagerBase::endpoint_disable(const timingcmd::TimingHwCmd& hw_cmd
 
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " ept disable";
 
-  auto design = get_timing_device<const timing::EndpointDesignInterface*>(hw_cmd.device);
-  design->get_endpoint_node_plain(cmd_payload.endpoint_id)->disable();
+  invalidate_config_fingerprint(hw_cmd.device);
+  m_device_backend->endpoint_disable(hw_cmd.device, cmd_payload.endpoint_id);
 }
 
 void
@@ -551,8 +1105,8 @@ TimingHardwareManagerBase::endpoint_reset(const timingcmd::TimingHwCmd& hw_cmd)
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " ept reset, adr: " << cmd_payload.address
                 << ", part: " << cmd_payload.partition;
 
-  auto design = get_timing_device<const timing::EndpointDesignInterface*>(hw_cmd.device);
-  design->get_endpoint_node_plain(cmd_payload.endpoint_id)->reset(cmd_payload.address, cmd_payload.partition);
+  invalidate_config_fingerprint(hw_cmd.device);
+  m_device_backend->endpoint_reset(hw_cmd.device, cmd_payload);
 }
 
 // hsi commands
@@ -561,8 +1115,7 @@ TimingHardwareManagerBase::hsi_reset(const timingcmd::TimingHwCmd& hw_cmd)
 {
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi reset";
 
-  auto design = get_timing_device<const timing::HSIDesignInterface*>(hw_cmd.device);
-  design->get_hsi_node().reset_hsi();
+  m_device_backend->hsi_reset(hw_cmd.device);
 }
 
 void
@@ -573,9 +1126,7 @@ TimingHardwareManagerBase::hsi_configure(const timingcmd::TimingHwCmd& hw_cmd)
 
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi configure";
 
-  auto design = get_timing_device<const timing::HSIDesignInterface*>(hw_cmd.device);
-  design->configure_hsi(
-    cmd_payload.data_source, cmd_payload.rising_edge_mask, cmd_payload.falling_edge_mask, cmd_payload.invert_edge_mask, cmd_payload.random_rate);
+  m_device_backend->hsi_configure(hw_cmd.device, cmd_payload);
 }
 
 void
@@ -583,8 +1134,7 @@ TimingHardwareManagerBase::hsi_start(const timingcmd::TimingHwCmd& hw_cmd)
 {
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi start";
 
-  auto design = get_timing_device<const timing::HSIDesignInterface*>(hw_cmd.device);
-  design->get_hsi_node().start_hsi();
+  m_device_backend->hsi_start(hw_cmd.device);
 }
 
 void
@@ -592,8 +1142,7 @@ TimingHardwareManagerBase::hsi_stop(const timingcmd::TimingHwCmd& hw_cmd)
 {
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi stop";
 
-  auto design = get_timing_device<const timing::HSIDesignInterface*>(hw_cmd.device);
-  design->get_hsi_node().stop_hsi();
+  m_device_backend->hsi_stop(hw_cmd.device);
 }
 
 void
@@ -601,8 +1150,7 @@ TimingHardwareManagerBase::hsi_print_status(const timingcmd::TimingHwCmd& hw_cmd
 {
   TLOG_DEBUG(0) << get_name() << ": " << hw_cmd.device << " hsi print status";
 
-  auto design = get_timing_device<const timing::HSIDesignInterface*>(hw_cmd.device);
-  TLOG() << std::endl << design->get_hsi_node().get_status();
+  TLOG() << std::endl << m_device_backend->get_hsi_status(hw_cmd.device);
 }
 
 } // namespace timinglibs
@@ -12,7 +12,16 @@
 #ifndef TIMINGLIBS_SRC_TIMINGHARDWAREMANAGER_HPP_
 #define TIMINGLIBS_SRC_TIMINGHARDWAREMANAGER_HPP_
 
+#include "ClockConfigCache.hpp"
+#include "FLCmdSequencer.hpp"
+#include "GatherPlanner.hpp"
+#include "HardwareFingerprintStore.hpp"
+#include "HardwareJournal.hpp"
 #include "InfoGatherer.hpp"
+#include "LinkWatchdog.hpp"
+#include "ThreadPlacement.hpp"
+#include "TimingDeviceBackend.hpp"
+#include "WatchpointMonitor.hpp"
 #include "timinglibs/TimingHardwareInterface.hpp"
 #include "timinglibs/TimingIssues.hpp"
 #include "timinglibs/timingcmd/Nljs.hpp"
@@ -27,12 +36,6 @@
 #include "timinglibs/dal/TimingHardwareManagerConf.hpp"
 #include "confmodel/Connection.hpp"
 
-#include "timing/TimingNode.hpp"
-#include "timing/EndpointDesignInterface.hpp"
-#include "timing/HSIDesignInterface.hpp"
-#include "timing/MasterDesignInterface.hpp"
-#include "timing/TopDesignInterface.hpp"
-
 #include "uhal/ConnectionManager.hpp"
 #include "utilities/WorkerThread.hpp"
 
@@ -40,6 +43,8 @@
 #include <memory>
 #include <regex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace dunedaq {
@@ -63,7 +68,7 @@ public:
     delete;                                                ///< TimingHardwareManagerBase is not copy-assignable
   TimingHardwareManagerBase(TimingHardwareManagerBase&&) = delete; ///< TimingHardwareManagerBase is not move-constructible
   TimingHardwareManagerBase& operator=(TimingHardwareManagerBase&&) = delete; ///< TimingHardwareManagerBase is not move-assignable
-  virtual ~TimingHardwareManagerBase() {}
+  virtual ~TimingHardwareManagerBase() { wait_for_io_resets(); } // the reset threads are joined even without a scrap
   
   void init(std::shared_ptr<appfwk::ModuleConfiguration> mcfg) override;
   virtual void conf(const nlohmann::json& data);
@@ -75,6 +80,13 @@ protected:
   //  virtual void do_stop(const nlohmann::json&);
   virtual void do_scrap(const nlohmann::json&);
 
+  // span tracing, see TraceRecorder
+  void do_start_tracing(const nlohmann::json&);
+  void do_stop_tracing(const nlohmann::json&);
+  // tracing to the configured trace_file, from each conf until the scrap; to be called first in conf, so that
+  // the conf transition is covered
+  void start_configured_tracing();
+
 
   virtual void process_hardware_command(timingcmd::TimingHwCmd& timing_hw_cmd);
 
@@ -88,9 +100,12 @@ protected:
   uint m_gather_interval;
   uint m_gather_interval_debug;
 
-  // uhal members
-  std::map<std::string, std::unique_ptr<uhal::HwInterface>> m_hw_device_map;
-  std::mutex m_hw_device_map_mutex;
+  // access to the timing devices, over uhal or simulated
+  std::unique_ptr<TimingDeviceBackend> m_device_backend;
+  std::string m_device_backend_type;
+  virtual void create_device_backend();
+  // create the device interfaces of the monitored devices ahead of the first command
+  void prepare_monitored_devices();
 
   // managed timing devices
   std::string m_monitored_device_name_master;
@@ -103,11 +118,6 @@ protected:
   virtual void register_endpoint_hw_commands_for_design() = 0;
   virtual void register_hsi_hw_commands_for_design() = 0;
 
-  // retrieve top level/design object for a timing device
-  template<class TIMING_DEV>
-  TIMING_DEV get_timing_device(const std::string& device_name);
-  const timing::TimingNode* get_timing_device_plain(const std::string& device_name);
-
   // timing hw cmds stuff
   std::map<timingcmd::TimingHwCmdId, std::function<void(const timingcmd::TimingHwCmd&)>> m_timing_hw_cmd_map_;
 
@@ -116,13 +126,22 @@ protected:
 
   // timing common commands
   void io_reset(const timingcmd::TimingHwCmd& hw_cmd);
+  virtual void perform_io_reset(const timingcmd::TimingHwCmd& hw_cmd);
   void print_status(const timingcmd::TimingHwCmd& hw_cmd);
+  void record_config_fingerprint(const timingcmd::TimingHwCmd& hw_cmd);
+  void register_watchpoints(const timingcmd::TimingHwCmd& hw_cmd);
+  void unregister_watchpoints(const timingcmd::TimingHwCmd& hw_cmd);
 
   // timing master commands
   void set_timestamp(const timingcmd::TimingHwCmd& hw_cmd);
   void set_endpoint_delay(const timingcmd::TimingHwCmd& hw_cmd);
+  void set_endpoint_delays(const timingcmd::TimingHwCmd& hw_cmd);
   void send_fl_cmd(const timingcmd::TimingHwCmd& hw_cmd);
+  void start_fl_cmd_sequence(const timingcmd::TimingHwCmd& hw_cmd);
+  void stop_fl_cmd_sequence(const timingcmd::TimingHwCmd& hw_cmd);
   void master_endpoint_scan(const timingcmd::TimingHwCmd& hw_cmd);
+  void define_endpoint_scan_set(const timingcmd::TimingHwCmd& hw_cmd);
+  void update_endpoint_scan_set(const timingcmd::TimingHwCmd& hw_cmd);
 
   // timing partition commands
   virtual void partition_configure(const timingcmd::TimingHwCmd& hw_cmd) = 0;
@@ -140,30 +159,84 @@ protected:
   void hsi_print_status(const timingcmd::TimingHwCmd& hw_cmd);
 
   // opmon stuff
-  std::atomic<uint64_t> m_received_hw_commands_counter; // NOLINT(build/unsigned)
-  std::atomic<uint64_t> m_accepted_hw_commands_counter; // NOLINT(build/unsigned)
-  std::atomic<uint64_t> m_rejected_hw_commands_counter; // NOLINT(build/unsigned)
-  std::atomic<uint64_t> m_failed_hw_commands_counter;   // NOLINT(build/unsigned)
+  void generate_opmon_data() override;
+
+  // written by the hw command callback; on a cache line of their own, away from the scan thread counters
+  alignas(64) std::atomic<uint64_t> m_received_hw_commands_counter; // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_accepted_hw_commands_counter;             // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_rejected_hw_commands_counter;             // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_failed_hw_commands_counter;               // NOLINT(build/unsigned)
+
+  // written by the endpoint scan threads
+  alignas(64) std::atomic<uint64_t> m_endpoint_scans_done_counter; // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_endpoint_scans_failed_counter;           // NOLINT(build/unsigned)
 
   // monitoring
-  std::map<std::string, std::unique_ptr<InfoGatherer>> m_info_gatherers;
+  alignas(64) std::map<std::string, std::unique_ptr<InfoGatherer>> m_info_gatherers;
+  std::mutex m_info_gatherers_mutex;
+  std::unique_ptr<GatherPlanner> m_gather_planner; ///< shares the reads of the gatherers of a device due at the same time
 
   void register_info_gatherer(uint gather_interval, const std::string& device_name, int op_mon_level);
   void gather_monitor_data(InfoGatherer& gatherer);
+  std::vector<std::pair<std::string, InfoGatherer*>> find_info_gatherers(const std::string& name);
 
   virtual void start_hw_mon_gathering(const std::string& device_name = "");
   virtual void stop_hw_mon_gathering(const std::string& device_name = "");
   virtual std::vector<std::string> check_hw_mon_gatherer_is_running(const std::string& device_name);
 
+  // io resets run on a thread per device, so that resets of different devices overlap.
+  // Any later command for the device waits for its reset to finish.
+  std::mutex m_io_reset_threads_mutex;
+  std::map<std::string, std::unique_ptr<dunedaq::utilities::WorkerThread>> m_io_reset_threads;
+  void wait_for_io_reset(const std::string& device);
+  void wait_for_io_resets();
+  // the fl command sequencer, link watchdog and watchpoint monitor leave a device alone while it resets
+  void pause_device_threads(const std::string& device);
+  void resume_device_threads(const std::string& device);
+
   std::mutex m_command_threads_map_mutex;
   std::map<std::string, std::unique_ptr<std::thread>> m_command_threads;
   std::mutex master_sfp_mutex;
-  virtual void perform_endpoint_scan(const timingcmd::TimingHwCmd& hw_cmd);
+  virtual void perform_endpoint_scan(const std::string& device, const timingcmd::TimingEndpointLocations& endpoints);
   virtual void clean_endpoint_scan_threads();
   std::unique_ptr<dunedaq::utilities::ReusableThread> m_endpoint_scan_threads_clean_up_thread;
   std::atomic<bool> m_run_endpoint_scan_cleanup_thread;
   const timinglibs::dal::TimingHardwareManagerConf* m_params;
 
+  // record of received commands and gathered infos, for offline replay
+  std::shared_ptr<HardwareJournal> m_journal;
+
+  // endpoint scan sets, by master and scan set name. Updates replace the set, so that queued scans keep the
+  // snapshot they were queued with
+  using EndpointScanSet = std::shared_ptr<const timingcmd::TimingEndpointLocations>;
+  std::map<std::pair<std::string, std::string>, EndpointScanSet> m_endpoint_scan_sets;
+  std::mutex m_endpoint_scan_sets_mutex;
+  std::vector<std::string> get_endpoint_scan_set_names(const std::string& device);
+
+  // fixed length command sequence running on the master, one at a time
+  std::unique_ptr<FLCmdSequencer> m_fl_cmd_sequencer;
+  std::mutex m_fl_cmd_sequencer_mutex;
+  void stop_fl_cmd_sequencer();
+
+  // high rate polling of the link state of the monitored devices, null if link_watchdog_interval is 0
+  std::unique_ptr<LinkWatchdog> m_link_watchdog;
+  std::mutex m_link_watchdog_mutex;
+  void start_link_watchdog();
+
+  // register watchpoints of the controllers, created at the first registration
+  std::unique_ptr<WatchpointMonitor> m_watchpoint_monitor;
+  std::mutex m_watchpoint_monitor_mutex;
+
+  // clock configuration files, validated at conf
+  std::unique_ptr<ClockConfigCache> m_clock_configs;
+
+  // configuration fingerprints of the devices, sent with their device info
+  std::shared_ptr<HardwareFingerprintStore> m_fingerprints;
+  void invalidate_config_fingerprint(const std::string& device);
+
+  // names, cpu affinity and scheduling of the threads of the module, by role
+  ThreadPlacements m_thread_placements;
+
 };
 
 } // namespace timinglibs
@@ -8,6 +8,7 @@
  */
 
 #include "TimingMasterControllerBase.hpp"
+#include "EndpointScanSetUpdate.hpp"
 #include "timinglibs/dal/EndpointLocation.hpp"
 #include "timinglibs/timingcmd/Nljs.hpp"
 #include "timinglibs/timingcmd/Structs.hpp"
@@ -17,6 +18,7 @@
 #include "appfwk/ModuleConfiguration.hpp"
 #include "appfwk/DAQModule.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <string>
@@ -27,9 +29,11 @@ namespace dunedaq {
 namespace timinglibs {
 
 TimingMasterControllerBase::TimingMasterControllerBase(const std::string& name)
-  : dunedaq::timinglibs::TimingController(name, 7) // 2nd arg: how many hw commands can this module send?
+  : dunedaq::timinglibs::TimingController(name)
   , m_endpoint_scan_period(0)
   , endpoint_scan_thread(std::bind(&TimingMasterControllerBase::endpoint_scan, this, std::placeholders::_1))
+  , m_thread_placements({ { "endpoint_scan", "ep-scan" } })
+  , m_timestamp_estimator(std::make_shared<MasterTimestampEstimator>())
 {
   register_command("conf", &TimingMasterControllerBase::do_configure);
   register_command("scrap", &TimingMasterControllerBase::do_scrap);
@@ -38,11 +42,18 @@ TimingMasterControllerBase::TimingMasterControllerBase(const std::string& name)
   register_command("stop_scanning_endpoints", &TimingMasterControllerBase::do_stop);
 
   // timing master hardware commands
-  register_command("master_set_timestamp", &TimingMasterControllerBase::do_master_set_timestamp);
-  register_command("master_set_endpoint_delay", &TimingMasterControllerBase::do_master_set_endpoint_delay);
-  register_command("master_send_fl_command", &TimingMasterControllerBase::do_master_send_fl_command);
-  register_command("master_measure_endpoint_rtt", &TimingMasterControllerBase::do_master_measure_endpoint_rtt);
-  register_command("master_endpoint_scan", &TimingMasterControllerBase::do_master_endpoint_scan);
+  register_hw_command(ControllerHwCmd::kMasterSetTimestamp, &TimingMasterControllerBase::do_master_set_timestamp);
+  register_hw_command(ControllerHwCmd::kMasterSetEndpointDelay, &TimingMasterControllerBase::do_master_set_endpoint_delay);
+  register_hw_command(ControllerHwCmd::kMasterSetEndpointDelays, &TimingMasterControllerBase::do_master_set_endpoint_delays);
+  register_hw_command(ControllerHwCmd::kMasterSendFLCommand, &TimingMasterControllerBase::do_master_send_fl_command);
+  register_hw_command(ControllerHwCmd::kMasterStartFLCommandSequence,
+                      &TimingMasterControllerBase::do_master_start_fl_command_sequence);
+  register_hw_command(ControllerHwCmd::kMasterStopFLCommandSequence,
+                      &TimingMasterControllerBase::do_master_stop_fl_command_sequence);
+  register_hw_command(ControllerHwCmd::kMasterMeasureEndpointRTT, &TimingMasterControllerBase::do_master_measure_endpoint_rtt);
+  register_hw_command(ControllerHwCmd::kMasterEndpointScan, &TimingMasterControllerBase::do_master_endpoint_scan);
+  register_hw_command(ControllerHwCmd::kMasterUpdateEndpointScanSet,
+                      &TimingMasterControllerBase::do_master_update_endpoint_scan_set);
 }
 
 void
@@ -50,20 +61,40 @@ TimingMasterControllerBase::do_configure(const nlohmann::json& data)
 {
   auto mdal = m_params->cast<dal::TimingMasterControllerConf>();
 
+  m_thread_placements.configure(m_params->get_thread_placements());
+
   auto monitored_endpoints = mdal->get_monitored_endpoints();
 
-   for (auto endpoint : monitored_endpoints) {
-    timingcmd::EndpointLocation endpoint_location;
-    endpoint_location.address = endpoint->get_address();
-    endpoint_location.fanout_slot = endpoint->get_fanout_slot();
-    endpoint_location.sfp_slot = endpoint->get_sfp_slot();
-    m_monitored_endpoint_locations.push_back(endpoint_location);
-   }
+  {
+    std::lock_guard<std::mutex> monitored_endpoint_locations_lock(m_monitored_endpoint_locations_mutex);
+    m_monitored_endpoint_locations.clear();
+    for (auto endpoint : monitored_endpoints) {
+      timingcmd::EndpointLocation endpoint_location;
+      endpoint_location.address = endpoint->get_address();
+      endpoint_location.fanout_slot = endpoint->get_fanout_slot();
+      endpoint_location.sfp_slot = endpoint->get_sfp_slot();
+      m_monitored_endpoint_locations.push_back(endpoint_location);
+    }
+  }
 
   TimingController::do_configure(data); // configure hw command connection
 
+  MasterTimestampEstimator::publish(m_timing_device, m_timestamp_estimator);
+
+  auto endpoint_delay_file = mdal->get_endpoint_delay_file();
+  if (!endpoint_delay_file.empty())
+  {
+    m_endpoint_delay_store = std::make_unique<EndpointDelayStore>(endpoint_delay_file);
+  }
+
   configure_hardware_or_recover_state<TimingMasterNotReady>(data, "Timing master");
 
+  if (m_endpoint_delay_store && m_endpoint_delay_store->size())
+  {
+    TLOG() << get_name() << " conf: master, applying " << m_endpoint_delay_store->size() << " stored endpoint delays";
+    do_master_set_endpoint_delays(nlohmann::json());
+  }
+
   TLOG() << get_name() << " conf done on master, device: " << m_timing_device;
   
   m_endpoint_scan_period = mdal->get_endpoint_scan_period();
@@ -81,7 +112,13 @@ void
 TimingMasterControllerBase::do_start(const nlohmann::json& data)
 {
   TimingController::do_start(data); // set sent cmd counters to 0
-  if (m_endpoint_scan_period) endpoint_scan_thread.start_working_thread();
+  if (m_endpoint_scan_period)
+  {
+    // the periodic scans only name the set
+    send_endpoint_scan_set_definition();
+
+    endpoint_scan_thread.start_working_thread();
+  }
   TLOG() << "Endpoint monitoring started";
 }
 
@@ -92,6 +129,16 @@ TimingMasterControllerBase::do_stop(const nlohmann::json& /*data*/)
   TLOG() << "Endpoint monitoring stopped";
 }
 
+void
+TimingMasterControllerBase::do_scrap(const nlohmann::json& data)
+{
+  TimingController::do_scrap(data); // no more device info after this
+
+  MasterTimestampEstimator::withdraw(m_timing_device);
+  m_timestamp_estimator->reset();
+  m_endpoint_delay_store.reset();
+}
+
 void
 TimingMasterControllerBase::send_configure_hardware_commands(const nlohmann::json& data)
 {
@@ -99,83 +146,178 @@ TimingMasterControllerBase::send_configure_hardware_commands(const nlohmann::jso
   do_master_set_timestamp(data);
 }
 
+nlohmann::json
+TimingMasterControllerBase::get_config_fingerprint_components() const
+{
+  auto components = TimingController::get_config_fingerprint_components();
+
+  auto mdal = m_params->cast<dal::TimingMasterControllerConf>();
+  components["timestamp_source"] = mdal->get_timestamp_source();
+
+  nlohmann::json endpoint_locations;
+  {
+    std::lock_guard<std::mutex> monitored_endpoint_locations_lock(m_monitored_endpoint_locations_mutex);
+    timingcmd::to_json(endpoint_locations, m_monitored_endpoint_locations);
+  }
+  components["endpoints"] = endpoint_locations;
+  return components;
+}
+
 void
 TimingMasterControllerBase::do_master_set_timestamp(const nlohmann::json&)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "set_timestamp");
-
   auto mdal = m_params->cast<dal::TimingMasterControllerConf>();
-  hw_cmd.payload["timestamp_source"] = mdal->get_timestamp_source();
 
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(1).atomic);
+  nlohmann::json payload;
+  payload["timestamp_source"] = mdal->get_timestamp_source();
+
+  send_hw_cmd(ControllerHwCmd::kMasterSetTimestamp, payload);
+
+  // the master timestamp jumps
+  m_timestamp_estimator->reset();
 }
 
 void
 TimingMasterControllerBase::do_master_set_endpoint_delay(const nlohmann::json& data)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "set_endpoint_delay", data);
-  
   TLOG_DEBUG(2) << "set ept delay data: " << data.dump();
   
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(3).atomic);
+  send_hw_cmd(ControllerHwCmd::kMasterSetEndpointDelay, data);
+
+  if (m_endpoint_delay_store)
+  {
+    timingcmd::TimingMasterSetEndpointDelayCmdPayload delay;
+    timingcmd::from_json(data, delay);
+    m_endpoint_delay_store->store(delay);
+  }
+}
+
+void
+TimingMasterControllerBase::do_master_set_endpoint_delays(const nlohmann::json& data)
+{
+  timingcmd::TimingMasterSetEndpointDelaysCmdPayload cmd_payload;
+  if (data.contains("delays"))
+  {
+    timingcmd::from_json(data, cmd_payload);
+  }
+
+  // with a store, the given delays update it and every stored delay is applied
+  if (m_endpoint_delay_store)
+  {
+    for (auto& delay : cmd_payload.delays)
+    {
+      m_endpoint_delay_store->store(delay);
+    }
+    cmd_payload.delays = m_endpoint_delay_store->get_delays();
+  }
+
+  if (cmd_payload.delays.empty())
+  {
+    TLOG_DEBUG(2) << "No endpoint delays to set";
+    return;
+  }
+
+  TLOG_DEBUG(2) << "set " << cmd_payload.delays.size() << " ept delays";
+
+  nlohmann::json payload;
+  timingcmd::to_json(payload, cmd_payload);
+  send_hw_cmd(ControllerHwCmd::kMasterSetEndpointDelays, payload);
 }
 
 void
 TimingMasterControllerBase::do_master_send_fl_command(const nlohmann::json& data)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "send_fl_command", data);
-  
   TLOG_DEBUG(2) << "send fl cmd data: " << data.dump();
 
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(4).atomic);
+  send_hw_cmd(ControllerHwCmd::kMasterSendFLCommand, data);
+}
+
+void
+TimingMasterControllerBase::do_master_start_fl_command_sequence(const nlohmann::json& data)
+{
+  TLOG_DEBUG(2) << "start fl cmd sequence data: " << data.dump();
+
+  send_hw_cmd(ControllerHwCmd::kMasterStartFLCommandSequence, data);
+}
+
+void
+TimingMasterControllerBase::do_master_stop_fl_command_sequence(const nlohmann::json& data)
+{
+  TLOG_DEBUG(2) << "stop fl cmd sequence data: " << data.dump();
+
+  send_hw_cmd(ControllerHwCmd::kMasterStopFLCommandSequence);
 }
 
 void
 TimingMasterControllerBase::do_master_measure_endpoint_rtt(const nlohmann::json& data)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "master_measure_endpoint_rtt");
-  
   TLOG_DEBUG(2) << "measure endpoint rtt data: " << data.dump();
 
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(5).atomic);
+  send_hw_cmd(ControllerHwCmd::kMasterMeasureEndpointRTT);
 }
 
 void
 TimingMasterControllerBase::do_master_endpoint_scan(const nlohmann::json& data)
 {
-  timingcmd::TimingHwCmd hw_cmd =
-  construct_hw_cmd( "master_endpoint_scan");
-  
   TLOG_DEBUG(2) << "endpoint scan data: " << data.dump();
 
-  send_hw_cmd(std::move(hw_cmd));
-  ++(m_sent_hw_command_counters.at(6).atomic);
+  send_hw_cmd(ControllerHwCmd::kMasterEndpointScan);
 }
 
-//void
-//TimingMasterControllerBase::get_info(opmonlib::InfoCollector& ci, int /*level*/)
-//{
-  // send counters internal to the module
-//  timingmastercontrollerinfo::Info module_info;
-//  module_info.sent_master_io_reset_cmds = m_sent_hw_command_counters.at(0).atomic.load();
-//  module_info.sent_master_print_status_cmds = m_sent_hw_command_counters.at(1).atomic.load();
-//  module_info.sent_master_set_timestamp_cmds = m_sent_hw_command_counters.at(2).atomic.load();
-//  module_info.sent_master_set_endpoint_delay_cmds = m_sent_hw_command_counters.at(3).atomic.load();
-//  module_info.sent_master_send_fl_command_cmds = m_sent_hw_command_counters.at(4).atomic.load();
+void
+TimingMasterControllerBase::do_master_update_endpoint_scan_set(const nlohmann::json& data)
+{
+  TLOG_DEBUG(2) << "update endpoint scan set data: " << data.dump();
+
+  timingcmd::TimingMasterUpdateEndpointScanSetPayload cmd_payload;
+  timingcmd::from_json(data, cmd_payload);
+
+  {
+    std::lock_guard<std::mutex> monitored_endpoint_locations_lock(m_monitored_endpoint_locations_mutex);
+    apply_endpoint_scan_set_update(m_monitored_endpoint_locations, cmd_payload.add, cmd_payload.remove);
+  }
 
-//   // for (uint i = 0; i < m_number_hw_commands; ++i) {
-//   //  module_info.sent_hw_command_counters.push_back(m_sent_hw_command_counters.at(i).atomic.load());
-//   //}
-//   ci.add(module_info);
-// }
+  // otherwise the set is defined with the updated endpoints when scanning starts
+  if (endpoint_scan_thread.thread_running())
+  {
+    cmd_payload.scan_set = get_name();
+
+    nlohmann::json payload;
+    timingcmd::to_json(payload, cmd_payload);
+    send_hw_cmd(ControllerHwCmd::kMasterUpdateEndpointScanSet, payload);
+  }
+}
+
+void
+TimingMasterControllerBase::send_endpoint_scan_set_definition()
+{
+  timingcmd::TimingMasterDefineEndpointScanSetPayload cmd_payload;
+  cmd_payload.scan_set = get_name();
+  {
+    std::lock_guard<std::mutex> monitored_endpoint_locations_lock(m_monitored_endpoint_locations_mutex);
+    cmd_payload.endpoints = m_monitored_endpoint_locations;
+  }
+
+  nlohmann::json payload;
+  timingcmd::to_json(payload, cmd_payload);
+  send_hw_cmd(ControllerHwCmd::kMasterDefineEndpointScanSet, payload);
+}
+
+void
+TimingMasterControllerBase::check_endpoint_scan_set(const nlohmann::json& info)
+{
+  // the hardware manager lists the scan sets of the device with each device info
+  if (!endpoint_scan_thread.thread_running() || !info.contains("endpoint_scan_sets"))
+  {
+    return;
+  }
+  auto& scan_sets = info.at("endpoint_scan_sets");
+  if (std::find(scan_sets.begin(), scan_sets.end(), get_name()) == scan_sets.end())
+  {
+    TLOG() << get_name() << ": endpoint scan set unknown to the hardware manager of " << m_timing_device << ", defining it again";
+    send_endpoint_scan_set_definition();
+  }
+}
 
 // cmd stuff
 void
@@ -185,22 +327,18 @@ TimingMasterControllerBase::endpoint_scan(std::atomic<bool>& running_flag)
   std::ostringstream starting_stream;
   starting_stream << ": Starting endpoint_scan() method.";
   TLOG_DEBUG(0) << get_name() << starting_stream.str();
+  m_thread_placements.get("endpoint_scan").apply(pthread_self(), m_timing_device);
 
-  while (running_flag.load() && m_endpoint_scan_period) {
+  timingcmd::TimingMasterEndpointScanPayload cmd_payload;
+  cmd_payload.scan_set = get_name();
 
-    timingcmd::TimingHwCmd hw_cmd =
-    construct_hw_cmd( "master_endpoint_scan");
+  nlohmann::json payload;
+  timingcmd::to_json(payload, cmd_payload);
 
-    timingcmd::TimingMasterEndpointScanPayload cmd_payload;
-    cmd_payload.endpoints = m_monitored_endpoint_locations;
-
-    // dal::TimingMasterController::TimingMasterEndpointScanPayload cmd_payload;
-    // cmd_payload.endpoints = m_monitored_endpoint_locations;
+  while (running_flag.load() && m_endpoint_scan_period) {
 
-    hw_cmd.payload = cmd_payload;
-    send_hw_cmd(std::move(hw_cmd));
+    send_hw_cmd(ControllerHwCmd::kMasterEndpointScan, payload);
 
-    ++(m_sent_hw_command_counters.at(3).atomic);
     if (m_endpoint_scan_period)
     {
       auto prev_gather_time = std::chrono::steady_clock::now();
@@ -232,8 +370,9 @@ TimingMasterControllerBase::endpoint_scan(std::atomic<bool>& running_flag)
   }
 
   std::ostringstream exiting_stream;
-  exiting_stream << ": Exiting endpoint_scan() method. Received " <<  m_sent_hw_command_counters.at(3).atomic.load()
-                 << " commands";
+  exiting_stream << ": Exiting endpoint_scan() method. Sent "
+                 << m_sent_hw_command_counters[to_index(ControllerHwCmd::kMasterEndpointScan)].value.load()
+                 << " scan commands";
   TLOG_DEBUG(0) << get_name() << exiting_stream.str();
 }
 
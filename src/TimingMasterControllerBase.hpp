@@ -13,6 +13,9 @@
 #define TIMINGLIBS_PLUGINS_TIMINGMASTERCONTROLLERBASE_HPP_
 
 #include "timinglibs/TimingController.hpp"
+#include "timinglibs/MasterTimestampEstimator.hpp"
+#include "EndpointDelayStore.hpp"
+#include "ThreadPlacement.hpp"
 #include "timinglibs/dal/TimingMasterControllerConf.hpp"
 
 #include "timinglibs/timingcmd/Nljs.hpp"
@@ -24,6 +27,7 @@
 #include "utilities/WorkerThread.hpp"
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -64,21 +68,37 @@ protected:
   void do_configure(const nlohmann::json&) override;
   void do_start(const nlohmann::json& data) override;
   void do_stop(const nlohmann::json& data) override;
+  void do_scrap(const nlohmann::json& data) override;
   void send_configure_hardware_commands(const nlohmann::json& data) override;
+  nlohmann::json get_config_fingerprint_components() const override;
 
   // timing master commands
   void do_master_set_timestamp(const nlohmann::json&);
   void do_master_set_endpoint_delay(const nlohmann::json& data);
+  void do_master_set_endpoint_delays(const nlohmann::json& data);
   void do_master_send_fl_command(const nlohmann::json& data);
+  void do_master_start_fl_command_sequence(const nlohmann::json& data);
+  void do_master_stop_fl_command_sequence(const nlohmann::json& data);
   void do_master_measure_endpoint_rtt(const nlohmann::json& data);
   void do_master_endpoint_scan(const nlohmann::json& data);
+  void do_master_update_endpoint_scan_set(const nlohmann::json& data);
 
-  // pass op mon info
-  //  void get_info(opmonlib::InfoCollector& ci, int level) override;
-  
+  // master timestamp, predicted from the gathered device info; published under the timing device name
+  std::shared_ptr<MasterTimestampEstimator> m_timestamp_estimator;
+
+  // delays set through this controller, applied again at conf; null if endpoint_delay_file is not configured
+  std::unique_ptr<EndpointDelayStore> m_endpoint_delay_store;
+
+  // scanned as the endpoint scan set named after this controller, defined on the hardware manager when scanning
+  // starts, and again whenever the device infos show that the hardware manager lost it, e.g. by a scrap or restart
   timingcmd::TimingEndpointLocations m_monitored_endpoint_locations;
+  mutable std::mutex m_monitored_endpoint_locations_mutex;
+  void send_endpoint_scan_set_definition();
+  // to be called by process_device_info
+  void check_endpoint_scan_set(const nlohmann::json& info);
   uint m_endpoint_scan_period; // NOLINT(build/unsigned)
   dunedaq::utilities::WorkerThread endpoint_scan_thread;
+  ThreadPlacements m_thread_placements;
   virtual void endpoint_scan(std::atomic<bool>&);
 };
 } // namespace timinglibs
@@ -0,0 +1,127 @@
+/**
+ * @file TraceRecorder.cpp TraceRecorder class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "TraceRecorder.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "logging/Logging.hpp"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+TraceRecorder&
+TraceRecorder::get()
+{
+  static TraceRecorder recorder;
+  return recorder;
+}
+
+uint32_t // NOLINT(build/unsigned)
+TraceRecorder::current_thread_id()
+{
+  // small, stable ids read better in the trace viewer than pthread ids
+  static std::atomic<uint32_t> next_thread_id{ 1 }; // NOLINT(build/unsigned)
+  thread_local uint32_t thread_id = next_thread_id++; // NOLINT(build/unsigned)
+  return thread_id;
+}
+
+void
+TraceRecorder::enable(const std::string& file, size_t max_events)
+{
+  std::lock_guard<std::mutex> lock(m_events_mutex);
+  m_events.clear();
+  m_events.reserve(std::min<size_t>(max_events, 65536));
+  m_file = file;
+  m_max_events = max_events;
+  m_dropped_events = 0;
+  m_trace_start = clock_t::now();
+  m_enabled.store(true);
+
+  TLOG() << "Tracing enabled, trace file: " << m_file;
+}
+
+void
+TraceRecorder::record(std::string_view name,
+                      const char* category,
+                      std::string_view device,
+                      clock_t::time_point start,
+                      clock_t::time_point end)
+{
+  if (!is_enabled()) {
+    return;
+  }
+  auto thread_id = current_thread_id();
+
+  std::lock_guard<std::mutex> lock(m_events_mutex);
+  if (m_events.size() >= m_max_events) {
+    ++m_dropped_events;
+    return;
+  }
+  m_events.push_back({ std::string(name), category, std::string(device), start, end - start, thread_id });
+}
+
+void
+TraceRecorder::disable()
+{
+  if (!m_enabled.exchange(false)) {
+    return;
+  }
+
+  std::vector<TraceEvent> events;
+  std::string file;
+  uint64_t dropped_events; // NOLINT(build/unsigned)
+  clock_t::time_point trace_start;
+  {
+    std::lock_guard<std::mutex> lock(m_events_mutex);
+    events.swap(m_events);
+    file = m_file;
+    dropped_events = m_dropped_events;
+    trace_start = m_trace_start;
+  }
+
+  auto to_us = [](clock_t::duration duration) {
+    return std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(duration).count();
+  };
+
+  nlohmann::json trace_events = nlohmann::json::array();
+  for (auto& event : events) {
+    nlohmann::json trace_event = { { "name", event.name },       { "cat", event.category },
+                                   { "ph", "X" },                { "pid", 1 },
+                                   { "tid", event.thread_id },   { "ts", to_us(event.start - trace_start) },
+                                   { "dur", to_us(event.duration) } };
+    if (!event.device.empty()) {
+      trace_event["args"] = { { "device", event.device } };
+    }
+    trace_events.push_back(std::move(trace_event));
+  }
+
+  std::ofstream trace_file(file);
+  trace_file << nlohmann::json{ { "traceEvents", trace_events }, { "displayTimeUnit", "ms" } }.dump() << std::endl;
+  if (!trace_file) {
+    ers::warning(TraceFileIssue(ERS_HERE, file, "failed to write trace"));
+    return;
+  }
+
+  TLOG() << "Tracing disabled, wrote " << events.size() << " spans to " << file << ", dropped " << dropped_events;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,134 @@
+/**
+ * @file TraceRecorder.hpp
+ *
+ * TraceRecorder collects timed spans (commands, gathers, endpoint scan
+ * steps, lock waits, device operations) and writes them as a Chrome Trace
+ * Event JSON file, which can be opened in Perfetto or chrome://tracing.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_TRACERECORDER_HPP_
+#define TIMINGLIBS_SRC_TRACERECORDER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Process wide recorder of trace spans. While disabled, recording
+ * costs a single relaxed atomic load.
+ */
+class TraceRecorder
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  static TraceRecorder& get();
+
+  TraceRecorder(const TraceRecorder&) = delete;            ///< TraceRecorder is not copy-constructible
+  TraceRecorder& operator=(const TraceRecorder&) = delete; ///< TraceRecorder is not copy-assignable
+  TraceRecorder(TraceRecorder&&) = delete;                 ///< TraceRecorder is not move-constructible
+  TraceRecorder& operator=(TraceRecorder&&) = delete;      ///< TraceRecorder is not move-assignable
+
+  bool is_enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Start recording, discarding any unwritten spans
+   * @param file Trace file written by disable()
+   * @param max_events Spans beyond this number are counted but not kept
+   */
+  void enable(const std::string& file, size_t max_events = s_default_max_events);
+
+  /**
+   * @brief Stop recording and write the recorded spans to the trace file
+   */
+  void disable();
+
+  void record(std::string_view name,
+              const char* category,
+              std::string_view device,
+              clock_t::time_point start,
+              clock_t::time_point end);
+
+  static constexpr size_t s_default_max_events = 1000000;
+
+private:
+  TraceRecorder() = default;
+
+  struct TraceEvent
+  {
+    std::string name;
+    const char* category;
+    std::string device;
+    clock_t::time_point start;
+    clock_t::duration duration;
+    uint32_t thread_id; // NOLINT(build/unsigned)
+  };
+
+  static uint32_t current_thread_id(); // NOLINT(build/unsigned)
+
+  std::atomic<bool> m_enabled{ false };
+  std::mutex m_events_mutex;
+  std::vector<TraceEvent> m_events;
+  std::string m_file;
+  size_t m_max_events = s_default_max_events;
+  uint64_t m_dropped_events = 0; // NOLINT(build/unsigned)
+  clock_t::time_point m_trace_start;
+};
+
+/**
+ * @brief Records the lifetime of the object as a span, if tracing was
+ * enabled at construction. Name and device must outlive the span.
+ */
+class TraceSpan
+{
+public:
+  TraceSpan(std::string_view name, const char* category, std::string_view device = {})
+    : m_active(TraceRecorder::get().is_enabled())
+    , m_name(name)
+    , m_category(category)
+    , m_device(device)
+  {
+    if (m_active) {
+      m_start = TraceRecorder::clock_t::now();
+    }
+  }
+
+  ~TraceSpan()
+  {
+    if (m_active) {
+      TraceRecorder::get().record(m_name, m_category, m_device, m_start, TraceRecorder::clock_t::now());
+    }
+  }
+
+  TraceSpan(const TraceSpan&) = delete;            ///< TraceSpan is not copy-constructible
+  TraceSpan& operator=(const TraceSpan&) = delete; ///< TraceSpan is not copy-assignable
+  TraceSpan(TraceSpan&&) = delete;                 ///< TraceSpan is not move-constructible
+  TraceSpan& operator=(TraceSpan&&) = delete;      ///< TraceSpan is not move-assignable
+
+private:
+  bool m_active;
+  std::string_view m_name;
+  const char* m_category;
+  std::string_view m_device;
+  TraceRecorder::clock_t::time_point m_start;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_TRACERECORDER_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,328 @@
+/**
+ * @file UHALDeviceBackend.cpp UHALDeviceBackend class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "UHALDeviceBackend.hpp"
+
+#include "TraceRecorder.hpp"
+
+#include "logging/Logging.hpp"
+#include "timing/definitions.hpp"
+
+#include "timing/CDRMuxDesignInterface.hpp"
+#include "timing/EndpointDesignInterface.hpp"
+#include "timing/HSIDesignInterface.hpp"
+#include "timing/MasterDesignInterface.hpp"
+#include "timing/MasterMuxDesign.hpp"
+#include "timing/TopDesignInterface.hpp"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+UHALDeviceBackend::UHALDeviceBackend(uhal::ConnectionManager& connection_manager)
+  : m_connection_manager(connection_manager)
+{
+}
+
+const timing::TimingNode*
+UHALDeviceBackend::get_timing_device_plain(const std::string& device_name)
+{
+  if (!device_name.compare("")) {
+    std::stringstream message;
+    message << "UHAL device name is an empty string";
+    throw UHALDeviceNameIssue(ERS_HERE, message.str());
+  }
+
+  {
+    std::lock_guard<std::mutex> hw_device_map_guard(m_hw_device_map_mutex);
+    if (auto hw_device_entry = m_hw_device_map.find(device_name); hw_device_entry != m_hw_device_map.end()) {
+      return dynamic_cast<const timing::TimingNode*>(&hw_device_entry->second->getNode(""));
+    }
+  }
+
+  TLOG_DEBUG(0) << "hw device interface for: " << device_name << " does not exist. I will try to create it.";
+
+  // created outside of the map lock, so that devices are prepared in parallel
+  std::unique_ptr<uhal::HwInterface> hw_device;
+  {
+    TraceSpan span("create_hw_interface", "uhal", device_name);
+    try {
+      hw_device = std::make_unique<uhal::HwInterface>(m_connection_manager.getDevice(device_name));
+    } catch (const uhal::exception::ConnectionUIDDoesNotExist& exception) {
+      std::stringstream message;
+      message << "UHAL device name not " << device_name << " in connections file";
+      throw UHALDeviceNameIssue(ERS_HERE, message.str(), exception);
+    }
+  }
+
+  TLOG_DEBUG(0) << "hw device interface for: " << device_name << " successfully created.";
+
+  std::lock_guard<std::mutex> hw_device_map_guard(m_hw_device_map_mutex);
+  // keeps the interface of a concurrent creation for the same device, if that one was first
+  auto hw_device_entry = m_hw_device_map.emplace(device_name, std::move(hw_device)).first;
+  return dynamic_cast<const timing::TimingNode*>(&hw_device_entry->second->getNode(""));
+}
+
+void
+UHALDeviceBackend::prepare_device(const std::string& device)
+{
+  get_timing_device_plain(device);
+}
+
+// common
+void
+UHALDeviceBackend::io_reset(const std::string& device, const timingcmd::IOResetCmdPayload& payload)
+{
+  TraceSpan span("io_reset", "uhal", device);
+  auto design = get_timing_device<const timing::TopDesignInterface*>(device);
+
+  if (payload.soft) {
+    TLOG_DEBUG(0) << device << " soft io reset";
+    design->soft_reset_io();
+  } else if (!payload.clock_config.empty()) {
+    TLOG_DEBUG(0) << device << " io reset, with supplied clk file: " << payload.clock_config;
+    design->reset_io(payload.clock_config);
+  } else {
+    TLOG_DEBUG(0) << device << " io reset, with supplied clk source: " << payload.clock_source;
+    design->reset_io(static_cast<timing::ClockSource>(payload.clock_source));
+  }
+}
+
+std::string
+UHALDeviceBackend::get_status(const std::string& device)
+{
+  TraceSpan span("get_status", "uhal", device);
+  return get_timing_device<const timing::TopDesignInterface*>(device)->get_status();
+}
+
+void
+UHALDeviceBackend::get_info(const std::string& device, timing::timingfirmwareinfo::TimingDeviceInfo& info)
+{
+  TraceSpan span("get_info", "uhal", device);
+  get_timing_device<const timing::TopDesignInterface*>(device)->get_info(info);
+}
+
+LinkState
+UHALDeviceBackend::read_link_state(const std::string& device)
+{
+  TraceSpan span("read_link_state", "uhal", device);
+  auto endpoint_node = get_timing_device<const timing::EndpointDesignInterface*>(device)->get_endpoint_node_plain(0);
+
+  // both fields of the endpoint status register, in a single dispatch
+  auto ept_state = endpoint_node->getNode("csr.stat.ep_stat").read();
+  auto ept_ready = endpoint_node->getNode("csr.stat.ep_rdy").read();
+  endpoint_node->getClient().dispatch();
+  return LinkState{ ept_state.value(), ept_ready.value() != 0 };
+}
+
+void
+UHALDeviceBackend::read_registers(const std::string& device,
+                                  const std::vector<std::string>& nodes,
+                                  std::vector<uint32_t>& values) // NOLINT(build/unsigned)
+{
+  TraceSpan span("read_registers", "uhal", device);
+  auto top_node = get_timing_device_plain(device);
+
+  std::vector<uhal::ValWord<uint32_t>> words; // NOLINT(build/unsigned)
+  words.reserve(nodes.size());
+  for (auto& node : nodes) {
+    try {
+      words.push_back(top_node->getNode(node).read());
+    } catch (const uhal::exception::exception& excpt) {
+      throw UHALDeviceNodeIssue(ERS_HERE, "no node " + node + " in " + device, excpt);
+    }
+  }
+  top_node->getClient().dispatch();
+
+  values.clear();
+  for (auto& word : words) {
+    values.push_back(word.value());
+  }
+}
+
+// master
+void
+UHALDeviceBackend::sync_timestamp(const std::string& device, uint32_t timestamp_source) // NOLINT(build/unsigned)
+{
+  TraceSpan span("sync_timestamp", "uhal", device);
+  auto design = get_timing_device<const timing::MasterDesignInterface*>(device);
+  design->sync_timestamp(static_cast<timing::TimestampSource>(timestamp_source));
+}
+
+void
+UHALDeviceBackend::apply_endpoint_delay(const std::string& device,
+                                        const timingcmd::TimingMasterSetEndpointDelayCmdPayload& payload)
+{
+  TraceSpan span("apply_endpoint_delay", "uhal", device);
+  auto design = get_timing_device<const timing::MasterDesignInterface*>(device);
+  design->apply_endpoint_delay(payload.address,
+                               payload.coarse_delay,
+                               payload.fine_delay,
+                               payload.phase_delay,
+                               payload.measure_rtt,
+                               payload.control_sfp,
+                               payload.sfp_mux);
+}
+
+void
+UHALDeviceBackend::apply_endpoint_delays(const std::string& device, const timingcmd::TimingMasterEndpointDelays& delays)
+{
+  TraceSpan span("apply_endpoint_delays", "uhal", device);
+  // resolve the design once for the whole batch
+  auto design = get_timing_device<const timing::MasterDesignInterface*>(device);
+  for (auto& delay : delays) {
+    design->apply_endpoint_delay(delay.address,
+                                 delay.coarse_delay,
+                                 delay.fine_delay,
+                                 delay.phase_delay,
+                                 delay.measure_rtt,
+                                 delay.control_sfp,
+                                 delay.sfp_mux);
+  }
+}
+
+void
+UHALDeviceBackend::send_fl_cmd(const std::string& device,
+                               uint32_t fl_cmd_id,          // NOLINT(build/unsigned)
+                               uint32_t channel,            // NOLINT(build/unsigned)
+                               uint32_t number_of_commands) // NOLINT(build/unsigned)
+{
+  TraceSpan span("send_fl_cmd", "uhal", device);
+  auto design = get_timing_device<const timing::MasterDesignInterface*>(device);
+  design->get_master_node_plain()->send_fl_cmd(fl_cmd_id, channel, number_of_commands);
+}
+
+void
+UHALDeviceBackend::send_fl_cmds(const std::string& device, const std::vector<FLCmdWrite>& fl_cmds)
+{
+  TraceSpan span("send_fl_cmds", "uhal", device);
+  // resolve the master node once for the whole batch
+  auto master_node = get_timing_device<const timing::MasterDesignInterface*>(device)->get_master_node_plain();
+  for (auto& fl_cmd : fl_cmds) {
+    master_node->send_fl_cmd(fl_cmd.fl_cmd_id, fl_cmd.channel, fl_cmd.number_of_commands);
+  }
+}
+
+void
+UHALDeviceBackend::scan_endpoint(const std::string& master_device,
+                                 const std::string& fanout_device,
+                                 const timingcmd::EndpointLocation& location)
+{
+  TraceSpan span("scan_endpoint", "uhal", master_device);
+  auto master_design = get_timing_device<const timing::MasterDesignInterface*>(master_device);
+
+  try {
+    master_design->get_master_node_plain()->switch_endpoint_sfp(location.address, true);
+
+    if (location.sfp_slot >= 0) {
+      if (location.fanout_slot > 0) {
+        // configure fanout/FIB
+        get_timing_device<const timing::CDRMuxDesignInterface*>(fanout_device)->switch_cdr_mux(location.sfp_slot);
+
+        // configure MIB
+        dynamic_cast<const timing::CDRMuxDesignInterface*>(master_design)->switch_cdr_mux(location.fanout_slot - 1);
+      } else {
+        dynamic_cast<const timing::MasterMuxDesign*>(master_design)->switch_downstream_mux_channel(location.sfp_slot, false);
+      }
+    }
+    // configure any master mux, possibly
+    master_design->get_master_node_plain()->scan_endpoint(location.address, false);
+    master_design->get_master_node_plain()->switch_endpoint_sfp(location.address, false);
+  } catch (...) {
+    master_design->get_master_node_plain()->switch_endpoint_sfp(location.address, false);
+    throw;
+  }
+}
+
+// endpoint
+void
+UHALDeviceBackend::endpoint_enable(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload)
+{
+  TraceSpan span("endpoint_enable", "uhal", device);
+  auto design = get_timing_device<const timing::EndpointDesignInterface*>(device);
+  design->get_endpoint_node_plain(payload.endpoint_id)->enable(payload.address, payload.partition);
+}
+
+void
+UHALDeviceBackend::endpoint_disable(const std::string& device, uint32_t endpoint_id) // NOLINT(build/unsigned)
+{
+  TraceSpan span("endpoint_disable", "uhal", device);
+  auto design = get_timing_device<const timing::EndpointDesignInterface*>(device);
+  design->get_endpoint_node_plain(endpoint_id)->disable();
+}
+
+void
+UHALDeviceBackend::endpoint_reset(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload)
+{
+  TraceSpan span("endpoint_reset", "uhal", device);
+  auto design = get_timing_device<const timing::EndpointDesignInterface*>(device);
+  design->get_endpoint_node_plain(payload.endpoint_id)->reset(payload.address, payload.partition);
+}
+
+// hsi
+void
+UHALDeviceBackend::hsi_reset(const std::string& device)
+{
+  TraceSpan span("hsi_reset", "uhal", device);
+  get_timing_device<const timing::HSIDesignInterface*>(device)->get_hsi_node().reset_hsi();
+}
+
+void
+UHALDeviceBackend::hsi_configure(const std::string& device, const timingcmd::HSIConfigureCmdPayload& payload)
+{
+  TraceSpan span("hsi_configure", "uhal", device);
+  auto design = get_timing_device<const timing::HSIDesignInterface*>(device);
+  design->configure_hsi(
+    payload.data_source, payload.rising_edge_mask, payload.falling_edge_mask, payload.invert_edge_mask, payload.random_rate);
+}
+
+void
+UHALDeviceBackend::hsi_start(const std::string& device)
+{
+  TraceSpan span("hsi_start", "uhal", device);
+  get_timing_device<const timing::HSIDesignInterface*>(device)->get_hsi_node().start_hsi();
+}
+
+void
+UHALDeviceBackend::hsi_stop(const std::string& device)
+{
+  TraceSpan span("hsi_stop", "uhal", device);
+  get_timing_device<const timing::HSIDesignInterface*>(device)->get_hsi_node().stop_hsi();
+}
+
+std::string
+UHALDeviceBackend::get_hsi_status(const std::string& device)
+{
+  TraceSpan span("get_hsi_status", "uhal", device);
+  return get_timing_device<const timing::HSIDesignInterface*>(device)->get_hsi_node().get_status();
+}
+
+uint32_t // NOLINT(build/unsigned)
+UHALDeviceBackend::read_hsi_buffer(const std::string& device, std::vector<uint32_t>& words) // NOLINT(build/unsigned)
+{
+  TraceSpan span("read_hsi_buffer", "uhal", device);
+  const auto& hsi_node = get_timing_device<const timing::HSIDesignInterface*>(device)->get_hsi_node();
+
+  // reads the buffer count, then the complete events in a single block read of that size
+  uint16_t n_words = 0; // NOLINT(build/unsigned)
+  auto buffer = hsi_node.read_data_buffer(n_words, false, true);
+  words.assign(buffer.begin(), buffer.end());
+  return n_words;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
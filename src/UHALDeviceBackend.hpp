@@ -0,0 +1,99 @@
+/**
+ * @file UHALDeviceBackend.hpp
+ *
+ * UHALDeviceBackend is the TimingDeviceBackend which talks to timing
+ * hardware over IPBus, using the designs of the timing package.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_UHALDEVICEBACKEND_HPP_
+#define TIMINGLIBS_SRC_UHALDEVICEBACKEND_HPP_
+
+#include "TimingDeviceBackend.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "timing/TimingNode.hpp"
+
+#include "uhal/ConnectionManager.hpp"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief UHALDeviceBackend creates uhal::HwInterfaces on demand from a
+ * connection manager and casts their top nodes to the design interface
+ * needed by each operation.
+ */
+class UHALDeviceBackend : public TimingDeviceBackend
+{
+public:
+  /**
+   * @brief UHALDeviceBackend Constructor
+   * @param connection_manager Source of the device interfaces; must outlive the backend
+   */
+  explicit UHALDeviceBackend(uhal::ConnectionManager& connection_manager);
+
+  void prepare_device(const std::string& device) override;
+  void io_reset(const std::string& device, const timingcmd::IOResetCmdPayload& payload) override;
+  std::string get_status(const std::string& device) override;
+  void get_info(const std::string& device, timing::timingfirmwareinfo::TimingDeviceInfo& info) override;
+  LinkState read_link_state(const std::string& device) override;
+  void read_registers(const std::string& device,
+                      const std::vector<std::string>& nodes,
+                      std::vector<uint32_t>& values) override; // NOLINT(build/unsigned)
+
+  void sync_timestamp(const std::string& device, uint32_t timestamp_source) override; // NOLINT(build/unsigned)
+  void apply_endpoint_delay(const std::string& device,
+                            const timingcmd::TimingMasterSetEndpointDelayCmdPayload& payload) override;
+  void apply_endpoint_delays(const std::string& device, const timingcmd::TimingMasterEndpointDelays& delays) override;
+  void send_fl_cmd(const std::string& device,
+                   uint32_t fl_cmd_id,                   // NOLINT(build/unsigned)
+                   uint32_t channel,                     // NOLINT(build/unsigned)
+                   uint32_t number_of_commands) override; // NOLINT(build/unsigned)
+  void send_fl_cmds(const std::string& device, const std::vector<FLCmdWrite>& fl_cmds) override;
+  void scan_endpoint(const std::string& master_device,
+                     const std::string& fanout_device,
+                     const timingcmd::EndpointLocation& location) override;
+
+  void endpoint_enable(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload) override;
+  void endpoint_disable(const std::string& device, uint32_t endpoint_id) override; // NOLINT(build/unsigned)
+  void endpoint_reset(const std::string& device, const timingcmd::TimingEndpointConfigureCmdPayload& payload) override;
+
+  void hsi_reset(const std::string& device) override;
+  void hsi_configure(const std::string& device, const timingcmd::HSIConfigureCmdPayload& payload) override;
+  void hsi_start(const std::string& device) override;
+  void hsi_stop(const std::string& device) override;
+  std::string get_hsi_status(const std::string& device) override;
+  uint32_t read_hsi_buffer(const std::string& device, std::vector<uint32_t>& words) override; // NOLINT(build/unsigned)
+
+  // retrieve top level/design object for a timing device
+  template<class TIMING_DEV>
+  TIMING_DEV get_timing_device(const std::string& device_name);
+  const timing::TimingNode* get_timing_device_plain(const std::string& device_name);
+
+private:
+
+  uhal::ConnectionManager& m_connection_manager;
+  std::map<std::string, std::unique_ptr<uhal::HwInterface>> m_hw_device_map;
+  std::mutex m_hw_device_map_mutex;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#include "detail/UHALDeviceBackend.hxx"
+
+#endif // TIMINGLIBS_SRC_UHALDEVICEBACKEND_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
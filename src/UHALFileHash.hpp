@@ -0,0 +1,77 @@
+/**
+ * @file UHALFileHash.hpp
+ *
+ * Hashing of a uhal connections file together with the address tables it
+ * refers to, so that a connection manager is only rebuilt when one of them
+ * changed.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_UHALFILEHASH_HPP_
+#define TIMINGLIBS_SRC_UHALFILEHASH_HPP_
+
+#include "ContentHash.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <set>
+#include <string>
+
+namespace dunedaq {
+namespace timinglibs {
+
+inline void
+resolve_environment_variables(std::string& input_string)
+{
+  static std::regex env_var_pattern("\\$\\{([^}]+)\\}");
+  std::smatch match;
+  while (std::regex_search(input_string, match, env_var_pattern)) {
+    const char* s = getenv(match[1].str().c_str());
+    const std::string env_var(s == nullptr ? "" : s);
+    input_string.replace(match[0].first, match[0].second, env_var);
+  }
+}
+
+// hash of the content of a uhal xml file and of the files it refers to: the address tables of a connections file,
+// and the modules of an address table. References are resolved like uhal does, environment variables first, then
+// relative to the referring file. An unreadable file hashes to the empty content, and is reported by uhal
+inline uint64_t // NOLINT(build/unsigned)
+hash_uhal_file(const std::string& path, uint64_t hash, std::set<std::string>& hashed_paths) // NOLINT(build/unsigned)
+{
+  if (!hashed_paths.insert(path).second) {
+    return hash;
+  }
+
+  std::ifstream file_stream(path, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(file_stream)), std::istreambuf_iterator<char>());
+  hash = fnv1a_hash(content, fnv1a_hash(path, hash));
+
+  static std::regex file_reference_pattern(R"re((?:address_table|module)\s*=\s*"file://([^"]+)")re");
+  auto directory_end = path.find_last_of('/');
+  auto directory = directory_end == std::string::npos ? std::string() : path.substr(0, directory_end + 1);
+  for (std::sregex_iterator reference(content.begin(), content.end(), file_reference_pattern), end; reference != end;
+       ++reference) {
+    std::string referenced_path = (*reference)[1].str();
+    resolve_environment_variables(referenced_path);
+    if (referenced_path.empty() || referenced_path.front() != '/') {
+      referenced_path = directory + referenced_path;
+    }
+    hash = hash_uhal_file(referenced_path, hash, hashed_paths);
+  }
+  return hash;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_UHALFILEHASH_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
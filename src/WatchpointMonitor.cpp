@@ -0,0 +1,393 @@
+/**
+ * @file WatchpointMonitor.cpp WatchpointMonitor class
+ * implementation
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "WatchpointMonitor.hpp"
+#include "SlicedSleep.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#include "iomanager/IOManager.hpp"
+#include "logging/Logging.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+WatchpointMonitor::WatchpointMonitor(TimingDeviceBackend& backend, const ThreadPlacement& placement)
+  : m_backend(backend)
+  , m_placement(placement)
+  , m_send_timeout(1)
+  , m_thread(std::bind(&WatchpointMonitor::run_monitor, this, std::placeholders::_1))
+{
+}
+
+WatchpointMonitor::~WatchpointMonitor()
+{
+  stop();
+}
+
+bool
+WatchpointMonitor::Watchpoint::evaluate(uint32_t field) const // NOLINT(build/unsigned)
+{
+  switch (predicate) {
+    case Predicate::kEqual:
+      return field == params.value;
+    case Predicate::kNotEqual:
+      return field != params.value;
+    case Predicate::kLess:
+      return field < params.value;
+    case Predicate::kLessOrEqual:
+      return field <= params.value;
+    case Predicate::kGreater:
+      return field > params.value;
+    case Predicate::kGreaterOrEqual:
+      return field >= params.value;
+    case Predicate::kInside:
+      return field > params.value && field < params.upper;
+    case Predicate::kOutside:
+    default:
+      return field <= params.value || field >= params.upper;
+  }
+}
+
+WatchpointMonitor::Predicate
+WatchpointMonitor::parse_predicate(const std::string& device, const timingcmd::Watchpoint& watchpoint)
+{
+  static const std::map<std::string, Predicate> predicates{
+    { "eq", Predicate::kEqual },         { "ne", Predicate::kNotEqual },     { "lt", Predicate::kLess },
+    { "le", Predicate::kLessOrEqual },   { "gt", Predicate::kGreater },      { "ge", Predicate::kGreaterOrEqual },
+    { "inside", Predicate::kInside },    { "outside", Predicate::kOutside },
+  };
+  auto predicate = predicates.find(watchpoint.predicate);
+  if (predicate == predicates.end()) {
+    throw InvalidWatchpoint(ERS_HERE, device, watchpoint.id, "unknown predicate " + watchpoint.predicate);
+  }
+  return predicate->second;
+}
+
+void
+WatchpointMonitor::register_watchpoints(const std::string& device,
+                                        const timingcmd::TimingRegisterWatchpointsCmdPayload& payload)
+{
+  if (payload.subscriber.empty()) {
+    throw InvalidWatchpoint(ERS_HERE, device, "", "no subscriber");
+  }
+
+  std::set<std::string> ids;
+  std::vector<std::string> nodes;
+  for (auto& watchpoint : payload.watchpoints) {
+    parse_predicate(device, watchpoint);
+    if (!ids.insert(watchpoint.id).second) {
+      throw InvalidWatchpoint(ERS_HERE, device, watchpoint.id, "duplicate id");
+    }
+    if (!watchpoint.mask) {
+      throw InvalidWatchpoint(ERS_HERE, device, watchpoint.id, "empty mask");
+    }
+    nodes.push_back(watchpoint.node);
+  }
+
+  // the registers have to exist, rather than failing every read later
+  std::vector<uint32_t> values; // NOLINT(build/unsigned)
+  m_backend.read_registers(device, nodes, values);
+
+  auto event_connection = payload.event_connection.empty() ? device + "_watch_events" : payload.event_connection;
+  auto event_sender = iomanager::IOManager::get()->get_sender<nlohmann::json>(event_connection);
+
+  std::lock_guard<std::mutex> devices_lock(m_devices_mutex);
+  auto [watched_device, inserted] = m_devices.try_emplace(device);
+  if (inserted) {
+    watched_device->second.generation = 0;
+    watched_device->second.failing = false;
+    watched_device->second.stats = DeviceStats{ device, 0, 0, 0, 0 };
+  }
+  watched_device->second.subscriptions[payload.subscriber] =
+    Subscription{ payload.watchpoints,
+                  std::chrono::microseconds(std::max<uint32_t>(payload.interval, 1)), // NOLINT(build/unsigned)
+                  event_sender };
+  rebuild(watched_device->second, payload.subscriber);
+
+  if (!m_thread.thread_running()) {
+    m_thread.start_working_thread(m_placement.get_name());
+  }
+}
+
+void
+WatchpointMonitor::unregister_watchpoints(const std::string& device, const std::string& subscriber)
+{
+  std::lock_guard<std::mutex> devices_lock(m_devices_mutex);
+  auto watched_device = m_devices.find(device);
+  if (watched_device == m_devices.end() || !watched_device->second.subscriptions.erase(subscriber)) {
+    TLOG_DEBUG(1) << device << ": no watchpoints of " << subscriber << " to unregister";
+    return;
+  }
+  if (watched_device->second.subscriptions.empty()) {
+    m_devices.erase(watched_device);
+  } else {
+    rebuild(watched_device->second, subscriber);
+  }
+}
+
+void
+WatchpointMonitor::rebuild(WatchedDevice& device, const std::string& changed_subscriber)
+{
+  // the conditions of the other subscribers carry on, those of the changed subscriber start again
+  std::map<std::pair<std::string, std::string>, Watchpoint> previous;
+  for (auto& watchpoint : device.watchpoints) {
+    if (watchpoint.subscriber != changed_subscriber) {
+      previous.emplace(std::make_pair(watchpoint.subscriber, watchpoint.params.id), watchpoint);
+    }
+  }
+
+  std::map<std::string, size_t> register_indices;
+  device.registers.clear();
+  device.watchpoints.clear();
+  device.interval = clock_t::duration::max();
+  for (auto& [subscriber, subscription] : device.subscriptions) {
+    device.interval = std::min(device.interval, subscription.interval);
+    for (auto& params : subscription.watchpoints) {
+      auto [register_index, new_register] = register_indices.try_emplace(params.node, device.registers.size());
+      if (new_register) {
+        device.registers.push_back(params.node);
+      }
+      if (auto watchpoint = previous.find({ subscriber, params.id }); watchpoint != previous.end()) {
+        watchpoint->second.register_index = register_index->second;
+        device.watchpoints.push_back(watchpoint->second);
+        continue;
+      }
+      uint32_t shift = 0; // NOLINT(build/unsigned)
+      while (!((params.mask >> shift) & 0x1)) {
+        ++shift;
+      }
+      device.watchpoints.push_back(Watchpoint{ subscriber,
+                                               params,
+                                               parse_predicate(device.stats.device, params),
+                                               shift,
+                                               register_index->second,
+                                               subscription.event_sender,
+                                               false,
+                                               0,
+                                               false,
+                                               0 });
+    }
+  }
+
+  // a read in flight uses the previous registers, its values are dropped
+  ++device.generation;
+  device.next_read = clock_t::now();
+}
+
+void
+WatchpointMonitor::stop()
+{
+  if (m_thread.thread_running()) {
+    m_thread.stop_working_thread();
+  }
+}
+
+void
+WatchpointMonitor::pause_device(const std::string& device)
+{
+  {
+    std::lock_guard<std::mutex> devices_lock(m_devices_mutex);
+    m_paused_devices.insert(device);
+  }
+  // wait for a read of the device started before
+  std::lock_guard<std::mutex> read_lock(m_read_mutex);
+}
+
+void
+WatchpointMonitor::resume_device(const std::string& device)
+{
+  std::lock_guard<std::mutex> devices_lock(m_devices_mutex);
+  m_paused_devices.erase(device);
+  if (auto watched_device = m_devices.find(device); watched_device != m_devices.end()) {
+    watched_device->second.next_read = clock_t::now();
+  }
+}
+
+std::vector<WatchpointMonitor::WatchpointStats>
+WatchpointMonitor::get_watchpoint_stats() const
+{
+  std::vector<WatchpointStats> stats;
+  std::lock_guard<std::mutex> devices_lock(m_devices_mutex);
+  for (auto& [device_name, device] : m_devices) {
+    for (auto& watchpoint : device.watchpoints) {
+      stats.push_back(WatchpointStats{ device_name,
+                                       watchpoint.subscriber,
+                                       watchpoint.params.id,
+                                       watchpoint.field,
+                                       watchpoint.condition,
+                                       watchpoint.transitions });
+    }
+  }
+  return stats;
+}
+
+std::vector<WatchpointMonitor::DeviceStats>
+WatchpointMonitor::get_device_stats() const
+{
+  std::vector<DeviceStats> stats;
+  std::lock_guard<std::mutex> devices_lock(m_devices_mutex);
+  for (auto& [device_name, device] : m_devices) {
+    stats.push_back(device.stats);
+  }
+  return stats;
+}
+
+void
+WatchpointMonitor::run_monitor(std::atomic<bool>& running_flag)
+{
+  m_placement.apply(pthread_self());
+  TLOG_DEBUG(0) << "Starting watchpoint monitor";
+
+  // reused between reads
+  std::string device_name;
+  std::vector<std::string> registers;
+  std::vector<uint32_t> values; // NOLINT(build/unsigned)
+  std::vector<Event> events;
+
+  // a registration sets the next read of its device to now, so sleeps are capped to be noticed soon after
+  auto max_sleep = std::chrono::milliseconds(10);
+
+  std::unique_lock<std::mutex> devices_lock(m_devices_mutex);
+  while (running_flag.load()) {
+    auto due = m_devices.end();
+    for (auto device = m_devices.begin(); device != m_devices.end(); ++device) {
+      if (m_paused_devices.count(device->first)) {
+        continue;
+      }
+      if (due == m_devices.end() || device->second.next_read < due->second.next_read) {
+        due = device;
+      }
+    }
+    auto now = clock_t::now();
+    if (due == m_devices.end() || due->second.next_read > now) {
+      auto wake_time = due == m_devices.end() ? now + max_sleep : std::min(due->second.next_read, now + max_sleep);
+      devices_lock.unlock();
+      sleep_until_or_stopped(wake_time, running_flag);
+      devices_lock.lock();
+      continue;
+    }
+
+    // a read slower than the interval of the device delays its next read to now, the reads it overran are not made
+    // up
+    device_name = due->first;
+    registers = due->second.registers;
+    auto generation = due->second.generation;
+    due->second.next_read = std::max(due->second.next_read + due->second.interval, now);
+
+    std::unique_lock<std::mutex> read_lock(m_read_mutex);
+    devices_lock.unlock();
+    bool read = true;
+    std::string failure;
+    try {
+      m_backend.read_registers(device_name, registers, values);
+    } catch (const std::exception& excpt) {
+      read = false;
+      failure = excpt.what();
+    }
+    read_lock.unlock();
+    devices_lock.lock();
+
+    auto device = m_devices.find(device_name);
+    if (device == m_devices.end()) {
+      continue;
+    }
+    if (!read) {
+      // one warning per outage of the device rather than one per interval, the failed reads are in the stats
+      if (!device->second.failing) {
+        ers::warning(WatchpointReadFailed(ERS_HERE, device_name, failure));
+      }
+      device->second.failing = true;
+      ++device->second.stats.read_failures;
+      continue;
+    }
+    device->second.failing = false;
+    ++device->second.stats.reads;
+    if (device->second.generation != generation) {
+      continue;
+    }
+
+    events.clear();
+    evaluate(device_name, device->second, values, events);
+    if (events.empty()) {
+      continue;
+    }
+
+    devices_lock.unlock();
+    uint64_t events_sent = 0; // NOLINT(build/unsigned)
+    for (auto& event : events) {
+      try {
+        event.sender->send(std::move(event.event), m_send_timeout);
+        ++events_sent;
+      } catch (const iomanager::TimeoutExpired& excpt) {
+        ers::warning(excpt);
+      }
+    }
+    devices_lock.lock();
+
+    if (device = m_devices.find(device_name); device != m_devices.end()) {
+      device->second.stats.events_sent += events_sent;
+      device->second.stats.events_failed_to_send += events.size() - events_sent;
+    }
+  }
+
+  TLOG_DEBUG(0) << "Watchpoint monitor stopped";
+}
+
+void
+WatchpointMonitor::evaluate(const std::string& device_name,
+                            WatchedDevice& device,
+                            const std::vector<uint32_t>& values, // NOLINT(build/unsigned)
+                            std::vector<Event>& events)
+{
+  auto detected_at =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+  for (auto& watchpoint : device.watchpoints) {
+    uint32_t field = (values[watchpoint.register_index] & watchpoint.params.mask) >> watchpoint.shift; // NOLINT(build/unsigned)
+    bool condition = watchpoint.evaluate(field);
+    watchpoint.field = field;
+    if (watchpoint.evaluated && condition == watchpoint.condition) {
+      continue;
+    }
+
+    bool initial = !watchpoint.evaluated;
+    if (!initial) {
+      ++watchpoint.transitions;
+      TLOG_DEBUG(1) << device_name << ": watchpoint " << watchpoint.params.id << " of " << watchpoint.subscriber
+                    << " now " << condition << ", field: 0x" << std::hex << field << std::dec;
+    }
+    watchpoint.evaluated = true;
+    watchpoint.condition = condition;
+
+    nlohmann::json event;
+    event["device"] = device_name;
+    event["subscriber"] = watchpoint.subscriber;
+    event["watchpoint"] = watchpoint.params.id;
+    event["field"] = field;
+    event["condition"] = condition;
+    event["initial"] = initial;
+    event["detected_at"] = detected_at;
+    events.push_back(Event{ watchpoint.event_sender, std::move(event) });
+  }
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
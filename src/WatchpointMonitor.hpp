@@ -0,0 +1,192 @@
+/**
+ * @file WatchpointMonitor.hpp
+ *
+ * WatchpointMonitor evaluates conditions on register fields of timing
+ * devices, registered by their subscribers, and sends the changes of the
+ * conditions, from a dedicated thread.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_SRC_WATCHPOINTMONITOR_HPP_
+#define TIMINGLIBS_SRC_WATCHPOINTMONITOR_HPP_
+
+#include "ThreadPlacement.hpp"
+#include "TimingDeviceBackend.hpp"
+
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include "iomanager/Sender.hpp"
+
+#include "nlohmann/json.hpp"
+#include "utilities/WorkerThread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief WatchpointMonitor reads, for each device with watchpoints, the
+ * registers of all its watchpoints in one transaction, at the shortest
+ * interval its subscribers asked for. Only the changes of the conditions
+ * are sent, to the event connection of the subscriber:
+ *
+ *   { "device", "subscriber", "watchpoint", "field", "condition", "initial", "detected_at" }
+ *
+ * with detected_at in ns since the epoch. The first evaluation of a
+ * watchpoint is sent too, with initial set, so that subscribers know the
+ * condition to start from. A paused device, e.g. during its io reset, is
+ * not read; its watchpoints are read again as soon as it is resumed.
+ */
+class WatchpointMonitor
+{
+public:
+  using clock_t = std::chrono::steady_clock;
+
+  struct WatchpointStats
+  {
+    std::string device;
+    std::string subscriber;
+    std::string watchpoint;
+    uint32_t field;       // NOLINT(build/unsigned)
+    bool condition;
+    uint64_t transitions; // NOLINT(build/unsigned)
+  };
+
+  struct DeviceStats
+  {
+    std::string device;
+    uint64_t reads;                 // NOLINT(build/unsigned)
+    uint64_t read_failures;         // NOLINT(build/unsigned)
+    uint64_t events_sent;           // NOLINT(build/unsigned)
+    uint64_t events_failed_to_send; // NOLINT(build/unsigned)
+  };
+
+  /**
+   * @brief WatchpointMonitor Constructor
+   * @param backend Device access; must outlive the monitor
+   * @param placement Placement of the monitor thread
+   */
+  WatchpointMonitor(TimingDeviceBackend& backend, const ThreadPlacement& placement);
+  ~WatchpointMonitor();
+
+  WatchpointMonitor(const WatchpointMonitor&) = delete;            ///< WatchpointMonitor is not copy-constructible
+  WatchpointMonitor& operator=(const WatchpointMonitor&) = delete; ///< WatchpointMonitor is not copy-assignable
+  WatchpointMonitor(WatchpointMonitor&&) = delete;                 ///< WatchpointMonitor is not move-constructible
+  WatchpointMonitor& operator=(WatchpointMonitor&&) = delete;      ///< WatchpointMonitor is not move-assignable
+
+  /**
+   * @brief Replace the watchpoints of a subscriber on a device. Throws InvalidWatchpoint, or the issue of the
+   * device read, if a watchpoint cannot be evaluated.
+   */
+  void register_watchpoints(const std::string& device, const timingcmd::TimingRegisterWatchpointsCmdPayload& payload);
+  void unregister_watchpoints(const std::string& device, const std::string& subscriber);
+
+  void stop();
+
+  /**
+   * @brief Stop reading a device, once the read in flight, if any, is done
+   */
+  void pause_device(const std::string& device);
+  void resume_device(const std::string& device);
+
+  std::vector<WatchpointStats> get_watchpoint_stats() const;
+  std::vector<DeviceStats> get_device_stats() const;
+
+private:
+  using sink_t = iomanager::SenderConcept<nlohmann::json>;
+
+  enum class Predicate
+  {
+    kEqual,
+    kNotEqual,
+    kLess,
+    kLessOrEqual,
+    kGreater,
+    kGreaterOrEqual,
+    kInside,
+    kOutside
+  };
+
+  struct Watchpoint
+  {
+    std::string subscriber;
+    timingcmd::Watchpoint params;
+    Predicate predicate;
+    uint32_t shift;          // NOLINT(build/unsigned)
+    size_t register_index;   ///< in the registers of the device
+    std::shared_ptr<sink_t> event_sender;
+    bool evaluated;
+    uint32_t field;          // NOLINT(build/unsigned)
+    bool condition;
+    uint64_t transitions;    // NOLINT(build/unsigned)
+
+    bool evaluate(uint32_t field) const; // NOLINT(build/unsigned)
+  };
+
+  struct Subscription
+  {
+    std::vector<timingcmd::Watchpoint> watchpoints;
+    clock_t::duration interval;
+    std::shared_ptr<sink_t> event_sender;
+  };
+
+  struct WatchedDevice
+  {
+    std::map<std::string, Subscription> subscriptions;
+    // built from the subscriptions
+    std::vector<std::string> registers;
+    std::vector<Watchpoint> watchpoints;
+    clock_t::duration interval;
+    clock_t::time_point next_read;
+    uint64_t generation;     // NOLINT(build/unsigned)
+    bool failing;
+    DeviceStats stats;
+  };
+
+  struct Event
+  {
+    std::shared_ptr<sink_t> sender;
+    nlohmann::json event;
+  };
+
+  static Predicate parse_predicate(const std::string& device, const timingcmd::Watchpoint& watchpoint);
+  void rebuild(WatchedDevice& device, const std::string& changed_subscriber);
+  void run_monitor(std::atomic<bool>& running_flag);
+  void evaluate(const std::string& device_name,
+                WatchedDevice& device,
+                const std::vector<uint32_t>& values, // NOLINT(build/unsigned)
+                std::vector<Event>& events);
+
+  TimingDeviceBackend& m_backend;
+  ThreadPlacement m_placement;
+  std::chrono::milliseconds m_send_timeout;
+
+  std::map<std::string, WatchedDevice> m_devices;
+  std::set<std::string> m_paused_devices;
+  mutable std::mutex m_devices_mutex;
+  // held during each read, taken with m_devices_mutex held, so that a device is not accessed once paused
+  std::mutex m_read_mutex;
+
+  dunedaq::utilities::WorkerThread m_thread;
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_SRC_WATCHPOINTMONITOR_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
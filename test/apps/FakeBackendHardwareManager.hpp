@@ -0,0 +1,214 @@
+/**
+ * @file FakeBackendHardwareManager.hpp
+ *
+ * FakeBackendHardwareManager is a hardware manager on a fake device backend,
+ * exposing its command dispatch path and its receiver callback to the
+ * benchmark and load test applications, together with the hardware command
+ * payloads they send.
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef TIMINGLIBS_TEST_APPS_FAKEBACKENDHARDWAREMANAGER_HPP_
+#define TIMINGLIBS_TEST_APPS_FAKEBACKENDHARDWAREMANAGER_HPP_
+
+#include "FakeDeviceBackend.hpp"
+#include "TimingHardwareManagerBase.hpp"
+
+#include "timinglibs/timingcmd/Nljs.hpp"
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include "iomanager/IOManager.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+/**
+ * @brief Hardware manager on a FakeDeviceBackend, with the commands of
+ * fake_hw_cmd_ids registered, driven either directly or from a receiver
+ */
+class FakeBackendHardwareManager : public TimingHardwareManagerBase
+{
+public:
+  /**
+   * @param name Instance name
+   * @param backend_latency Latency of each operation of the fake backend
+   */
+  explicit FakeBackendHardwareManager(const std::string& name,
+                                      std::chrono::microseconds backend_latency = std::chrono::microseconds(0))
+    : TimingHardwareManagerBase(name)
+  {
+    m_device_backend = std::make_unique<FakeDeviceBackend>(backend_latency);
+    register_common_hw_commands_for_design();
+    register_master_hw_commands_for_design();
+    register_endpoint_hw_commands_for_design();
+    register_hsi_hw_commands_for_design();
+  }
+
+  void dispatch(timingcmd::TimingHwCmd& hw_cmd) { process_hardware_command(hw_cmd); }
+
+  /**
+   * @brief Handle the commands received on a connection with the manager's receiver callback, as conf does
+   */
+  void start_receiving(const std::string& connection)
+  {
+    m_hw_cmd_connection = connection;
+    m_hw_command_receiver = iomanager::IOManager::get()->get_receiver<timingcmd::TimingHwCmd>(m_hw_cmd_connection);
+    m_hw_command_receiver->add_callback(
+      std::bind(&FakeBackendHardwareManager::process_hardware_command, this, std::placeholders::_1));
+  }
+  void stop_receiving()
+  {
+    if (m_hw_command_receiver) {
+      m_hw_command_receiver->remove_callback();
+    }
+  }
+
+  /**
+   * @brief Called once each command has been handled: by the receiver callback, or for an io reset by its thread
+   */
+  void set_handled_callback(std::function<void(const timingcmd::TimingHwCmd&)> handled) { m_handled = std::move(handled); }
+
+  bool lookup(const std::string& hw_cmd_id) { return m_timing_hw_cmd_map_.find(hw_cmd_id) != m_timing_hw_cmd_map_.end(); }
+
+  TimingDeviceBackend& backend() { return *m_device_backend; }
+
+  void partition_configure(const timingcmd::TimingHwCmd& /*hw_cmd*/) override {}
+
+  // io resets run on threads of their own, dispatch returns once they are started
+  using TimingHardwareManagerBase::wait_for_io_reset;
+  using TimingHardwareManagerBase::wait_for_io_resets;
+
+protected:
+  void process_hardware_command(timingcmd::TimingHwCmd& hw_cmd) override
+  {
+    TimingHardwareManagerBase::process_hardware_command(hw_cmd);
+    if (m_handled && hw_cmd.id != "io_reset") {
+      m_handled(hw_cmd);
+    }
+  }
+  void perform_io_reset(const timingcmd::TimingHwCmd& hw_cmd) override
+  {
+    TimingHardwareManagerBase::perform_io_reset(hw_cmd);
+    if (m_handled) {
+      m_handled(hw_cmd);
+    }
+  }
+
+  void register_common_hw_commands_for_design() override
+  {
+    register_timing_hw_command("io_reset", &FakeBackendHardwareManager::io_reset);
+  }
+  void register_master_hw_commands_for_design() override
+  {
+    register_timing_hw_command("set_timestamp", &FakeBackendHardwareManager::set_timestamp);
+    register_timing_hw_command("set_endpoint_delay", &FakeBackendHardwareManager::set_endpoint_delay);
+    register_timing_hw_command("send_fl_command", &FakeBackendHardwareManager::send_fl_cmd);
+  }
+  void register_endpoint_hw_commands_for_design() override
+  {
+    register_timing_hw_command("endpoint_enable", &FakeBackendHardwareManager::endpoint_enable);
+    register_timing_hw_command("endpoint_disable", &FakeBackendHardwareManager::endpoint_disable);
+    register_timing_hw_command("endpoint_reset", &FakeBackendHardwareManager::endpoint_reset);
+  }
+  void register_hsi_hw_commands_for_design() override
+  {
+    register_timing_hw_command("hsi_reset", &FakeBackendHardwareManager::hsi_reset);
+    register_timing_hw_command("hsi_configure", &FakeBackendHardwareManager::hsi_configure);
+    register_timing_hw_command("hsi_start", &FakeBackendHardwareManager::hsi_start);
+    register_timing_hw_command("hsi_stop", &FakeBackendHardwareManager::hsi_stop);
+  }
+
+private:
+  std::function<void(const timingcmd::TimingHwCmd&)> m_handled;
+};
+
+/**
+ * @brief Ids of the hardware commands registered by FakeBackendHardwareManager
+ */
+inline const std::vector<std::string>&
+fake_hw_cmd_ids()
+{
+  static const std::vector<std::string> s_hw_cmd_ids{ "io_reset",        "set_timestamp",    "set_endpoint_delay",
+                                                      "send_fl_command", "endpoint_enable",  "endpoint_disable",
+                                                      "endpoint_reset",  "hsi_reset",        "hsi_configure",
+                                                      "hsi_start",       "hsi_stop" };
+  return s_hw_cmd_ids;
+}
+
+/**
+ * @brief Payload of a hardware command, for the endpoint at an address where the command has one
+ */
+inline nlohmann::json
+make_hw_cmd_payload(const std::string& hw_cmd_id, uint32_t address) // NOLINT(build/unsigned)
+{
+  nlohmann::json payload;
+  if (hw_cmd_id == "io_reset") {
+    timingcmd::IOResetCmdPayload io_reset;
+    io_reset.clock_source = 0;
+    io_reset.soft = true;
+    io_reset.clock_config = "";
+    timingcmd::to_json(payload, io_reset);
+  } else if (hw_cmd_id == "set_timestamp") {
+    timingcmd::SyncTimestampPayload set_timestamp;
+    set_timestamp.timestamp_source = 1;
+    timingcmd::to_json(payload, set_timestamp);
+  } else if (hw_cmd_id == "set_endpoint_delay") {
+    timingcmd::TimingMasterSetEndpointDelayCmdPayload endpoint_delay;
+    endpoint_delay.address = address;
+    endpoint_delay.coarse_delay = 1;
+    endpoint_delay.fine_delay = 2;
+    endpoint_delay.phase_delay = 3;
+    endpoint_delay.measure_rtt = false;
+    endpoint_delay.control_sfp = false;
+    endpoint_delay.sfp_mux = -1;
+    timingcmd::to_json(payload, endpoint_delay);
+  } else if (hw_cmd_id == "send_fl_command") {
+    timingcmd::TimingMasterSendFLCmdCmdPayload fl_cmd;
+    fl_cmd.fl_cmd_id = 1;
+    fl_cmd.channel = 0;
+    fl_cmd.number_of_commands_to_send = 1;
+    timingcmd::to_json(payload, fl_cmd);
+  } else if (hw_cmd_id == "endpoint_disable") {
+    timingcmd::TimingEndpointCmdPayload endpoint;
+    endpoint.endpoint_id = 0;
+    timingcmd::to_json(payload, endpoint);
+  } else if (hw_cmd_id == "endpoint_enable" || hw_cmd_id == "endpoint_reset") {
+    timingcmd::TimingEndpointConfigureCmdPayload endpoint_configure;
+    endpoint_configure.endpoint_id = 0;
+    endpoint_configure.address = address;
+    endpoint_configure.partition = 0;
+    timingcmd::to_json(payload, endpoint_configure);
+  } else if (hw_cmd_id == "hsi_configure") {
+    timingcmd::HSIConfigureCmdPayload hsi_configure;
+    hsi_configure.rising_edge_mask = 0x1;
+    hsi_configure.falling_edge_mask = 0x0;
+    hsi_configure.invert_edge_mask = 0x0;
+    hsi_configure.data_source = 0;
+    hsi_configure.random_rate = 1.;
+    timingcmd::to_json(payload, hsi_configure);
+  } else {
+    payload = nlohmann::json::object();
+  }
+  return payload;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+#endif // TIMINGLIBS_TEST_APPS_FAKEBACKENDHARDWAREMANAGER_HPP_
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
@@ -0,0 +1,288 @@
+/**
+ * @file hw_cmd_dispatch_benchmark.cxx
+ *
+ * Microbenchmark of the hardware manager command dispatch path:
+ * process_hardware_command() against a zero-latency fake device backend,
+ * and its constituent steps (payload parsing, command map lookup, bound
+ * handler invocation, device backend call), for each hardware command type.
+ *
+ * Given a uhal connections file and a device in it, the design lookup of the
+ * uhal backend (get_timing_device, i.e. the device map lookup and the casts
+ * of the top node to the design interface) is also compared with the lookup
+ * of a cached typed pointer. The device interface is only created from the
+ * address table, the hardware is not accessed.
+ *
+ * Usage: timinglibs_hw_cmd_dispatch_benchmark [iterations] [json report file]
+ *          [uhal connections file] [device]
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "FakeBackendHardwareManager.hpp"
+#include "UHALDeviceBackend.hpp"
+
+#include "timinglibs/timingcmd/Nljs.hpp"
+#include "timinglibs/timingcmd/Structs.hpp"
+
+#include "timing/TopDesignInterface.hpp"
+
+#include "nlohmann/json.hpp"
+#include "uhal/ConnectionManager.hpp"
+#include "uhal/log/log.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> s_count_allocations{ false };
+std::atomic<uint64_t> s_allocations{ 0 }; // NOLINT(build/unsigned)
+
+} // namespace
+
+// count heap allocations made while a benchmark loop is running
+void*
+operator new(std::size_t size)
+{
+  if (s_count_allocations.load(std::memory_order_relaxed)) {
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace dunedaq {
+namespace timinglibs {
+
+struct BenchmarkResult
+{
+  std::string name;
+  uint64_t iterations; // NOLINT(build/unsigned)
+  double calls_per_second;
+  double p50_ns;
+  double p99_ns;
+  double allocations_per_call;
+};
+
+template<typename F>
+BenchmarkResult
+run_benchmark(const std::string& name, uint64_t iterations, F&& f) // NOLINT(build/unsigned)
+{
+  using clock = std::chrono::steady_clock;
+
+  for (uint64_t i = 0; i < iterations / 10 + 1; ++i) { // NOLINT(build/unsigned)
+    f();
+  }
+
+  std::vector<int64_t> latencies(iterations);
+
+  s_allocations = 0;
+  s_count_allocations = true;
+  auto start = clock::now();
+  for (uint64_t i = 0; i < iterations; ++i) { // NOLINT(build/unsigned)
+    auto call_start = clock::now();
+    f();
+    latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - call_start).count();
+  }
+  auto total = clock::now() - start;
+  s_count_allocations = false;
+
+  auto percentile = [&latencies](double fraction) {
+    auto nth = latencies.begin() + static_cast<int64_t>(fraction * static_cast<double>(latencies.size() - 1));
+    std::nth_element(latencies.begin(), nth, latencies.end());
+    return static_cast<double>(*nth);
+  };
+
+  BenchmarkResult result;
+  result.name = name;
+  result.iterations = iterations;
+  result.calls_per_second =
+    static_cast<double>(iterations) / std::chrono::duration_cast<std::chrono::duration<double>>(total).count();
+  result.p50_ns = percentile(0.5);
+  result.p99_ns = percentile(0.99);
+  result.allocations_per_call = static_cast<double>(s_allocations.load()) / static_cast<double>(iterations);
+  return result;
+}
+
+struct CommandCase
+{
+  std::string id;
+  nlohmann::json payload;
+  std::function<void(const nlohmann::json&)> parse;
+};
+
+template<typename PAYLOAD>
+std::function<void(const nlohmann::json&)>
+payload_parser()
+{
+  return [](const nlohmann::json& json_payload) {
+    PAYLOAD cmd_payload;
+    timingcmd::from_json(json_payload, cmd_payload);
+  };
+}
+
+std::function<void(const nlohmann::json&)>
+make_payload_parser(const std::string& hw_cmd_id)
+{
+  if (hw_cmd_id == "io_reset") {
+    return payload_parser<timingcmd::IOResetCmdPayload>();
+  } else if (hw_cmd_id == "set_timestamp") {
+    return payload_parser<timingcmd::SyncTimestampPayload>();
+  } else if (hw_cmd_id == "set_endpoint_delay") {
+    return payload_parser<timingcmd::TimingMasterSetEndpointDelayCmdPayload>();
+  } else if (hw_cmd_id == "send_fl_command") {
+    return payload_parser<timingcmd::TimingMasterSendFLCmdCmdPayload>();
+  } else if (hw_cmd_id == "endpoint_disable") {
+    return payload_parser<timingcmd::TimingEndpointCmdPayload>();
+  } else if (hw_cmd_id == "endpoint_enable" || hw_cmd_id == "endpoint_reset") {
+    return payload_parser<timingcmd::TimingEndpointConfigureCmdPayload>();
+  } else if (hw_cmd_id == "hsi_configure") {
+    return payload_parser<timingcmd::HSIConfigureCmdPayload>();
+  }
+  return [](const nlohmann::json&) {};
+}
+
+std::vector<CommandCase>
+make_command_cases()
+{
+  std::vector<CommandCase> cases;
+  for (auto& hw_cmd_id : fake_hw_cmd_ids()) {
+    cases.push_back({ hw_cmd_id, make_hw_cmd_payload(hw_cmd_id, 1), make_payload_parser(hw_cmd_id) });
+  }
+  return cases;
+}
+
+// keeps the result of a benchmarked call from being optimised away
+template<typename T>
+void
+do_not_optimize(const T& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct NoOpHandler
+{
+  void handle(const timingcmd::TimingHwCmd& /*hw_cmd*/) {}
+};
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+int
+main(int argc, char* argv[])
+{
+  using namespace dunedaq::timinglibs;
+
+  uint64_t iterations = argc > 1 ? std::stoull(argv[1]) : 100000; // NOLINT(build/unsigned)
+  std::string report_file = argc > 2 ? argv[2] : "";
+  std::string connections_file = argc > 4 ? argv[3] : "";
+  std::string uhal_device = argc > 4 ? argv[4] : "";
+
+  FakeBackendHardwareManager manager("benchmark_thi");
+  std::vector<BenchmarkResult> results;
+
+  // bound member function invocation, as done for every registered hw command
+  NoOpHandler handler;
+  std::function<void(const timingcmd::TimingHwCmd&)> bound_handler =
+    std::bind(&NoOpHandler::handle, &handler, std::placeholders::_1);
+  timingcmd::TimingHwCmd noop_cmd;
+  results.push_back(run_benchmark("bind_invoke", iterations, [&]() { std::invoke(bound_handler, noop_cmd); }));
+
+  // device lookup and call through the backend interface, which is where the
+  // design cast of get_timing_device happens with the uhal backend
+  TimingDeviceBackend& backend = manager.backend();
+  results.push_back(
+    run_benchmark("backend_call", iterations, [&]() { backend.endpoint_disable("BENCHMARK_DEVICE", 0); }));
+
+  if (!connections_file.empty()) {
+    uhal::setLogLevelTo(uhal::Error());
+    uhal::ConnectionManager connection_manager("file://" + connections_file);
+    UHALDeviceBackend uhal_backend(connection_manager);
+    uhal_backend.prepare_device(uhal_device);
+
+    // as done by every operation of the uhal backend
+    results.push_back(run_benchmark("uhal/get_timing_device", iterations, [&]() {
+      do_not_optimize(uhal_backend.get_timing_device<const timing::TopDesignInterface*>(uhal_device));
+    }));
+
+    // the alternative: typed pointers cached per device, still looked up by name under a lock
+    std::map<std::string, const timing::TopDesignInterface*> typed_devices{
+      { uhal_device, uhal_backend.get_timing_device<const timing::TopDesignInterface*>(uhal_device) }
+    };
+    std::mutex typed_devices_mutex;
+    results.push_back(run_benchmark("uhal/cached_typed_device", iterations, [&]() {
+      std::lock_guard<std::mutex> typed_devices_lock(typed_devices_mutex);
+      do_not_optimize(typed_devices.find(uhal_device)->second);
+    }));
+  }
+
+  for (auto& command_case : make_command_cases()) {
+    timingcmd::TimingHwCmd hw_cmd;
+    hw_cmd.id = command_case.id;
+    hw_cmd.device = "BENCHMARK_DEVICE";
+    hw_cmd.payload = command_case.payload;
+
+    results.push_back(run_benchmark(
+      command_case.id + "/parse", iterations, [&]() { command_case.parse(hw_cmd.payload); }));
+    results.push_back(run_benchmark(
+      command_case.id + "/lookup", iterations, [&]() { manager.lookup(hw_cmd.id); }));
+    results.push_back(run_benchmark(command_case.id + "/dispatch", iterations, [&]() {
+      manager.dispatch(hw_cmd);
+      manager.wait_for_io_reset(hw_cmd.device);
+    }));
+  }
+
+  std::cout << std::left << std::setw(32) << "benchmark" << std::right << std::setw(14) << "calls/s" << std::setw(12)
+            << "p50 [ns]" << std::setw(12) << "p99 [ns]" << std::setw(12) << "allocs" << std::endl;
+  for (auto& result : results) {
+    std::cout << std::left << std::setw(32) << result.name << std::right << std::fixed << std::setprecision(0)
+              << std::setw(14) << result.calls_per_second << std::setw(12) << result.p50_ns << std::setw(12)
+              << result.p99_ns << std::setw(12) << std::setprecision(2) << result.allocations_per_call << std::endl;
+  }
+
+  if (!report_file.empty()) {
+    nlohmann::json report = nlohmann::json::array();
+    for (auto& result : results) {
+      report.push_back({ { "name", result.name },
+                         { "iterations", result.iterations },
+                         { "calls_per_second", result.calls_per_second },
+                         { "p50_ns", result.p50_ns },
+                         { "p99_ns", result.p99_ns },
+                         { "allocations_per_call", result.allocations_per_call } });
+    }
+    std::ofstream(report_file) << report.dump(2) << std::endl;
+  }
+
+  return 0;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
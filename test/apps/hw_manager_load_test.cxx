@@ -0,0 +1,331 @@
+/**
+ * @file hw_manager_load_test.cxx
+ *
+ * Load test of a single hardware manager, on a fake device backend, serving
+ * N synthetic controllers. Each controller is a thread sending hardware
+ * commands, drawn from its command mix, at its rate, to an in-process
+ * iomanager queue connection; the manager handles them with its own receiver
+ * callback, as after conf.
+ *
+ * The rates and command mixes are assigned to the controllers in turn, so
+ * that e.g. a few fast controllers can be mixed with many slow ones. Each
+ * controller has a device of its own, or with --devices the controllers
+ * share that many devices, so that their commands wait for the io resets
+ * sent by the others.
+ *
+ * For each number of controllers the test reports throughput, queueing plus
+ * processing latency percentiles and the sends which timed out on a full
+ * queue. A command is handled once the receiver callback returns, or for an
+ * io reset once its reset thread is done, so that the resets still overlap
+ * as in the manager.
+ *
+ * Usage: timinglibs_hw_manager_load_test [--controllers 1,10,100,300]
+ *          [--rate <commands/s per controller>,...] [--duration <s>]
+ *          [--mix <id>:<weight>,...[;<id>:<weight>,...]] [--devices <n>]
+ *          [--latency <backend us>] [--queue-capacity <n>]
+ *          [--send-timeout <ms>] [--report <json file>]
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "FakeBackendHardwareManager.hpp"
+
+#include "timinglibs/timingcmd/Structs.hpp"
+#include "timinglibs/timingcmd/msgp.hpp"
+
+#include "iomanager/IOManager.hpp"
+#include "iomanager/Sender.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+using CommandMix = std::vector<std::pair<std::string, double>>;
+
+struct LoadTestConfig
+{
+  std::vector<size_t> controller_counts{ 1, 10, 100, 300 };
+  // assigned to the controllers in turn
+  std::vector<double> rates_hz{ 100. };
+  std::vector<CommandMix> command_mixes{ { { "endpoint_enable", 4. },
+                                           { "endpoint_disable", 2. },
+                                           { "endpoint_reset", 1. },
+                                           { "set_endpoint_delay", 1. },
+                                           { "send_fl_command", 1. },
+                                           { "io_reset", 1. } } };
+  double duration_s = 5.;
+  size_t devices = 0; ///< shared by the controllers; 0 for a device per controller
+  std::chrono::microseconds backend_latency{ 100 };
+  size_t queue_capacity = 1000;
+  std::chrono::milliseconds send_timeout{ 10 };
+  std::string report_file;
+};
+
+struct LoadTestResult
+{
+  size_t controllers;
+  uint64_t sent;      // NOLINT(build/unsigned)
+  uint64_t timed_out; // NOLINT(build/unsigned)
+  uint64_t processed; // NOLINT(build/unsigned)
+  double offered_rate;
+  double throughput;
+  double p50_us;
+  double p99_us;
+  double p999_us;
+  double max_us;
+};
+
+// the send time travels with the command, in its payload, which the handlers ignore
+const std::string s_send_time_key = "load_test_send_time_ns";
+
+LoadTestResult
+run_load_test(const LoadTestConfig& config, size_t number_of_controllers)
+{
+  using clock = std::chrono::steady_clock;
+
+  auto connection = "load_test_cmds_" + std::to_string(number_of_controllers);
+  iomanager::IOManager::get()->add_queue<timingcmd::TimingHwCmd>(connection, config.queue_capacity, "kFollyMPMCQueue");
+
+  std::atomic<bool> sending{ true };
+  std::atomic<uint64_t> sent{ 0 };      // NOLINT(build/unsigned)
+  std::atomic<uint64_t> timed_out{ 0 }; // NOLINT(build/unsigned)
+
+  double offered_rate = 0.;
+  for (size_t i = 0; i < number_of_controllers; ++i) {
+    offered_rate += config.rates_hz.at(i % config.rates_hz.size());
+  }
+
+  // handled on the receiver callback thread, and on the io reset threads
+  std::vector<int64_t> latencies;
+  latencies.reserve(static_cast<size_t>(offered_rate * config.duration_s * 1.1) + 1);
+  std::mutex latencies_mutex;
+  std::atomic<uint64_t> processed{ 0 }; // NOLINT(build/unsigned)
+
+  FakeBackendHardwareManager manager("load_test_thi", config.backend_latency);
+  manager.set_handled_callback([&](const timingcmd::TimingHwCmd& hw_cmd) {
+    auto handled = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+    auto latency = handled - hw_cmd.payload.at(s_send_time_key).get<int64_t>();
+    {
+      std::lock_guard<std::mutex> latencies_lock(latencies_mutex);
+      latencies.push_back(latency);
+    }
+    ++processed;
+  });
+  manager.start_receiving(connection);
+
+  std::vector<std::thread> controllers;
+  for (size_t i = 0; i < number_of_controllers; ++i) {
+    controllers.emplace_back([&, i]() {
+      auto rate_hz = config.rates_hz.at(i % config.rates_hz.size());
+      auto& command_mix = config.command_mixes.at(i % config.command_mixes.size());
+      std::vector<double> weights;
+      for (auto& [id, weight] : command_mix) {
+        weights.push_back(weight);
+      }
+      std::mt19937 generator(i);
+      std::discrete_distribution<size_t> command_choice(weights.begin(), weights.end());
+      auto device = "LOAD_TEST_DEVICE_" + std::to_string(config.devices ? i % config.devices : i);
+
+      auto sender = iomanager::IOManager::get()->get_sender<timingcmd::TimingHwCmd>(connection);
+
+      // stagger the controllers across one send interval
+      auto send_interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1. / rate_hz));
+      auto next_send = clock::now() + send_interval * i / number_of_controllers;
+
+      while (sending.load()) {
+        std::this_thread::sleep_until(next_send);
+        next_send += send_interval;
+
+        auto& hw_cmd_id = command_mix.at(command_choice(generator)).first;
+        timingcmd::TimingHwCmd hw_cmd;
+        hw_cmd.id = hw_cmd_id;
+        hw_cmd.device = device;
+        hw_cmd.payload = make_hw_cmd_payload(hw_cmd_id, static_cast<uint32_t>(i)); // NOLINT(build/unsigned)
+        hw_cmd.payload[s_send_time_key] =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+
+        ++sent;
+        try {
+          sender->send(std::move(hw_cmd), config.send_timeout);
+        } catch (const iomanager::TimeoutExpired&) {
+          ++timed_out;
+        }
+      }
+    });
+  }
+
+  auto start = clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(config.duration_s));
+  sending = false;
+  for (auto& controller : controllers) {
+    controller.join();
+  }
+
+  // drain the queue and the io resets in flight, within a grace period
+  auto drain_deadline = clock::now() + std::chrono::seconds(10);
+  while (processed.load() + timed_out.load() < sent.load() && clock::now() < drain_deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(clock::now() - start).count();
+  manager.stop_receiving();
+  manager.wait_for_io_resets();
+
+  std::lock_guard<std::mutex> latencies_lock(latencies_mutex);
+  auto percentile = [&latencies](double fraction) {
+    if (latencies.empty()) {
+      return 0.;
+    }
+    auto nth = latencies.begin() + static_cast<int64_t>(fraction * static_cast<double>(latencies.size() - 1));
+    std::nth_element(latencies.begin(), nth, latencies.end());
+    return static_cast<double>(*nth) / 1e3;
+  };
+
+  LoadTestResult result;
+  result.controllers = number_of_controllers;
+  result.sent = sent.load();
+  result.timed_out = timed_out.load();
+  result.processed = latencies.size();
+  result.offered_rate = offered_rate;
+  result.throughput = static_cast<double>(latencies.size()) / elapsed;
+  result.p50_us = percentile(0.5);
+  result.p99_us = percentile(0.99);
+  result.p999_us = percentile(0.999);
+  result.max_us = percentile(1.);
+  return result;
+}
+
+std::vector<std::string>
+split(const std::string& text, char delimiter)
+{
+  std::vector<std::string> tokens;
+  std::stringstream stream(text);
+  std::string token;
+  while (std::getline(stream, token, delimiter)) {
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+LoadTestConfig
+parse_arguments(int argc, char* argv[])
+{
+  LoadTestConfig config;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string option = argv[i];
+    std::string value = argv[i + 1];
+    if (option == "--controllers") {
+      config.controller_counts.clear();
+      for (auto& count : split(value, ',')) {
+        config.controller_counts.push_back(std::stoul(count));
+      }
+    } else if (option == "--rate") {
+      config.rates_hz.clear();
+      for (auto& rate : split(value, ',')) {
+        config.rates_hz.push_back(std::stod(rate));
+      }
+    } else if (option == "--duration") {
+      config.duration_s = std::stod(value);
+    } else if (option == "--mix") {
+      config.command_mixes.clear();
+      for (auto& mix : split(value, ';')) {
+        CommandMix command_mix;
+        for (auto& entry : split(mix, ',')) {
+          auto id_weight = split(entry, ':');
+          command_mix.emplace_back(id_weight.at(0), id_weight.size() > 1 ? std::stod(id_weight.at(1)) : 1.);
+        }
+        config.command_mixes.push_back(std::move(command_mix));
+      }
+    } else if (option == "--devices") {
+      config.devices = std::stoul(value);
+    } else if (option == "--latency") {
+      config.backend_latency = std::chrono::microseconds(std::stoul(value));
+    } else if (option == "--queue-capacity") {
+      config.queue_capacity = std::stoul(value);
+    } else if (option == "--send-timeout") {
+      config.send_timeout = std::chrono::milliseconds(std::stoul(value));
+    } else if (option == "--report") {
+      config.report_file = value;
+    } else {
+      throw std::invalid_argument("Unknown option: " + option);
+    }
+  }
+  return config;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+int
+main(int argc, char* argv[])
+{
+  using namespace dunedaq::timinglibs;
+
+  LoadTestConfig config;
+  try {
+    config = parse_arguments(argc, argv);
+  } catch (const std::exception& excpt) {
+    std::cerr << excpt.what() << std::endl;
+    return 1;
+  }
+
+  std::vector<LoadTestResult> results;
+  for (auto number_of_controllers : config.controller_counts) {
+    results.push_back(run_load_test(config, number_of_controllers));
+  }
+
+  std::cout << std::right << std::setw(12) << "controllers" << std::setw(10) << "sent" << std::setw(10) << "timeouts"
+            << std::setw(12) << "offered/s" << std::setw(12) << "handled/s" << std::setw(12) << "p50 [us]"
+            << std::setw(12) << "p99 [us]" << std::setw(12) << "p99.9 [us]" << std::setw(12) << "max [us]"
+            << std::endl;
+  for (auto& result : results) {
+    std::cout << std::fixed << std::setprecision(0) << std::setw(12) << result.controllers << std::setw(10)
+              << result.sent << std::setw(10) << result.timed_out << std::setw(12) << result.offered_rate
+              << std::setw(12) << result.throughput << std::setw(12) << result.p50_us << std::setw(12) << result.p99_us
+              << std::setw(12) << result.p999_us << std::setw(12) << result.max_us << std::endl;
+  }
+
+  if (!config.report_file.empty()) {
+    nlohmann::json report = nlohmann::json::array();
+    for (auto& result : results) {
+      report.push_back({ { "controllers", result.controllers },
+                         { "rates_hz", config.rates_hz },
+                         { "devices", config.devices },
+                         { "duration_s", config.duration_s },
+                         { "backend_latency_us", config.backend_latency.count() },
+                         { "sent", result.sent },
+                         { "timed_out", result.timed_out },
+                         { "processed", result.processed },
+                         { "offered_rate", result.offered_rate },
+                         { "throughput", result.throughput },
+                         { "p50_us", result.p50_us },
+                         { "p99_us", result.p99_us },
+                         { "p999_us", result.p999_us },
+                         { "max_us", result.max_us } });
+    }
+    std::ofstream(config.report_file) << report.dump(2) << std::endl;
+  }
+
+  return 0;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
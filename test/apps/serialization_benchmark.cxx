@@ -0,0 +1,297 @@
+/**
+ * @file serialization_benchmark.cxx
+ *
+ * Encode/decode throughput and encoded size of the timing command and
+ * monitoring messages, for the serialization formats available to them:
+ * the MsgPack transport of the serialization package (via the generated
+ * msgp.hpp), and JSON, MsgPack, CBOR, UBJSON and BSON via the generated
+ * Nljs.hpp. Every codec is checked to round-trip its message.
+ *
+ * Usage: timinglibs_serialization_benchmark [iterations] [json report file]
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "FakeDeviceBackend.hpp"
+
+#include "timinglibs/timingcmd/Nljs.hpp"
+#include "timinglibs/timingcmd/Structs.hpp"
+#include "timinglibs/timingcmd/msgp.hpp"
+
+#include "timing/timingfirmwareinfo/Nljs.hpp"
+#include "timing/timingfirmwareinfo/Structs.hpp"
+
+#include "serialization/Serialization.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace timinglibs {
+
+using bytes_t = std::vector<uint8_t>; // NOLINT(build/unsigned)
+
+template<typename T>
+struct Codec
+{
+  std::string name;
+  std::function<bytes_t(const T&)> encode;
+  std::function<T(const bytes_t&)> decode;
+};
+
+template<typename T>
+nlohmann::json
+as_json(const T& message)
+{
+  nlohmann::json json_message;
+  to_json(json_message, message);
+  return json_message;
+}
+
+template<typename T>
+T
+from_json_message(const nlohmann::json& json_message)
+{
+  T message;
+  from_json(json_message, message);
+  return message;
+}
+
+/**
+ * @brief Formats provided by nlohmann::json, on top of the generated Nljs.hpp
+ */
+template<typename T>
+std::vector<Codec<T>>
+nljs_codecs()
+{
+  return {
+    { "json",
+      [](const T& m) {
+        auto text = as_json(m).dump();
+        return bytes_t(text.begin(), text.end());
+      },
+      [](const bytes_t& b) { return from_json_message<T>(nlohmann::json::parse(b.begin(), b.end())); } },
+    { "nljs_msgpack",
+      [](const T& m) { return nlohmann::json::to_msgpack(as_json(m)); },
+      [](const bytes_t& b) { return from_json_message<T>(nlohmann::json::from_msgpack(b)); } },
+    { "nljs_cbor",
+      [](const T& m) { return nlohmann::json::to_cbor(as_json(m)); },
+      [](const bytes_t& b) { return from_json_message<T>(nlohmann::json::from_cbor(b)); } },
+    { "nljs_ubjson",
+      [](const T& m) { return nlohmann::json::to_ubjson(as_json(m)); },
+      [](const bytes_t& b) { return from_json_message<T>(nlohmann::json::from_ubjson(b)); } },
+    { "nljs_bson",
+      [](const T& m) { return nlohmann::json::to_bson(as_json(m)); },
+      [](const bytes_t& b) { return from_json_message<T>(nlohmann::json::from_bson(b)); } },
+  };
+}
+
+/**
+ * @brief Transport used by iomanager for the timingcmd structs (msgp.hpp)
+ */
+template<typename T>
+Codec<T>
+msgp_codec()
+{
+  return { "msgpack",
+           [](const T& m) { return serialization::serialize(m, serialization::kMsgPack); },
+           [](const bytes_t& b) { return serialization::deserialize<T>(b); } };
+}
+
+/**
+ * @brief Transport used by iomanager for the monitoring data, which is sent as nlohmann::json
+ */
+template<typename T>
+Codec<T>
+msgp_json_codec()
+{
+  return { "msgpack",
+           [](const T& m) { return serialization::serialize(as_json(m), serialization::kMsgPack); },
+           [](const bytes_t& b) { return from_json_message<T>(serialization::deserialize<nlohmann::json>(b)); } };
+}
+
+struct BenchmarkResult
+{
+  std::string message;
+  std::string codec;
+  size_t encoded_size;
+  double encodes_per_second;
+  double decodes_per_second;
+  double encode_mb_per_second;
+  double decode_mb_per_second;
+  bool round_trip_ok;
+};
+
+template<typename T>
+BenchmarkResult
+run_benchmark(const std::string& message_name, const T& message, const Codec<T>& codec, uint64_t iterations) // NOLINT(build/unsigned)
+{
+  using clock = std::chrono::steady_clock;
+  auto seconds = [](clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+  };
+
+  size_t total_size = 0;
+  auto start = clock::now();
+  for (uint64_t i = 0; i < iterations; ++i) { // NOLINT(build/unsigned)
+    total_size += codec.encode(message).size();
+  }
+  auto encode_time = seconds(clock::now() - start);
+
+  auto encoded = codec.encode(message);
+  T decoded;
+  start = clock::now();
+  for (uint64_t i = 0; i < iterations; ++i) { // NOLINT(build/unsigned)
+    decoded = codec.decode(encoded);
+  }
+  auto decode_time = seconds(clock::now() - start);
+
+  BenchmarkResult result;
+  result.message = message_name;
+  result.codec = codec.name;
+  result.encoded_size = encoded.size();
+  result.encodes_per_second = static_cast<double>(iterations) / encode_time;
+  result.decodes_per_second = static_cast<double>(iterations) / decode_time;
+  result.encode_mb_per_second = static_cast<double>(total_size) / encode_time / 1e6;
+  result.decode_mb_per_second = static_cast<double>(encoded.size() * iterations) / decode_time / 1e6;
+  result.round_trip_ok = as_json(decoded) == as_json(message);
+  return result;
+}
+
+template<typename T>
+void
+run_benchmarks(const std::string& message_name,
+               const T& message,
+               std::vector<Codec<T>> codecs,
+               uint64_t iterations, // NOLINT(build/unsigned)
+               std::vector<BenchmarkResult>& results)
+{
+  for (auto& codec : codecs) {
+    results.push_back(run_benchmark(message_name, message, codec, iterations));
+  }
+}
+
+timingcmd::TimingMasterEndpointScanPayload
+make_scan_payload(size_t number_of_endpoints)
+{
+  timingcmd::TimingMasterEndpointScanPayload scan_payload;
+  for (size_t i = 0; i < number_of_endpoints; ++i) {
+    timingcmd::EndpointLocation location;
+    location.fanout_slot = static_cast<int>(i / 8);
+    location.sfp_slot = static_cast<int>(i % 8);
+    location.address = static_cast<uint32_t>(i); // NOLINT(build/unsigned)
+    scan_payload.endpoints.push_back(location);
+  }
+  return scan_payload;
+}
+
+timing::timingfirmwareinfo::TimingDeviceInfo
+make_device_info()
+{
+  // a synchronised master with a locked endpoint, as simulated by the fake backend
+  FakeDeviceBackend backend;
+
+  timingcmd::IOResetCmdPayload io_reset;
+  io_reset.clock_source = 0;
+  io_reset.soft = false;
+  backend.io_reset("BENCHMARK_DEVICE", io_reset);
+  backend.sync_timestamp("BENCHMARK_DEVICE", 1);
+
+  timingcmd::TimingEndpointConfigureCmdPayload endpoint_configure;
+  endpoint_configure.endpoint_id = 0;
+  endpoint_configure.address = 1;
+  endpoint_configure.partition = 0;
+  backend.endpoint_enable("BENCHMARK_DEVICE", endpoint_configure);
+
+  timing::timingfirmwareinfo::TimingDeviceInfo info;
+  backend.get_info("BENCHMARK_DEVICE", info);
+  return info;
+}
+
+} // namespace timinglibs
+} // namespace dunedaq
+
+int
+main(int argc, char* argv[])
+{
+  using namespace dunedaq::timinglibs;
+
+  uint64_t iterations = argc > 1 ? std::stoull(argv[1]) : 100000; // NOLINT(build/unsigned)
+  std::string report_file = argc > 2 ? argv[2] : "";
+
+  std::vector<BenchmarkResult> results;
+
+  timingcmd::IOResetCmdPayload io_reset;
+  io_reset.clock_source = 0;
+  io_reset.soft = false;
+  io_reset.clock_config = "";
+  timingcmd::TimingHwCmd io_reset_cmd;
+  io_reset_cmd.id = "io_reset";
+  io_reset_cmd.device = "BENCHMARK_DEVICE";
+  timingcmd::to_json(io_reset_cmd.payload, io_reset);
+
+  auto scan_payload = make_scan_payload(64);
+  timingcmd::TimingHwCmd scan_cmd;
+  scan_cmd.id = "master_endpoint_scan";
+  scan_cmd.device = "BENCHMARK_DEVICE";
+  timingcmd::to_json(scan_cmd.payload, scan_payload);
+
+  auto hw_cmd_codecs = nljs_codecs<timingcmd::TimingHwCmd>();
+  hw_cmd_codecs.insert(hw_cmd_codecs.begin(), msgp_codec<timingcmd::TimingHwCmd>());
+  run_benchmarks("TimingHwCmd/io_reset", io_reset_cmd, hw_cmd_codecs, iterations, results);
+  run_benchmarks("TimingHwCmd/master_endpoint_scan", scan_cmd, hw_cmd_codecs, iterations, results);
+
+  auto scan_codecs = nljs_codecs<timingcmd::TimingMasterEndpointScanPayload>();
+  scan_codecs.insert(scan_codecs.begin(), msgp_codec<timingcmd::TimingMasterEndpointScanPayload>());
+  run_benchmarks("TimingMasterEndpointScanPayload", scan_payload, scan_codecs, iterations, results);
+
+  using dunedaq::timing::timingfirmwareinfo::TimingDeviceInfo;
+  auto info_codecs = nljs_codecs<TimingDeviceInfo>();
+  info_codecs.insert(info_codecs.begin(), msgp_json_codec<TimingDeviceInfo>());
+  run_benchmarks("TimingDeviceInfo", make_device_info(), info_codecs, iterations, results);
+
+  std::cout << std::left << std::setw(36) << "message" << std::setw(14) << "codec" << std::right << std::setw(8)
+            << "bytes" << std::setw(12) << "enc/s" << std::setw(12) << "dec/s" << std::setw(10) << "enc MB/s"
+            << std::setw(10) << "dec MB/s" << std::setw(6) << "ok" << std::endl;
+  bool all_ok = true;
+  for (auto& result : results) {
+    std::cout << std::left << std::setw(36) << result.message << std::setw(14) << result.codec << std::right
+              << std::fixed << std::setprecision(0) << std::setw(8) << result.encoded_size << std::setw(12)
+              << result.encodes_per_second << std::setw(12) << result.decodes_per_second << std::setprecision(1)
+              << std::setw(10) << result.encode_mb_per_second << std::setw(10) << result.decode_mb_per_second
+              << std::setw(6) << (result.round_trip_ok ? "yes" : "NO") << std::endl;
+    all_ok = all_ok && result.round_trip_ok;
+  }
+
+  if (!report_file.empty()) {
+    nlohmann::json report = nlohmann::json::array();
+    for (auto& result : results) {
+      report.push_back({ { "message", result.message },
+                         { "codec", result.codec },
+                         { "iterations", iterations },
+                         { "encoded_size", result.encoded_size },
+                         { "encodes_per_second", result.encodes_per_second },
+                         { "decodes_per_second", result.decodes_per_second },
+                         { "encode_mb_per_second", result.encode_mb_per_second },
+                         { "decode_mb_per_second", result.decode_mb_per_second },
+                         { "round_trip_ok", result.round_trip_ok } });
+    }
+    std::ofstream(report_file) << report.dump(2) << std::endl;
+  }
+
+  return all_ok ? 0 : 1;
+}
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
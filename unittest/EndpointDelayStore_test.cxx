@@ -0,0 +1,112 @@
+/**
+ * @file EndpointDelayStore_test.cxx EndpointDelayStore unit tests
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "../src/EndpointDelayStore.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#define BOOST_TEST_MODULE EndpointDelayStore_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+using namespace dunedaq::timinglibs;
+
+BOOST_AUTO_TEST_SUITE(EndpointDelayStore_test)
+
+namespace {
+
+std::string
+temporary_path()
+{
+  char path_template[] = "/tmp/timinglibs_endpoint_delays_XXXXXX";
+  int fd = ::mkstemp(path_template);
+  ::close(fd);
+  // an empty file is a new store
+  return path_template;
+}
+
+timingcmd::TimingMasterSetEndpointDelayCmdPayload
+make_delay(uint32_t address, uint32_t coarse_delay) // NOLINT(build/unsigned)
+{
+  timingcmd::TimingMasterSetEndpointDelayCmdPayload delay;
+  delay.address = address;
+  delay.coarse_delay = coarse_delay;
+  delay.fine_delay = 0;
+  delay.phase_delay = 0;
+  delay.measure_rtt = false;
+  delay.control_sfp = true;
+  delay.sfp_mux = -1;
+  return delay;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(StoreAndReload)
+{
+  auto path = temporary_path();
+  {
+    EndpointDelayStore store(path, 1);
+    store.store(make_delay(1, 10));
+    store.store(make_delay(2, 20));
+    store.store(make_delay(1, 11));
+    BOOST_REQUIRE_EQUAL(store.size(), 2);
+  }
+  {
+    EndpointDelayStore store(path);
+    auto delays = store.get_delays();
+    BOOST_REQUIRE_EQUAL(delays.size(), 2);
+    BOOST_REQUIRE_EQUAL(delays.at(0).address, 1);
+    BOOST_REQUIRE_EQUAL(delays.at(0).coarse_delay, 11);
+    BOOST_REQUIRE_EQUAL(delays.at(1).address, 2);
+  }
+  ::unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(FailedGrowKeepsDelays)
+{
+  auto path = temporary_path();
+  {
+    EndpointDelayStore store(path, 1);
+    store.store(make_delay(1, 10));
+
+    // the store file cannot grow to two endpoints
+    struct rlimit previous_limit;
+    ::getrlimit(RLIMIT_FSIZE, &previous_limit);
+    auto previous_handler = std::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit limit = previous_limit;
+    limit.rlim_cur = sizeof(EndpointDelayFileHeader) + sizeof(EndpointDelayEntry);
+    ::setrlimit(RLIMIT_FSIZE, &limit);
+
+    BOOST_CHECK_THROW(store.store(make_delay(2, 20)), MappedFileIssue);
+
+    ::setrlimit(RLIMIT_FSIZE, &previous_limit);
+    std::signal(SIGXFSZ, previous_handler);
+
+    BOOST_REQUIRE_EQUAL(store.size(), 1);
+    store.store(make_delay(1, 11));
+    BOOST_REQUIRE_EQUAL(store.get_delays().at(0).coarse_delay, 11);
+
+    store.store(make_delay(2, 20));
+    BOOST_REQUIRE_EQUAL(store.size(), 2);
+  }
+  ::unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
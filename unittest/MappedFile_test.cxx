@@ -0,0 +1,135 @@
+/**
+ * @file MappedFile_test.cxx MappedFile unit tests
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "../src/MappedFile.hpp"
+
+#include "timinglibs/TimingIssues.hpp"
+
+#define BOOST_TEST_MODULE MappedFile_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace dunedaq::timinglibs;
+
+BOOST_AUTO_TEST_SUITE(MappedFile_test)
+
+namespace {
+
+std::string
+temporary_path()
+{
+  char path_template[] = "/tmp/timinglibs_mapped_file_XXXXXX";
+  int fd = ::mkstemp(path_template);
+  ::close(fd);
+  return path_template;
+}
+
+// files cannot grow beyond limit bytes while in scope
+struct FileSizeLimit
+{
+  explicit FileSizeLimit(size_t limit)
+  {
+    ::getrlimit(RLIMIT_FSIZE, &previous_limit);
+    previous_handler = std::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit new_limit = previous_limit;
+    new_limit.rlim_cur = limit;
+    ::setrlimit(RLIMIT_FSIZE, &new_limit);
+  }
+
+  ~FileSizeLimit()
+  {
+    ::setrlimit(RLIMIT_FSIZE, &previous_limit);
+    std::signal(SIGXFSZ, previous_handler);
+  }
+
+  struct rlimit previous_limit;
+  void (*previous_handler)(int);
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Grow)
+{
+  auto path = temporary_path();
+  {
+    MappedFile file(path, MappedFile::Access::kReadWrite);
+    file.map(4096);
+    std::memset(file.get_data(), 0xab, 4096);
+
+    file.map(2 * 4096);
+    BOOST_REQUIRE_EQUAL(file.get_mapped_size(), 2 * 4096);
+    BOOST_REQUIRE_EQUAL(file.get_file_size(), 2 * 4096);
+    BOOST_REQUIRE_EQUAL(file.get_data()[4095], 0xab);
+  }
+  ::unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(FailedGrowKeepsMapping)
+{
+  auto path = temporary_path();
+  {
+    MappedFile file(path, MappedFile::Access::kReadWrite);
+    file.map(4096);
+    std::memset(file.get_data(), 0xab, 4096);
+    auto data = file.get_data();
+
+    {
+      FileSizeLimit limit(2 * 4096);
+      BOOST_REQUIRE_THROW(file.map(4 * 4096), MappedFileIssue);
+    }
+
+    BOOST_REQUIRE(file.get_data() == data);
+    BOOST_REQUIRE_EQUAL(file.get_mapped_size(), 4096);
+    BOOST_REQUIRE_EQUAL(file.get_file_size(), 4096);
+    BOOST_REQUIRE_EQUAL(file.get_data()[4095], 0xab);
+    file.get_data()[0] = 0xcd;
+
+    // the file can still grow once the cause of the failure is gone
+    file.map(4 * 4096);
+    BOOST_REQUIRE_EQUAL(file.get_data()[0], 0xcd);
+  }
+  ::unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(FailedMapKeepsMapping)
+{
+  auto path = temporary_path();
+  {
+    MappedFile writer(path, MappedFile::Access::kReadWrite);
+    writer.map(4096);
+    std::memset(writer.get_data(), 0xab, 4096);
+    writer.sync(true);
+
+    MappedFile reader(path, MappedFile::Access::kReadOnly);
+    reader.map(4096);
+    auto data = reader.get_data();
+
+    // larger than any address space
+    BOOST_REQUIRE_THROW(reader.map(size_t(1) << 62), MappedFileIssue);
+
+    BOOST_REQUIRE(reader.get_data() == data);
+    BOOST_REQUIRE_EQUAL(reader.get_mapped_size(), 4096);
+    BOOST_REQUIRE_EQUAL(reader.get_data()[4095], 0xab);
+  }
+  ::unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Local Variables:
+// c-basic-offset: 2
+// End:
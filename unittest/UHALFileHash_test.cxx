@@ -0,0 +1,100 @@
+/**
+ * @file UHALFileHash_test.cxx UHALFileHash unit tests
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "../src/UHALFileHash.hpp"
+
+#define BOOST_TEST_MODULE UHALFileHash_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <string>
+
+using namespace dunedaq::timinglibs;
+
+BOOST_AUTO_TEST_SUITE(UHALFileHash_test)
+
+namespace {
+
+struct UHALFiles
+{
+  UHALFiles()
+  {
+    char directory_template[] = "/tmp/timinglibs_uhal_file_hash_XXXXXX";
+    directory = ::mkdtemp(directory_template);
+    ::setenv("TIMINGLIBS_TEST_ADDRESS_TABLES", directory.c_str(), 1);
+    write(connections_file(),
+          R"(<connections><connection id="dev" uri="ipbusudp-2.0://127.0.0.1:50001" )"
+          R"(address_table="file://${TIMINGLIBS_TEST_ADDRESS_TABLES}/top.xml"/></connections>)");
+    write(directory + "/top.xml", R"(<node id="top"><node id="csr" address="0x0"/></node>)");
+  }
+
+  ~UHALFiles()
+  {
+    ::unlink(connections_file().c_str());
+    ::unlink((directory + "/top.xml").c_str());
+    ::rmdir(directory.c_str());
+    ::unsetenv("TIMINGLIBS_TEST_ADDRESS_TABLES");
+  }
+
+  static void write(const std::string& path, const std::string& content)
+  {
+    std::ofstream file(path, std::ios::trunc);
+    file << content;
+  }
+
+  std::string connections_file() const { return directory + "/connections.xml"; }
+
+  uint64_t hash() const // NOLINT(build/unsigned)
+  {
+    std::set<std::string> hashed_paths;
+    return hash_uhal_file(connections_file(), fnv1a_hash(""), hashed_paths);
+  }
+
+  std::string directory;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ResolveEnvironmentVariables)
+{
+  ::setenv("TIMINGLIBS_TEST_VARIABLE", "/opt/timing", 1);
+  std::string path = "${TIMINGLIBS_TEST_VARIABLE}/tables/${TIMINGLIBS_TEST_UNSET_VARIABLE}top.xml";
+  ::unsetenv("TIMINGLIBS_TEST_UNSET_VARIABLE");
+  resolve_environment_variables(path);
+  BOOST_REQUIRE_EQUAL(path, "/opt/timing/tables/top.xml");
+  ::unsetenv("TIMINGLIBS_TEST_VARIABLE");
+}
+
+BOOST_AUTO_TEST_CASE(EnvironmentVariableReferenceIsHashed)
+{
+  UHALFiles files;
+
+  std::set<std::string> hashed_paths;
+  hash_uhal_file(files.connections_file(), fnv1a_hash(""), hashed_paths);
+  BOOST_REQUIRE_EQUAL(hashed_paths.size(), 2);
+  BOOST_REQUIRE(hashed_paths.count(files.directory + "/top.xml"));
+
+  auto initial_hash = files.hash();
+  BOOST_REQUIRE_EQUAL(files.hash(), initial_hash);
+
+  // an address table edited in place, behind the environment variable
+  UHALFiles::write(files.directory + "/top.xml", R"(<node id="top"><node id="csr" address="0x1"/></node>)");
+  BOOST_REQUIRE_NE(files.hash(), initial_hash);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// Local Variables:
+// c-basic-offset: 2
+// End: